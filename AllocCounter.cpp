@@ -0,0 +1,136 @@
+/**
+*@file AllocCounter.cpp
+*@brief Replacement of the global allocation functions that counts every call.
+*@brief The counters are relaxed atomics: one add next to a malloc call. The replacement is only
+*@brief compiled with -DLANE_ALLOC_CHECK (make ALLOC_CHECK=1); other builds keep the normal allocator.
+*/
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <opencv2/opencv.hpp>
+#include "AllocCounter.h"
+
+namespace {
+
+std::atomic<uint64_t> alloc_count(0);
+std::atomic<uint64_t> alloc_bytes(0);
+
+void* countedAlloc(std::size_t size)
+{
+    alloc_count.fetch_add(1, std::memory_order_relaxed);
+    alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* countedAllocOrThrow(std::size_t size)
+{
+    void* p = countedAlloc(size);
+    while (p == nullptr) {
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr)
+            throw std::bad_alloc();
+        handler();
+        p = std::malloc(size == 0 ? 1 : size);
+    }
+    return p;
+}
+
+// Forwards to OpenCV's standard allocator; the UMatData it returns keeps the standard
+// allocator as owner, so deallocation does not pass through here
+class CountingMatAllocator : public cv::MatAllocator
+{
+public:
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const
+    {
+        if (data == nullptr) {
+            size_t total = CV_ELEM_SIZE(type);
+            for (int i = 0; i < dims; i++)
+                total *= sizes[i];
+            alloc_count.fetch_add(1, std::memory_order_relaxed);
+            alloc_bytes.fetch_add(total, std::memory_order_relaxed);
+        }
+        return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usageFlags);
+    }
+
+    bool allocate(cv::UMatData* data, cv::AccessFlag accessflags, cv::UMatUsageFlags usageFlags) const
+    {
+        return cv::Mat::getStdAllocator()->allocate(data, accessflags, usageFlags);
+    }
+
+    void deallocate(cv::UMatData* data) const
+    {
+        cv::Mat::getStdAllocator()->deallocate(data);
+    }
+};
+
+} // namespace
+
+void AllocCounter::installMatAllocator()
+{
+    static CountingMatAllocator allocator;
+    cv::Mat::setDefaultAllocator(&allocator);
+}
+
+uint64_t AllocCounter::allocations()
+{
+    return alloc_count.load(std::memory_order_relaxed);
+}
+
+uint64_t AllocCounter::bytes()
+{
+    return alloc_bytes.load(std::memory_order_relaxed);
+}
+
+bool AllocCounter::countsOperatorNew()
+{
+#ifdef LANE_ALLOC_CHECK
+    return true;
+#else
+    return false;
+#endif
+}
+
+#ifdef LANE_ALLOC_CHECK
+
+void* operator new(std::size_t size)
+{
+    return countedAllocOrThrow(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return countedAllocOrThrow(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return countedAlloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return countedAlloc(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+    std::free(p);
+}
+
+#endif // LANE_ALLOC_CHECK
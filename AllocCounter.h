@@ -0,0 +1,40 @@
+/**
+*@file AllocCounter.h
+*@brief Process-wide heap allocation counter used by the steady-state allocation check in main.
+*@brief Built with -DLANE_ALLOC_CHECK (make ALLOC_CHECK=1), AllocCounter.cpp replaces the global
+*@brief operator new/delete, which counts every std::vector, std::string and other C++ allocation;
+*@brief without it only cv::Mat buffers are counted. cv::Mat buffers bypass operator new
+*@brief (cv::fastMalloc), so installMatAllocator() wraps OpenCV's default MatAllocator to count them.
+*/
+#ifndef ALLOC_COUNTER_H
+#define ALLOC_COUNTER_H
+
+#include <cstdint>
+
+class AllocCounter
+{
+public:
+	// Number of operator new calls since program start, on all threads
+	static uint64_t allocations();
+	// Bytes requested by those calls
+	static uint64_t bytes();
+
+	// Count cv::Mat data allocations too, from the next allocation on
+	static void installMatAllocator();
+
+	// Whether operator new is counted, i.e. the build defines LANE_ALLOC_CHECK
+	static bool countsOperatorNew();
+};
+
+// Allocations made between construction and count()
+class AllocScope
+{
+public:
+	AllocScope() : start(AllocCounter::allocations()) {}
+	uint64_t count() const { return AllocCounter::allocations() - start; }
+
+private:
+	uint64_t start;
+};
+
+#endif // ALLOC_COUNTER_H
@@ -0,0 +1,277 @@
+/**
+*@file BatchRunner.cpp
+*@brief One task per input video on the shared work-stealing pool.
+*/
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <cerrno>
+#include <sys/stat.h>
+#include <opencv2/opencv.hpp>
+#include "BatchRunner.h"
+#include "ThreadPool.h"
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+std::mutex print_lock;   // Keeps the per-stream progress lines whole
+
+double msSince(Clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+// File name without directory and extension
+std::string stem(const std::string& path)
+{
+    size_t slash = path.find_last_of('/');
+    std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+    size_t dot = name.find_last_of('.');
+    return dot == std::string::npos || dot == 0 ? name : name.substr(0, dot);
+}
+
+} // namespace
+
+void StreamSettings::apply(LaneDetector& detector) const
+{
+    detector.setConfig(config);
+    detector.setRoiMode(roi);
+    detector.setScale(scale);
+    detector.setFrameThreads(frame_threads);
+    detector.setBitmapMode(bitmap);
+    detector.setTrackingMode(track);
+    detector.setHoughMode(hough);
+    detector.setFitMode(fit);
+    detector.setPlotMode(plot);
+    detector.edgeKernel().setIsa(isa);
+}
+
+bool readManifest(const std::string& path, std::vector<std::string>& inputs)
+{
+    std::ifstream in(path.c_str());
+    if (!in)
+        return false;
+
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t begin = line.find_first_not_of(" \t\r");
+        if (begin == std::string::npos || line[begin] == '#')
+            continue;
+        size_t end = line.find_last_not_of(" \t\r");
+        inputs.push_back(line.substr(begin, end - begin + 1));
+    }
+    return true;
+}
+
+BatchRunner::BatchRunner(const StreamSettings& settings, const DetectOptions& options,
+                         const OutputSelection& outputs, int threads, const std::string& output_dir)
+    : settings(settings), options(options), outputs(outputs), threads(threads), output_dir(output_dir), wall_ms(0.0), steals(0)
+{
+}
+
+/**
+*@brief Decode and detect one input video with its own LaneDetector and write its selected outputs
+*@param index is the stream's position in results
+*/
+void BatchRunner::processStream(int index)
+{
+    StreamResult& r = results[index];
+
+    // Y4M/GStreamer inputs and frame stores are detected on their buffers without a BGR conversion
+    bool raw_input = FrameSource::isRaw(r.input);
+    FrameSource source;
+    cv::VideoCapture cap;
+    if (raw_input ? !source.open(r.input) : !cap.open(r.input)) {
+        std::lock_guard<std::mutex> guard(print_lock);
+        std::cout << "无法打开输入视频: " << r.input << std::endl;
+        return;
+    }
+
+    int frame_width = raw_input ? source.size().width : static_cast<int>(cap.get(cv::CAP_PROP_FRAME_WIDTH));
+    int frame_height = raw_input ? source.size().height : static_cast<int>(cap.get(cv::CAP_PROP_FRAME_HEIGHT));
+    double fps = raw_input ? source.fps() : cap.get(cv::CAP_PROP_FPS);
+    cv::VideoWriter color_writer;
+    cv::VideoWriter bw_writer;
+    RecordWriter record_writer;
+    bool opened = true;
+    if (outputs.color_video)
+        opened &= color_writer.open(r.color_output, cv::VideoWriter::fourcc('M','J','P','G'), fps,
+                                    cv::Size(frame_width, frame_height));
+    if (outputs.edge_video)
+        opened &= bw_writer.open(r.edge_output, cv::VideoWriter::fourcc('M','J','P','G'), fps,
+                                 cv::Size(frame_width, frame_height));
+    if (outputs.records)
+        opened &= record_writer.open(r.record_output, outputs.record_format);
+    if (!opened) {
+        std::lock_guard<std::mutex> guard(print_lock);
+        std::cout << "无法创建输出文件: " << r.input << std::endl;
+        return;
+    }
+
+    LaneDetector detector;
+    settings.apply(detector);
+    if (raw_input && !adaptToSource(detector, source)) {
+        std::lock_guard<std::mutex> guard(print_lock);
+        std::cout << "帧存储的裁剪区域不包含当前配置的车道ROI: " << r.input << std::endl;
+        return;
+    }
+    cv::Mat frame;
+    cv::Mat edge_frame;
+    cv::Mat edge_bgr;
+    std::string turn;
+    LaneRecord record;
+
+    Clock::time_point t0 = Clock::now();
+    while (raw_input ? source.read() : cap.read(frame)) {
+        Clock::time_point t1 = Clock::now();
+        int flag_plot = raw_input ? detectFrame(detector, source, options, frame, edge_frame, edge_bgr, turn)
+                                  : detectFrame(detector, frame, options, edge_frame, edge_bgr, turn);
+        if (outputs.edge_video)
+            bw_writer.write(edge_bgr);
+        if (outputs.color_video)
+            color_writer.write(frame);
+        if (outputs.records) {
+            makeLaneRecord(detector, r.frames, fps, flag_plot == 0, turn, record);
+            record_writer.write(record);
+        }
+        frame_latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t1).count());
+
+        r.frames++;
+        if (flag_plot == 0)
+            r.lane_frames++;
+    }
+    r.wall_ms = msSince(t0);
+
+    for (int s = 0; s < STAGE_COUNT; s++)
+        r.stage_ms[s] = detector.performanceStats().averagePerFrameMs(static_cast<PerfStage>(s));
+    r.ok = true;
+
+    std::lock_guard<std::mutex> guard(print_lock);
+    std::cout << "完成 [" << index + 1 << "/" << results.size() << "] " << r.input << ": " << r.frames
+              << " 帧, " << (r.wall_ms > 0 ? r.frames * 1000.0 / r.wall_ms : 0.0) << " FPS" << std::endl;
+}
+
+int BatchRunner::run(const std::vector<std::string>& inputs)
+{
+    if (::mkdir(output_dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        std::cout << "无法创建输出目录: " << output_dir << std::endl;
+        return static_cast<int>(inputs.size());
+    }
+
+    results.assign(inputs.size(), StreamResult());
+    for (size_t i = 0; i < inputs.size(); i++) {
+        // The index prefix keeps clips with the same file name in different folders apart
+        std::ostringstream prefix;
+        prefix << output_dir << "/" << std::setw(4) << std::setfill('0') << i << "_" << stem(inputs[i]);
+        results[i].input = inputs[i];
+        results[i].color_output = prefix.str() + "_lane_detection_color.avi";
+        results[i].edge_output = prefix.str() + "_edge_detection_bw.avi";
+        results[i].record_output = prefix.str() + "_lanes" + RecordWriter::extension(outputs.record_format);
+    }
+    frame_latency.reset();
+
+    // With at least one stream per worker the streams already fill every core;
+    // OpenCV's own threads would only oversubscribe them
+    ThreadPool pool(threads);
+    int cv_threads = cv::getNumThreads();
+    if (static_cast<int>(inputs.size()) >= pool.size())
+        cv::setNumThreads(1);
+
+    Clock::time_point t0 = Clock::now();
+    for (size_t i = 0; i < inputs.size(); i++)
+        pool.submit([this, i] { processStream(static_cast<int>(i)); });
+    pool.wait();
+    wall_ms = msSince(t0);
+    threads = pool.size();
+    steals = pool.steals();
+    cv::setNumThreads(cv_threads);
+
+    int failed = 0;
+    for (const auto& r : results)
+        failed += r.ok ? 0 : 1;
+    return failed;
+}
+
+void BatchRunner::printReport() const
+{
+    long total_frames = 0;
+    long lane_frames = 0;
+    double stage_sum[STAGE_COUNT] = {};
+    for (const auto& r : results) {
+        total_frames += r.frames;
+        lane_frames += r.lane_frames;
+        for (int s = 0; s < STAGE_COUNT; s++)
+            stage_sum[s] += r.stage_ms[s] * r.frames;
+    }
+
+    std::cout << "\n==========================================" << std::endl;
+    std::cout << "批处理性能报告" << std::endl;
+    std::cout << "==========================================" << std::endl;
+    std::cout << "视频路数: " << results.size() << ", 工作线程: " << threads << ", 任务窃取: " << steals << " 次" << std::endl;
+    std::cout << "序号\t帧数\t检出帧\t耗时(ms)\tFPS\t输入" << std::endl;
+    for (size_t i = 0; i < results.size(); i++) {
+        const StreamResult& r = results[i];
+        std::cout << i << "\t" << r.frames << "\t" << r.lane_frames << "\t" << r.wall_ms << "\t\t"
+                  << (r.wall_ms > 0 ? r.frames * 1000.0 / r.wall_ms : 0.0) << "\t" << r.input
+                  << (r.ok ? "" : " (失败)") << std::endl;
+    }
+
+    std::cout << "\n总处理帧数: " << total_frames << " (检测到车道线 " << lane_frames << ")" << std::endl;
+    std::cout << "整体执行时间: " << wall_ms << " ms" << std::endl;
+    std::cout << "整体吞吐: " << (wall_ms > 0 ? total_frames * 1000.0 / wall_ms : 0.0) << " FPS" << std::endl;
+    std::cout << "单帧延迟(检测+输出): 平均 " << frame_latency.meanMs() << " ms, p50 " << frame_latency.percentileMs(50)
+              << " ms, p95 " << frame_latency.percentileMs(95) << " ms, p99 " << frame_latency.percentileMs(99)
+              << " ms, 最大 " << frame_latency.maxMs() << " ms" << std::endl;
+
+    std::cout << "\n模块平均执行时间(全部视频按帧加权):" << std::endl;
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        std::cout << (s + 1 < STAGE_COUNT ? "├── " : "└── ") << PerfStats::stageName(static_cast<PerfStage>(s)) << ": "
+                  << (total_frames > 0 ? stage_sum[s] / total_frames : 0.0) << " ms" << std::endl;
+    }
+    std::cout << "==========================================" << std::endl;
+}
+
+/**
+*@brief One CSV row per stream plus a "total" row with the aggregated throughput and latency
+*@param path is the output file
+*@return false if the file could not be written
+*/
+bool BatchRunner::writeCsv(const std::string& path) const
+{
+    std::ofstream out(path.c_str());
+    if (!out)
+        return false;
+
+    out << "stream,input,ok,frames,lane_frames,wall_ms,fps";
+    for (int s = 0; s < STAGE_COUNT; s++)
+        out << "," << PerfStats::stageName(static_cast<PerfStage>(s)) << "_ms";
+    out << ",p50_ms,p95_ms,p99_ms,max_ms\n";
+
+    long total_frames = 0;
+    long lane_frames = 0;
+    double stage_sum[STAGE_COUNT] = {};
+    for (size_t i = 0; i < results.size(); i++) {
+        const StreamResult& r = results[i];
+        out << i << "," << r.input << "," << (r.ok ? 1 : 0) << "," << r.frames << "," << r.lane_frames << ","
+            << r.wall_ms << "," << (r.wall_ms > 0 ? r.frames * 1000.0 / r.wall_ms : 0.0);
+        for (int s = 0; s < STAGE_COUNT; s++) {
+            out << "," << r.stage_ms[s];
+            stage_sum[s] += r.stage_ms[s] * r.frames;
+        }
+        out << ",,,,\n";
+        total_frames += r.frames;
+        lane_frames += r.lane_frames;
+    }
+
+    out << "total,," << results.size() << "," << total_frames << "," << lane_frames << "," << wall_ms << ","
+        << (wall_ms > 0 ? total_frames * 1000.0 / wall_ms : 0.0);
+    for (int s = 0; s < STAGE_COUNT; s++)
+        out << "," << (total_frames > 0 ? stage_sum[s] / total_frames : 0.0);
+    out << "," << frame_latency.percentileMs(50) << "," << frame_latency.percentileMs(95) << ","
+        << frame_latency.percentileMs(99) << "," << frame_latency.maxMs() << "\n";
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,75 @@
+/**
+*@file BatchRunner.h
+*@brief Batch mode: many input videos processed concurrently on a work-stealing thread pool.
+*@brief Every stream gets its own LaneDetector and output files; frame latencies of all
+*@brief streams go into one lock-free histogram for the aggregated report.
+*/
+#ifndef BATCH_RUNNER_H
+#define BATCH_RUNNER_H
+
+#include <string>
+#include <vector>
+#include "FramePipeline.h"
+#include "PerfStats.h"
+
+// Detector settings selected on the command line, applied to every stream's LaneDetector
+struct StreamSettings
+{
+	bool roi = false;
+	bool track = false;
+	LaneDetector::HoughMode hough = LaneDetector::HOUGH_OPENCV;
+	LaneDetector::FitMode fit = LaneDetector::FIT_LSQ;
+	LaneDetector::PlotMode plot = LaneDetector::PLOT_SPANS;
+	FusedEdgeKernel::Isa isa = FusedEdgeKernel::ISA_AUTO;
+	int scale = 1;                  // Coarse-to-fine factor, 1 is full resolution
+	int frame_threads = 0;          // Strip-parallel threads per stream, 0 is the serial path
+	bool bitmap = false;            // Packed 1-bit edge image
+	LaneDetectorConfig config;
+
+	void apply(LaneDetector& detector) const;
+};
+
+// Read input paths from a manifest: one per line, blank lines and lines starting with # ignored
+bool readManifest(const std::string& path, std::vector<std::string>& inputs);
+
+class BatchRunner
+{
+public:
+	BatchRunner(const StreamSettings& settings, const DetectOptions& options, const OutputSelection& outputs,
+	            int threads, const std::string& output_dir);
+
+	// Process every input; returns the number of streams that failed to open or write
+	int run(const std::vector<std::string>& inputs);
+
+	// Per-stream and aggregated throughput / latency
+	void printReport() const;
+	bool writeCsv(const std::string& path) const;
+
+private:
+	struct StreamResult
+	{
+		std::string input;
+		std::string color_output;
+		std::string edge_output;
+		std::string record_output;
+		bool ok = false;
+		int frames = 0;
+		int lane_frames = 0;            // Frames where a lane was plotted
+		double wall_ms = 0.0;
+		double stage_ms[STAGE_COUNT] = {};  // Average per-frame time of each stage
+	};
+
+	StreamSettings settings;
+	DetectOptions options;
+	OutputSelection outputs;
+	int threads;
+	std::string output_dir;
+	std::vector<StreamResult> results;
+	LatencyHistogram frame_latency;     // Detect + output time of every frame of every stream
+	double wall_ms;
+	long steals;
+
+	void processStream(int index);
+};
+
+#endif // BATCH_RUNNER_H
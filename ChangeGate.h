@@ -0,0 +1,67 @@
+/**
+*@file ChangeGate.h
+*@brief Change-detection gate: reuse the last result for frames that barely differ from it.
+*@brief A signature of the lane bounding box is sampled on a sparse grid (luma, or (B+2G+R)/4 of
+*@brief a BGR frame) and compared by mean absolute difference with the signature of the last
+*@brief frame that ran full detection. Below the threshold the previous lane and turn are reused;
+*@brief after max_reuse reused frames in a row detection is forced again.
+*/
+#ifndef CHANGE_GATE_H
+#define CHANGE_GATE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+class ChangeGate
+{
+public:
+	ChangeGate();
+
+	// threshold is the mean absolute difference in gray levels (0 disables the gate),
+	// step the grid spacing in pixels
+	void configure(double threshold, int max_reuse, int step);
+	bool enabled() const { return threshold > 0; }
+	void reset();
+
+	// True if the frame may reuse the remembered result; otherwise its signature becomes the
+	// reference and the caller must run detection and remember() the result
+	bool unchanged(const cv::Mat& frame, const cv::Rect& area);
+
+	// Result of the last fully processed frame
+	void remember(int flag, const std::string& turn);
+	int flag() const { return last_flag; }
+	const std::string& turn() const { return last_turn; }
+
+	// Whether the last unchanged() call reused the result, and its difference
+	bool lastHit() const { return last_hit; }
+	double lastDifference() const { return last_difference; }
+
+	long checks() const { return check_count; }
+	long hits() const { return hit_count; }
+	double hitRate() const { return check_count > 0 ? static_cast<double>(hit_count) / check_count : 0.0; }
+	int longestReuse() const { return longest_reuse; }     // Most reused frames in a row so far
+	double checkMs() const { return check_ns * 1e-6; }
+
+private:
+	double threshold;
+	int max_reuse;
+	int step;
+	std::vector<uchar> reference;   // Signature of the last processed frame
+	std::vector<uchar> candidate;   // Signature of the current frame
+	cv::Rect reference_area;        // Area the reference was sampled from
+	int reused;                     // Reused frames since the last detection
+	int last_flag;
+	std::string last_turn;
+	bool last_hit;
+	double last_difference;
+	long check_count;
+	long hit_count;
+	int longest_reuse;
+	int64_t check_ns;
+
+	void sample(const cv::Mat& frame, const cv::Rect& area, std::vector<uchar>& signature) const;
+};
+
+#endif // CHANGE_GATE_H
@@ -0,0 +1,265 @@
+/**
+*@file ChunkRunner.cpp
+*@brief Keyframe index, chunk planning and the per-chunk decode/detect tasks.
+*@brief Keyframes come from the FFmpeg backend's raw packet mode (OpenCV 4.6+), where grab()
+*@brief only demuxes. Older builds split at even frame positions instead; seeking there is still
+*@brief correct (the backend decodes forward from the previous keyframe), only slower.
+*/
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include "ChunkRunner.h"
+#include "ThreadPool.h"
+
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR >= 6)
+#define CHUNK_HAS_KEYFRAME_PROP
+#endif
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+std::mutex print_lock;
+
+double msSince(Clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+// Lane geometry, detection and turn; the confidence follows from them
+bool sameRecord(const LaneRecord& a, const LaneRecord& b)
+{
+    if (a.detected != b.detected || a.turn != b.turn)
+        return false;
+    for (int k = 0; k < 8; k++) {
+        if (a.points[k] != b.points[k])
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+ChunkRunner::ChunkRunner(const StreamSettings& settings, int threads, int chunks, int warmup)
+    : settings(settings), threads(threads), chunk_count(chunks), warmup(std::max(warmup, 0)),
+      keyframes_known(false), keyframe_count(0), index_ms(0.0), wall_ms(0.0)
+{
+}
+
+bool ChunkRunner::indexKeyframes(const std::string& input, std::vector<int>& keyframes, int& frames)
+{
+    keyframes.clear();
+    frames = 0;
+#ifdef CHUNK_HAS_KEYFRAME_PROP
+    cv::VideoCapture cap(input, cv::CAP_FFMPEG, { cv::CAP_PROP_FORMAT, -1 });
+    if (cap.isOpened()) {
+        while (cap.grab()) {
+            if (cap.get(cv::CAP_PROP_LRF_HAS_KEY_FRAME) != 0)
+                keyframes.push_back(frames);
+            frames++;
+        }
+        if (!keyframes.empty() && keyframes[0] == 0)
+            return true;
+        keyframes.clear();
+    }
+#endif
+    cv::VideoCapture cap2(input);
+    if (cap2.isOpened())
+        frames = static_cast<int>(cap2.get(cv::CAP_PROP_FRAME_COUNT));
+    return false;
+}
+
+/**
+*@brief Cut the clip into chunk_count chunks of about equal length, each starting at the keyframe
+*@brief nearest its ideal start; the warm-up of a chunk starts at the last keyframe at least
+*@brief warmup frames before it
+*/
+void ChunkRunner::plan(const std::vector<int>& keyframes, int frames, int workers)
+{
+    int count = chunk_count > 0 ? chunk_count : 2 * workers;
+    // A chunk shorter than a few warm-up lengths spends most of its time warming up
+    count = std::max(1, std::min(count, frames / std::max(4 * warmup, 1)));
+
+    std::vector<int> starts(1, 0);
+    for (int k = 1; k < count; k++) {
+        int ideal = static_cast<int>(static_cast<long>(frames) * k / count);
+        int start = ideal;
+        if (!keyframes.empty()) {
+            std::vector<int>::const_iterator it = std::lower_bound(keyframes.begin(), keyframes.end(), ideal);
+            if (it == keyframes.end() || (it != keyframes.begin() && ideal - *(it - 1) < *it - ideal))
+                --it;
+            start = *it;
+        }
+        if (start > starts.back())
+            starts.push_back(start);
+    }
+
+    chunks.assign(starts.size(), Chunk());
+    for (size_t i = 0; i < starts.size(); i++) {
+        Chunk& c = chunks[i];
+        c.first = starts[i];
+        c.last = i + 1 < starts.size() ? starts[i + 1] : -1;
+        c.seek = std::max(0, c.first - warmup);
+        if (!keyframes.empty() && c.seek > 0) {
+            std::vector<int>::const_iterator it = std::upper_bound(keyframes.begin(), keyframes.end(), c.seek);
+            c.seek = *(it - 1);
+        }
+    }
+}
+
+/**
+*@brief Decode and detect one chunk with its own capture and detector
+*@brief Warm-up frames only update the detector state; their records are dropped
+*/
+void ChunkRunner::processChunk(const std::string& input, double fps, int index)
+{
+    Chunk& c = chunks[index];
+    Clock::time_point t0 = Clock::now();
+
+    cv::VideoCapture cap(input);
+    if (!cap.isOpened() || (c.seek > 0 && !cap.set(cv::CAP_PROP_POS_FRAMES, c.seek))) {
+        std::lock_guard<std::mutex> guard(print_lock);
+        std::cout << "分段 " << index << " 无法定位到帧 " << c.seek << ": " << input << std::endl;
+        return;
+    }
+
+    LaneDetector detector;
+    settings.apply(detector);
+    // Strip threads per chunk would oversubscribe the pool
+    detector.setFrameThreads(0);
+    DetectOptions options;
+    options.plot = false;
+    options.edge_image = false;
+    cv::Mat frame;
+    cv::Mat edge_frame;
+    cv::Mat edge_bgr;
+    std::string turn;
+
+    if (c.last > 0)
+        c.records.reserve(c.last - c.first);
+    for (int n = c.seek; (c.last < 0 || n < c.last) && cap.read(frame); n++) {
+        int flag_plot = detectFrame(detector, frame, options, edge_frame, edge_bgr, turn);
+        if (n < c.first)
+            continue;
+        c.records.push_back(LaneRecord());
+        makeLaneRecord(detector, n, fps, flag_plot == 0, turn, c.records.back());
+    }
+    c.frames = static_cast<int>(c.records.size());
+    c.wall_ms = msSince(t0);
+    c.ok = c.last < 0 || c.frames == c.last - c.first;
+
+    std::lock_guard<std::mutex> guard(print_lock);
+    std::cout << "完成分段 [" << index + 1 << "/" << chunks.size() << "] 帧 " << c.first << "-"
+              << c.first + c.frames - 1 << ", 预热 " << c.first - c.seek << " 帧, " << c.wall_ms << " ms"
+              << (c.ok ? "" : " (帧数不足)") << std::endl;
+}
+
+bool ChunkRunner::run(const std::string& input)
+{
+    cv::VideoCapture probe(input);
+    if (!probe.isOpened())
+        return false;
+    double fps = probe.get(cv::CAP_PROP_FPS);
+    if (fps <= 0)
+        fps = 30.0;
+    probe.release();
+
+    Clock::time_point t0 = Clock::now();
+    std::vector<int> keyframes;
+    int frames = 0;
+    keyframes_known = indexKeyframes(input, keyframes, frames);
+    keyframe_count = static_cast<int>(keyframes.size());
+    index_ms = msSince(t0);
+
+    ThreadPool pool(threads);
+    threads = pool.size();
+    plan(keyframes, frames, threads);
+
+    // Every worker decodes its own chunk; OpenCV's own threads would only oversubscribe them
+    int cv_threads = cv::getNumThreads();
+    if (static_cast<int>(chunks.size()) >= threads)
+        cv::setNumThreads(1);
+    t0 = Clock::now();
+    for (size_t i = 0; i < chunks.size(); i++)
+        pool.submit([this, &input, fps, i] { processChunk(input, fps, static_cast<int>(i)); });
+    pool.wait();
+    wall_ms = msSince(t0);
+    cv::setNumThreads(cv_threads);
+
+    // Stitch in frame order; chunks cover consecutive frame ranges
+    frame_records.clear();
+    bool ok = true;
+    for (const Chunk& c : chunks) {
+        ok &= c.ok;
+        frame_records.insert(frame_records.end(), c.records.begin(), c.records.end());
+    }
+    return ok;
+}
+
+int ChunkRunner::compareSequential(const std::string& input)
+{
+    cv::VideoCapture cap(input);
+    if (!cap.isOpened())
+        return -1;
+    double fps = cap.get(cv::CAP_PROP_FPS);
+    if (fps <= 0)
+        fps = 30.0;
+
+    LaneDetector detector;
+    settings.apply(detector);
+    detector.setFrameThreads(0);
+    DetectOptions options;
+    options.plot = false;
+    options.edge_image = false;
+    cv::Mat frame;
+    cv::Mat edge_frame;
+    cv::Mat edge_bgr;
+    std::string turn;
+    LaneRecord record;
+    int mismatches = 0;
+    long n = 0;
+
+    Clock::time_point t0 = Clock::now();
+    for (; cap.read(frame); n++) {
+        int flag_plot = detectFrame(detector, frame, options, edge_frame, edge_bgr, turn);
+        makeLaneRecord(detector, n, fps, flag_plot == 0, turn, record);
+        if (n >= static_cast<long>(frame_records.size()) || !sameRecord(record, frame_records[n]))
+            mismatches++;
+    }
+    double sequential_ms = msSince(t0);
+    if (n != static_cast<long>(frame_records.size()))
+        mismatches += static_cast<int>(std::abs(static_cast<long>(frame_records.size()) - n));
+
+    std::cout << "顺序运行对比: " << n << " 帧, " << sequential_ms << " ms, 分段加速 "
+              << (wall_ms > 0 ? sequential_ms / wall_ms : 0.0) << "x, 结果不一致帧 " << mismatches << std::endl;
+    return mismatches;
+}
+
+void ChunkRunner::printReport() const
+{
+    double busy_ms = 0.0;
+    for (const Chunk& c : chunks)
+        busy_ms += c.wall_ms;
+    long frames = static_cast<long>(frame_records.size());
+
+    std::cout << "\n==========================================" << std::endl;
+    std::cout << "分段并行性能报告" << std::endl;
+    std::cout << "==========================================" << std::endl;
+    std::cout << "关键帧索引: " << (keyframes_known ? std::to_string(keyframe_count) + " 个关键帧"
+                                                  : std::string("后端不支持, 按帧位置均分"))
+              << ", " << index_ms << " ms" << std::endl;
+    std::cout << "分段数: " << chunks.size() << ", 工作线程: " << threads << ", 预热重叠: " << warmup << " 帧" << std::endl;
+    std::cout << "序号\t起始帧\t帧数\t预热\t耗时(ms)" << std::endl;
+    for (size_t i = 0; i < chunks.size(); i++) {
+        const Chunk& c = chunks[i];
+        std::cout << i << "\t" << c.first << "\t" << c.frames << "\t" << c.first - c.seek << "\t"
+                  << c.wall_ms << (c.ok ? "" : " (失败)") << std::endl;
+    }
+    std::cout << "总处理帧数: " << frames << std::endl;
+    std::cout << "整体执行时间: " << wall_ms << " ms (各分段累计 " << busy_ms << " ms)" << std::endl;
+    std::cout << "整体吞吐: " << (wall_ms > 0 ? frames * 1000.0 / wall_ms : 0.0) << " FPS" << std::endl;
+    std::cout << "==========================================" << std::endl;
+}
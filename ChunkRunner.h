@@ -0,0 +1,67 @@
+/**
+*@file ChunkRunner.h
+*@brief Chunked mode: one long clip split at keyframes and processed on the thread pool.
+*@brief The clip's keyframes are indexed without decoding, the frames are cut into GOP-aligned
+*@brief chunks and every chunk gets its own cv::VideoCapture (seeked with CAP_PROP_POS_FRAMES)
+*@brief and LaneDetector. A chunk first runs a warm-up overlap of the frames before it, so the
+*@brief stored line models and the tracker start from the state a sequential run would have;
+*@brief the per-frame records are then stitched back in frame order.
+*/
+#ifndef CHUNK_RUNNER_H
+#define CHUNK_RUNNER_H
+
+#include <string>
+#include <vector>
+#include "BatchRunner.h"
+
+class ChunkRunner
+{
+public:
+	// chunks <= 0 uses two chunks per worker; warmup is the overlap in frames before each chunk
+	ChunkRunner(const StreamSettings& settings, int threads, int chunks, int warmup);
+
+	// Process the clip; false if it cannot be opened or a chunk fails
+	bool run(const std::string& input);
+
+	// Records of every frame in order, valid after run()
+	const std::vector<LaneRecord>& records() const { return frame_records; }
+
+	// Run the clip sequentially and count the frames whose record differs from the chunked run;
+	// returns -1 if the clip cannot be opened
+	int compareSequential(const std::string& input);
+
+	// Chunk layout, per-chunk time and the throughput of the last run
+	void printReport() const;
+
+	// Frame indices of the keyframes and the frame count, read from the packets without decoding;
+	// false if the backend cannot report keyframes (the list is then empty)
+	static bool indexKeyframes(const std::string& input, std::vector<int>& keyframes, int& frames);
+
+private:
+	struct Chunk
+	{
+		int first = 0;              // First frame of the chunk
+		int last = 0;               // One past the last frame, -1 reads to the end of the clip
+		int seek = 0;               // Frame the capture is positioned at, the warm-up starts here
+		bool ok = false;
+		int frames = 0;             // Frames of the chunk that were processed
+		double wall_ms = 0.0;       // Seek, warm-up and chunk frames
+		std::vector<LaneRecord> records;
+	};
+
+	StreamSettings settings;
+	int threads;
+	int chunk_count;
+	int warmup;
+	std::vector<Chunk> chunks;
+	std::vector<LaneRecord> frame_records;
+	bool keyframes_known;
+	int keyframe_count;
+	double index_ms;
+	double wall_ms;
+
+	void plan(const std::vector<int>& keyframes, int frames, int workers);
+	void processChunk(const std::string& input, double fps, int index);
+};
+
+#endif // CHUNK_RUNNER_H
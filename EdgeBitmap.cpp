@@ -0,0 +1,99 @@
+/**
+*@file EdgeBitmap.cpp
+*@brief Packing of binary edge rows into bits and the set-bit walk that lists the edge points.
+*/
+#include <algorithm>
+#include <cstring>
+#include "EdgeBitmap.h"
+
+namespace {
+
+const uint64_t LOW7 = 0x7f7f7f7f7f7f7f7fULL;
+const uint64_t HIGH = 0x8080808080808080ULL;
+
+// Bit 7 of byte i lands on bit 56 + i (the shifts 7 * j with i + j = 7); all other products fall
+// on distinct lower bits, so nothing carries into the top byte
+const uint64_t GATHER = 0x0002040810204081ULL;
+
+// Bit i of the result is set if byte i (in memory order, little endian) of w is non-zero
+inline uint64_t packBytes(uint64_t w)
+{
+    w |= (w & LOW7) + LOW7;
+    return ((w & HIGH) * GATHER) >> 56;
+}
+
+} // namespace
+
+EdgeBitmap::EdgeBitmap()
+    : stride(0)
+{
+}
+
+void EdgeBitmap::create(cv::Size size)
+{
+    if (size != bitmap_size) {
+        bitmap_size = size;
+        stride = (size.width + 63) / 64;
+        words.assign(static_cast<size_t>(stride) * size.height, 0);
+        edge_points.reserve(static_cast<size_t>(size.width) * size.height / 8);
+    }
+    edge_points.clear();
+}
+
+/**
+*@brief Pack 8 pixels per step (all-zero groups are skipped), then walk the set bits of the row
+*@brief with count-trailing-zeros to list them as points
+*/
+void EdgeBitmap::packRow(int y, const uchar* src, int x0, int x1)
+{
+    uint64_t* dst = words.data() + static_cast<size_t>(y) * stride;
+    std::memset(dst, 0, stride * sizeof(uint64_t));
+
+    int n = x1 - x0;
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t w;
+        std::memcpy(&w, src + i, sizeof(w));
+        if (w == 0)
+            continue;
+        uint64_t bits = packBytes(w);
+        int x = x0 + i;
+        int shift = x & 63;
+        dst[x >> 6] |= bits << shift;
+        if (shift > 56)
+            dst[(x >> 6) + 1] |= bits >> (64 - shift);
+    }
+    for (; i < n; i++) {
+        if (src[i])
+            dst[(x0 + i) >> 6] |= 1ULL << ((x0 + i) & 63);
+    }
+
+    for (int k = x0 >> 6; k < stride; k++) {
+        for (uint64_t b = dst[k]; b != 0; b &= b - 1)
+            edge_points.push_back(cv::Point(k * 64 + __builtin_ctzll(b), y));
+    }
+}
+
+void EdgeBitmap::clearRow(int y)
+{
+    std::memset(words.data() + static_cast<size_t>(y) * stride, 0, stride * sizeof(uint64_t));
+}
+
+int EdgeBitmap::count() const
+{
+    int total = 0;
+    for (uint64_t w : words)
+        total += __builtin_popcountll(w);
+    return total;
+}
+
+void EdgeBitmap::unpack(cv::Mat& output) const
+{
+    output.create(bitmap_size, CV_8UC1);
+    for (int y = 0; y < bitmap_size.height; y++) {
+        const uint64_t* src = row(y);
+        uchar* dst = output.ptr<uchar>(y);
+        for (int x = 0; x < bitmap_size.width; x++)
+            dst[x] = ((src[x >> 6] >> (x & 63)) & 1) ? 255 : 0;
+    }
+}
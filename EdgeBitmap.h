@@ -0,0 +1,56 @@
+/**
+*@file EdgeBitmap.h
+*@brief Binary edge image packed into 64-bit words, one bit per pixel.
+*@brief The edge image only carries one bit of information per pixel; packed, a 1280x720 frame
+*@brief takes 14 KB instead of 115 KB, which fits the L2 of the board next to the Hough tables.
+*@brief Rows are packed from the 0/255 output of the fused kernel, clipped to a span of the
+*@brief row (the ROI mask run), and the set bits are listed as edge points in the same pass,
+*@brief so the Hough transform never scans empty pixels.
+*/
+#ifndef EDGE_BITMAP_H
+#define EDGE_BITMAP_H
+
+#include <cstdint>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+class EdgeBitmap
+{
+public:
+	EdgeBitmap();
+
+	// Size the bitmap for an image of this size and forget the edge points; rows keep their
+	// old bits until they are packed or cleared
+	void create(cv::Size size);
+
+	cv::Size size() const { return bitmap_size; }
+	int wordsPerRow() const { return stride; }
+
+	// Storage of the bits, without the point list
+	size_t bytes() const { return words.size() * sizeof(uint64_t); }
+
+	const uint64_t* row(int y) const { return words.data() + static_cast<size_t>(y) * stride; }
+	bool test(int x, int y) const { return (row(y)[x >> 6] >> (x & 63)) & 1; }
+
+	// Row y from the binary bytes src[0 .. x1-x0) of columns [x0, x1); every other bit of the row
+	// is cleared. The row's set bits are appended to points(), so rows must be packed in order.
+	void packRow(int y, const uchar* src, int x0, int x1);
+	void clearRow(int y);
+
+	// Set pixels of the packed rows in raster order
+	const std::vector<cv::Point>& points() const { return edge_points; }
+
+	// Number of set bits, counted with popcount
+	int count() const;
+
+	// 8-bit 0/255 image of the bitmap, e.g. for the edge video
+	void unpack(cv::Mat& output) const;
+
+private:
+	cv::Size bitmap_size;
+	int stride;                         // 64-bit words per row
+	std::vector<uint64_t> words;
+	std::vector<cv::Point> edge_points;
+};
+
+#endif // EDGE_BITMAP_H
@@ -0,0 +1,534 @@
+/**
+*@file EdgeKernel.cpp
+*@brief Scalar, SSE2/AVX2 and NEON implementations of the fused edge kernel.
+*@brief
+*@brief The legacy chain is GaussianBlur(3x3, BORDER_REFLECT_101) on BGR, cvtColor(BGR2GRAY),
+*@brief threshold(140) and filter2D with [-1 0 1]. All of it is reproduced with integers:
+*@brief   blur  = (sum of [1 2 1]x[1 2 1] taps + 8) >> 4   (OpenCV's bit-exact 8U Gaussian)
+*@brief   gray  = (c0*3735 + c1*19235 + c2*9798 + 16384) >> 15   (OpenCV 4.x 8U BGR2GRAY)
+*@brief   edge  = 255 where bin[x+1] is set and bin[x-1] is not, 0 at the left/right border
+*@brief
+*@brief A single-channel (luma) input skips the gray step: the blurred plane is thresholded directly.
+*@brief
+*@brief Tolerance: output is bit-exact against stock OpenCV 4.x. OpenCV 3.4 (14-bit gray weights)
+*@brief and builds whose cvtColor goes through a HAL may round gray differently by 1 level, so
+*@brief only pixels whose gray value is 140 or 141 can flip; no other pixel can differ.
+*/
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <opencv2/opencv.hpp>
+#include "EdgeKernel.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define EDGE_KERNEL_X86 1
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define EDGE_KERNEL_NEON 1
+#endif
+
+namespace {
+
+const int R2Y = 9798;   // Weights of cvtColor BGR2GRAY, 15-bit fixed point
+const int G2Y = 19235;
+const int B2Y = 3735;
+const int GRAY_SHIFT = 15;
+
+// ---------------------------------------------------------------------------
+// Scalar reference
+// ---------------------------------------------------------------------------
+
+void verticalSumScalar(const uchar* r0, const uchar* r1, const uchar* r2, ushort* v, int n)
+{
+    for (int i = 0; i < n; i++)
+        v[i] = static_cast<ushort>(r0[i] + 2 * r1[i] + r2[i]);
+}
+
+// Horizontal [1 2 1] over interleaved pixels: neighbours are step (the channel count) elements away
+void horizontalBlurScalar(const ushort* v, uchar* b, int n, int step)
+{
+    for (int i = 0; i < n; i++)
+        b[i] = static_cast<uchar>((v[i - step] + 2 * v[i] + v[i + step] + 8) >> 4);
+}
+
+void grayThresholdScalar(const uchar* b, uchar* bin, int ncols, int thresh)
+{
+    for (int c = 0; c < ncols; c++, b += 3) {
+        int gray = (b[0] * B2Y + b[1] * G2Y + b[2] * R2Y + (1 << (GRAY_SHIFT - 1))) >> GRAY_SHIFT;
+        bin[c] = gray > thresh ? 255 : 0;
+    }
+}
+
+// Luma input is already gray
+void lumaThresholdScalar(const uchar* b, uchar* bin, int ncols, int thresh)
+{
+    for (int c = 0; c < ncols; c++)
+        bin[c] = b[c] > thresh ? 255 : 0;
+}
+
+// dst[i] = bin[i+1] & ~bin[i-1], i.e. saturate(bin[i+1] - bin[i-1]) on a binary row
+void edgeCombineScalar(const uchar* bin, uchar* dst, int n)
+{
+    for (int i = 0; i < n; i++)
+        dst[i] = bin[i + 1] & static_cast<uchar>(~bin[i - 1]);
+}
+
+// ---------------------------------------------------------------------------
+// SSE2 / AVX2
+// ---------------------------------------------------------------------------
+#ifdef EDGE_KERNEL_X86
+
+void verticalSumSSE2(const uchar* r0, const uchar* r1, const uchar* r2, ushort* v, int n)
+{
+    const __m128i zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i <= n - 16; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r0 + i));
+        __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r1 + i));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r2 + i));
+        __m128i lo = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(c, zero)),
+                                   _mm_slli_epi16(_mm_unpacklo_epi8(m, zero), 1));
+        __m128i hi = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(c, zero)),
+                                   _mm_slli_epi16(_mm_unpackhi_epi8(m, zero), 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(v + i), lo);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(v + i + 8), hi);
+    }
+    verticalSumScalar(r0 + i, r1 + i, r2 + i, v + i, n - i);
+}
+
+void horizontalBlurSSE2(const ushort* v, uchar* b, int n, int step)
+{
+    const __m128i round = _mm_set1_epi16(8);
+    int i = 0;
+    for (; i <= n - 16; i += 16) {
+        __m128i h[2];
+        for (int k = 0; k < 2; k++) {
+            const ushort* p = v + i + 8 * k;
+            __m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p - step));
+            __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + step));
+            __m128i s = _mm_add_epi16(_mm_add_epi16(l, r), _mm_add_epi16(_mm_slli_epi16(c, 1), round));
+            h[k] = _mm_srli_epi16(s, 4);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(b + i), _mm_packus_epi16(h[0], h[1]));
+    }
+    horizontalBlurScalar(v + i, b + i, n - i, step);
+}
+
+void lumaThresholdSSE2(const uchar* b, uchar* bin, int ncols, int thresh)
+{
+    if (thresh < 0 || thresh > 254) {
+        lumaThresholdScalar(b, bin, ncols, thresh);
+        return;
+    }
+    // x > t exactly when the saturating difference x - t is non-zero
+    const __m128i t = _mm_set1_epi8(static_cast<char>(thresh));
+    const __m128i zero = _mm_setzero_si128();
+    int c = 0;
+    for (; c <= ncols - 16; c += 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + c));
+        __m128i le = _mm_cmpeq_epi8(_mm_subs_epu8(x, t), zero);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(bin + c), _mm_andnot_si128(le, _mm_set1_epi8(-1)));
+    }
+    lumaThresholdScalar(b + c, bin + c, ncols - c, thresh);
+}
+
+void edgeCombineSSE2(const uchar* bin, uchar* dst, int n)
+{
+    int i = 0;
+    for (; i <= n - 16; i += 16) {
+        __m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bin + i - 1));
+        __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bin + i + 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_andnot_si128(l, r));
+    }
+    edgeCombineScalar(bin + i, dst + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void verticalSumAVX2(const uchar* r0, const uchar* r1, const uchar* r2, ushort* v, int n)
+{
+    int i = 0;
+    for (; i <= n - 16; i += 16) {
+        __m256i a = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(r0 + i)));
+        __m256i m = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(r1 + i)));
+        __m256i c = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(r2 + i)));
+        __m256i s = _mm256_add_epi16(_mm256_add_epi16(a, c), _mm256_slli_epi16(m, 1));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(v + i), s);
+    }
+    verticalSumScalar(r0 + i, r1 + i, r2 + i, v + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void horizontalBlurAVX2(const ushort* v, uchar* b, int n, int step)
+{
+    const __m256i round = _mm256_set1_epi16(8);
+    int i = 0;
+    for (; i <= n - 16; i += 16) {
+        const ushort* p = v + i;
+        __m256i l = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p - step));
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i r = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + step));
+        __m256i h = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(l, r),
+                                      _mm256_add_epi16(_mm256_slli_epi16(c, 1), round)), 4);
+        // packus works per 128-bit lane: gather qwords 0 and 2 to get the 16 bytes in order
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(h, h), 0x08);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(b + i), _mm256_castsi256_si128(packed));
+    }
+    horizontalBlurScalar(v + i, b + i, n - i, step);
+}
+
+__attribute__((target("avx2")))
+void edgeCombineAVX2(const uchar* bin, uchar* dst, int n)
+{
+    int i = 0;
+    for (; i <= n - 32; i += 32) {
+        __m256i l = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bin + i - 1));
+        __m256i r = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bin + i + 1));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_andnot_si256(l, r));
+    }
+    edgeCombineSSE2(bin + i, dst + i, n - i);
+}
+
+#endif // EDGE_KERNEL_X86
+
+// ---------------------------------------------------------------------------
+// NEON
+// ---------------------------------------------------------------------------
+#ifdef EDGE_KERNEL_NEON
+
+void verticalSumNEON(const uchar* r0, const uchar* r1, const uchar* r2, ushort* v, int n)
+{
+    int i = 0;
+    for (; i <= n - 16; i += 16) {
+        uint8x16_t a = vld1q_u8(r0 + i);
+        uint8x16_t m = vld1q_u8(r1 + i);
+        uint8x16_t c = vld1q_u8(r2 + i);
+        uint16x8_t lo = vaddl_u8(vget_low_u8(a), vget_low_u8(c));
+        uint16x8_t hi = vaddl_u8(vget_high_u8(a), vget_high_u8(c));
+        lo = vaddq_u16(lo, vshll_n_u8(vget_low_u8(m), 1));
+        hi = vaddq_u16(hi, vshll_n_u8(vget_high_u8(m), 1));
+        vst1q_u16(v + i, lo);
+        vst1q_u16(v + i + 8, hi);
+    }
+    verticalSumScalar(r0 + i, r1 + i, r2 + i, v + i, n - i);
+}
+
+void horizontalBlurNEON(const ushort* v, uchar* b, int n, int step)
+{
+    int i = 0;
+    for (; i <= n - 16; i += 16) {
+        uint16x8_t h[2];
+        for (int k = 0; k < 2; k++) {
+            const ushort* p = v + i + 8 * k;
+            uint16x8_t s = vaddq_u16(vld1q_u16(p - step), vld1q_u16(p + step));
+            h[k] = vaddq_u16(s, vshlq_n_u16(vld1q_u16(p), 1));
+        }
+        // Rounding narrowing shift: (x + 8) >> 4
+        vst1q_u8(b + i, vcombine_u8(vrshrn_n_u16(h[0], 4), vrshrn_n_u16(h[1], 4)));
+    }
+    horizontalBlurScalar(v + i, b + i, n - i, step);
+}
+
+inline uint16x4_t grayQuad(uint16x4_t c0, uint16x4_t c1, uint16x4_t c2)
+{
+    uint32x4_t acc = vmull_n_u16(c0, B2Y);
+    acc = vmlal_n_u16(acc, c1, G2Y);
+    acc = vmlal_n_u16(acc, c2, R2Y);
+    return vrshrn_n_u32(acc, GRAY_SHIFT);
+}
+
+void grayThresholdNEON(const uchar* b, uchar* bin, int ncols, int thresh)
+{
+    // Thresholds outside the u8 range would wrap in the byte compare
+    if (thresh < 0 || thresh > 254) {
+        grayThresholdScalar(b, bin, ncols, thresh);
+        return;
+    }
+    const uint8x16_t t = vdupq_n_u8(static_cast<uchar>(thresh));
+    int c = 0;
+    for (; c <= ncols - 16; c += 16) {
+        uint8x16x3_t px = vld3q_u8(b + 3 * c);
+        uint16x8_t c0l = vmovl_u8(vget_low_u8(px.val[0])), c0h = vmovl_u8(vget_high_u8(px.val[0]));
+        uint16x8_t c1l = vmovl_u8(vget_low_u8(px.val[1])), c1h = vmovl_u8(vget_high_u8(px.val[1]));
+        uint16x8_t c2l = vmovl_u8(vget_low_u8(px.val[2])), c2h = vmovl_u8(vget_high_u8(px.val[2]));
+        uint16x8_t gl = vcombine_u16(grayQuad(vget_low_u16(c0l), vget_low_u16(c1l), vget_low_u16(c2l)),
+                                     grayQuad(vget_high_u16(c0l), vget_high_u16(c1l), vget_high_u16(c2l)));
+        uint16x8_t gh = vcombine_u16(grayQuad(vget_low_u16(c0h), vget_low_u16(c1h), vget_low_u16(c2h)),
+                                     grayQuad(vget_high_u16(c0h), vget_high_u16(c1h), vget_high_u16(c2h)));
+        uint8x16_t gray = vcombine_u8(vmovn_u16(gl), vmovn_u16(gh));
+        vst1q_u8(bin + c, vcgtq_u8(gray, t));
+    }
+    grayThresholdScalar(b + 3 * c, bin + c, ncols - c, thresh);
+}
+
+void lumaThresholdNEON(const uchar* b, uchar* bin, int ncols, int thresh)
+{
+    if (thresh < 0 || thresh > 254) {
+        lumaThresholdScalar(b, bin, ncols, thresh);
+        return;
+    }
+    const uint8x16_t t = vdupq_n_u8(static_cast<uchar>(thresh));
+    int c = 0;
+    for (; c <= ncols - 16; c += 16)
+        vst1q_u8(bin + c, vcgtq_u8(vld1q_u8(b + c), t));
+    lumaThresholdScalar(b + c, bin + c, ncols - c, thresh);
+}
+
+void edgeCombineNEON(const uchar* bin, uchar* dst, int n)
+{
+    int i = 0;
+    for (; i <= n - 16; i += 16)
+        vst1q_u8(dst + i, vbicq_u8(vld1q_u8(bin + i + 1), vld1q_u8(bin + i - 1)));
+    edgeCombineScalar(bin + i, dst + i, n - i);
+}
+
+#endif // EDGE_KERNEL_NEON
+
+// Per-ISA function table
+struct KernelOps
+{
+    void (*verticalSum)(const uchar*, const uchar*, const uchar*, ushort*, int);
+    void (*horizontalBlur)(const ushort*, uchar*, int, int);
+    void (*grayThreshold)(const uchar*, uchar*, int, int);
+    void (*lumaThreshold)(const uchar*, uchar*, int, int);
+    void (*edgeCombine)(const uchar*, uchar*, int);
+};
+
+KernelOps opsFor(FusedEdgeKernel::Isa isa)
+{
+    KernelOps ops = { verticalSumScalar, horizontalBlurScalar, grayThresholdScalar, lumaThresholdScalar, edgeCombineScalar };
+    switch (isa) {
+#ifdef EDGE_KERNEL_X86
+    case FusedEdgeKernel::ISA_SSE2:
+        ops.verticalSum = verticalSumSSE2;
+        ops.horizontalBlur = horizontalBlurSSE2;
+        ops.lumaThreshold = lumaThresholdSSE2;
+        ops.edgeCombine = edgeCombineSSE2;
+        break;
+    case FusedEdgeKernel::ISA_AVX2:
+        ops.verticalSum = verticalSumAVX2;
+        ops.horizontalBlur = horizontalBlurAVX2;
+        ops.lumaThreshold = lumaThresholdSSE2;
+        ops.edgeCombine = edgeCombineAVX2;
+        break;
+#endif
+#ifdef EDGE_KERNEL_NEON
+    case FusedEdgeKernel::ISA_NEON:
+        ops.verticalSum = verticalSumNEON;
+        ops.horizontalBlur = horizontalBlurNEON;
+        ops.grayThreshold = grayThresholdNEON;
+        ops.lumaThreshold = lumaThresholdNEON;
+        ops.edgeCombine = edgeCombineNEON;
+        break;
+#endif
+    default:
+        break;
+    }
+    return ops;
+}
+
+inline int reflect101(int i, int n)
+{
+    return i < 0 ? -i : (i >= n ? 2 * n - 2 - i : i);
+}
+
+} // namespace
+
+FusedEdgeKernel::FusedEdgeKernel()
+{
+    setIsa(ISA_AUTO);
+}
+
+bool FusedEdgeKernel::isaSupported(Isa isa)
+{
+    switch (isa) {
+    case ISA_AUTO:
+    case ISA_SCALAR:
+        return true;
+#ifdef EDGE_KERNEL_X86
+    case ISA_SSE2:
+        return __builtin_cpu_supports("sse2");
+    case ISA_AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+#ifdef EDGE_KERNEL_NEON
+    case ISA_NEON:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+FusedEdgeKernel::Isa FusedEdgeKernel::bestIsa()
+{
+    if (isaSupported(ISA_NEON))
+        return ISA_NEON;
+    if (isaSupported(ISA_AVX2))
+        return ISA_AVX2;
+    if (isaSupported(ISA_SSE2))
+        return ISA_SSE2;
+    return ISA_SCALAR;
+}
+
+const char* FusedEdgeKernel::isaName(Isa isa)
+{
+    switch (isa) {
+    case ISA_SCALAR: return "scalar";
+    case ISA_SSE2:   return "sse2";
+    case ISA_AVX2:   return "avx2";
+    case ISA_NEON:   return "neon";
+    default:         return "auto";
+    }
+}
+
+void FusedEdgeKernel::setIsa(Isa isa)
+{
+    if (isa == ISA_AUTO)
+        isa = bestIsa();
+    active_isa = isaSupported(isa) ? isa : ISA_SCALAR;
+}
+
+void FusedEdgeKernel::reserve(int width)
+{
+    // One guard element on each side so the SIMD loads at i-3 / i+3 and i-1 / i+1 stay in bounds
+    size_t n = static_cast<size_t>(width) * 3 + 32;
+    if (vsum.size() < n) {
+        vsum.resize(n);
+        blur.resize(n);
+        bin.resize(width + 32);
+    }
+}
+
+void FusedEdgeKernel::runRow(const cv::Mat& bgr, int y, int x0, int x1, uchar* dst, int thresh)
+{
+    const int w = bgr.cols;
+    const int h = bgr.rows;
+    const int cn = bgr.channels();
+    const KernelOps ops = opsFor(active_isa);
+
+    if (x1 <= x0)
+        return;
+
+    // Degenerate frames have no interior pixels, filter2D yields all zeros there
+    if (w < 3 || h < 2) {
+        std::memset(dst, 0, x1 - x0);
+        return;
+    }
+
+    reserve(w);
+    // Buffers are indexed by absolute column, offset by a 16 element guard
+    ushort* v = &vsum[16];
+    uchar* b = &blur[16];
+    uchar* t = &bin[16];
+
+    // Columns needed: edges in [x0, x1) read bin in [x0-1, x1+1), which read blur one further out
+    const int bs = std::max(x0 - 1, 0);
+    const int be = std::min(x1 + 1, w);
+    const int vs = std::max(bs - 1, 0);
+    const int ve = std::min(be + 1, w);
+
+    const uchar* r0 = bgr.ptr<uchar>(reflect101(y - 1, h));
+    const uchar* r1 = bgr.ptr<uchar>(y);
+    const uchar* r2 = bgr.ptr<uchar>(reflect101(y + 1, h));
+    ops.verticalSum(r0 + cn * vs, r1 + cn * vs, r2 + cn * vs, v + cn * vs, cn * (ve - vs));
+
+    // Interior columns use the flat interleaved filter, the two frame border columns reflect
+    const int is = std::max(bs, 1);
+    const int ie = std::min(be, w - 1);
+    if (ie > is)
+        ops.horizontalBlur(v + cn * is, b + cn * is, cn * (ie - is), cn);
+    for (int c = bs; c < be; c++) {
+        if (c >= is && c < ie)
+            continue;
+        int cl = reflect101(c - 1, w);
+        int cr = reflect101(c + 1, w);
+        for (int k = 0; k < cn; k++)
+            b[cn * c + k] = static_cast<uchar>((v[cn * cl + k] + 2 * v[cn * c + k] + v[cn * cr + k] + 8) >> 4);
+    }
+
+    if (cn == 1)
+        ops.lumaThreshold(b + bs, t + bs, be - bs, thresh);
+    else
+        ops.grayThreshold(b + 3 * bs, t + bs, be - bs, thresh);
+
+    // Reflected border makes the [-1 0 1] response zero in the first and last frame column
+    int es = std::max(x0, 1);
+    int ee = std::min(x1, w - 1);
+    for (int x = x0; x < std::min(es, x1); x++)
+        dst[x - x0] = 0;
+    for (int x = std::max(ee, x0); x < x1; x++)
+        dst[x - x0] = 0;
+    if (ee > es)
+        ops.edgeCombine(t + es, dst + (es - x0), ee - es);
+}
+
+void FusedEdgeKernel::run(const cv::Mat& bgr, const cv::Rect& roi, cv::Mat& edges, int thresh)
+{
+    CV_Assert(bgr.type() == CV_8UC3 || bgr.type() == CV_8UC1);
+    cv::Rect r = roi & cv::Rect(0, 0, bgr.cols, bgr.rows);
+
+    edges.create(r.height, r.width, CV_8UC1);
+    for (int y = 0; y < r.height; y++)
+        runRow(bgr, r.y + y, r.x, r.x + r.width, edges.ptr<uchar>(y), thresh);
+}
+
+/**
+*@brief Area-downsample, gray, threshold and [-1 0 1] in one pass over the rectangle
+*@brief Block sums of up to 4x4 pixels fit the 16-bit vsum buffer; the gray, threshold and
+*@brief edge steps reuse the per-ISA row operations of the full-resolution kernel
+*/
+void FusedEdgeKernel::runDownsampled(const cv::Mat& bgr, const cv::Rect& roi, int factor, cv::Mat& edges, int thresh)
+{
+    CV_Assert((bgr.type() == CV_8UC3 || bgr.type() == CV_8UC1) && factor >= 1 && factor <= 4);
+    cv::Rect r = roi & cv::Rect(0, 0, bgr.cols, bgr.rows);
+    const int cn = bgr.channels();
+    const int ow = r.width / factor;
+    const int oh = r.height / factor;
+    const int area = factor * factor;
+    const KernelOps ops = opsFor(active_isa);
+
+    edges.create(oh, ow, CV_8UC1);
+    reserve(ow);
+    ushort* v = &vsum[16];
+    uchar* b = &blur[16];
+    uchar* t = &bin[16];
+
+    for (int oy = 0; oy < oh; oy++) {
+        std::memset(v, 0, cn * ow * sizeof(ushort));
+        for (int k = 0; k < factor; k++) {
+            const uchar* row = bgr.ptr<uchar>(r.y + oy * factor + k) + cn * r.x;
+            for (int ox = 0; ox < ow; ox++) {
+                const uchar* p = row + cn * factor * ox;
+                for (int j = 0; j < factor; j++) {
+                    for (int c = 0; c < cn; c++)
+                        v[cn * ox + c] += p[cn * j + c];
+                }
+            }
+        }
+        for (int i = 0; i < cn * ow; i++)
+            b[i] = static_cast<uchar>((v[i] + area / 2) / area);
+
+        if (cn == 1)
+            ops.lumaThreshold(b, t, ow, thresh);
+        else
+            ops.grayThreshold(b, t, ow, thresh);
+
+        // Reflected border makes the response zero in the first and last column
+        uchar* dst = edges.ptr<uchar>(oy);
+        if (ow < 3) {
+            std::memset(dst, 0, ow);
+            continue;
+        }
+        dst[0] = dst[ow - 1] = 0;
+        ops.edgeCombine(t + 1, dst + 1, ow - 2);
+    }
+}
+
+void FusedEdgeKernel::run(const cv::Mat& bgr, cv::Mat& edges, int thresh)
+{
+    run(bgr, cv::Rect(0, 0, bgr.cols, bgr.rows), edges, thresh);
+}
@@ -0,0 +1,56 @@
+/**
+*@file EdgeKernel.h
+*@brief Fused single-pass edge kernel replacing the deNoise/edgeDetector chain.
+*@brief One row-streaming pass computes 3x3 Gaussian -> gray -> threshold -> [-1 0 1]
+*@brief with integer arithmetic, using small per-row buffers instead of full-frame images.
+*@brief Every entry point also takes an 8-bit single-channel image, e.g. the Y plane of a
+*@brief decoder buffer; it is blurred and thresholded as is, without the gray conversion.
+*/
+#ifndef EDGE_KERNEL_H
+#define EDGE_KERNEL_H
+
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+class FusedEdgeKernel
+{
+public:
+	// Instruction set used by the kernel. ISA_AUTO resolves to the best one for this CPU.
+	enum Isa { ISA_AUTO = 0, ISA_SCALAR, ISA_SSE2, ISA_AVX2, ISA_NEON };
+
+	FusedEdgeKernel();
+
+	// Binary edge image of the whole BGR frame (same result as edgeDetector(deNoise(frame)))
+	void run(const cv::Mat& bgr, cv::Mat& edges, int thresh = 140);
+
+	// Binary edge image of a sub-rectangle of the frame, output has roi.size().
+	// Pixels outside the rectangle are used as real neighbours, so the result equals the
+	// same rectangle cut out of the full-frame output.
+	void run(const cv::Mat& bgr, const cv::Rect& roi, cv::Mat& edges, int thresh = 140);
+
+	// Edge values of frame row y, columns [x0, x1), written to dst[0 .. x1-x0)
+	void runRow(const cv::Mat& bgr, int y, int x0, int x1, uchar* dst, int thresh = 140);
+
+	// Coarse edge image of a sub-rectangle: factor x factor blocks are area-averaged (which
+	// takes the place of the Gaussian), then gray, threshold and [-1 0 1] run at the reduced
+	// size. Output is (roi.width / factor) x (roi.height / factor); factor is 1 to 4.
+	void runDownsampled(const cv::Mat& bgr, const cv::Rect& roi, int factor, cv::Mat& edges, int thresh = 140);
+
+	// Select the instruction set (falls back to scalar if unsupported)
+	void setIsa(Isa isa);
+	Isa isa() const { return active_isa; }
+
+	static Isa bestIsa();
+	static bool isaSupported(Isa isa);
+	static const char* isaName(Isa isa);
+
+private:
+	Isa active_isa;
+	std::vector<ushort> vsum;   // Vertical [1 2 1] sums of the interleaved BGR row
+	std::vector<uchar> blur;    // Blurred interleaved BGR row
+	std::vector<uchar> bin;     // Thresholded gray row (0 / 255)
+
+	void reserve(int width);
+};
+
+#endif // EDGE_KERNEL_H
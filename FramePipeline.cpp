@@ -0,0 +1,391 @@
+/**
+*@file FramePipeline.cpp
+*@brief Per-frame detection shared by the serial loop and the threaded pipeline.
+*@brief The pipeline runs decode, detection and the two MJPG encoders on separate threads,
+*@brief connected by SPSC rings of reusable frame slots, so frames stay in order and the
+*@brief throughput approaches the slowest stage instead of the sum of all stages.
+*/
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <opencv2/opencv.hpp>
+#include "FramePipeline.h"
+#include "Tracer.h"
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double msSince(Clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+// Spin, then yield, then sleep until ready() holds; returns the time spent waiting in ms.
+// A wait that blocked shows up in the trace under the queue's name
+template <typename Ready>
+double waitUntil(const char* queue, Ready ready)
+{
+    if (ready())
+        return 0.0;
+
+    TraceScope trace(queue);
+    Clock::time_point t0 = Clock::now();
+    for (int spins = 0; !ready(); spins++) {
+        if (spins < 256)
+            std::this_thread::yield();
+        else
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    return msSince(t0);
+}
+
+int detectStages(LaneDetector& lanedetector, cv::Mat& frame, const DetectOptions& options,
+                 cv::Mat& edge_frame, cv::Mat& edge_bgr, std::string& turn)
+{
+    // 所有中间结果写入检测器持有的工作区，首帧之后不再分配内存
+    FrameWorkspace& work = lanedetector.workspace();
+    bool band = lanedetector.trackingLocked();
+    bool strip_lines = false;
+    bool packed = false;
+
+    if (band) {
+        // 跟踪已锁定：只在预测车道线附近的窄带内做边缘检测，结果已按ROI掩码裁剪
+        lanedetector.bandEdgeDetector(frame, work.band);
+    } else if (lanedetector.scale() > 1) {
+        // 粗到精模式：在降采样图像上检测边缘，回归时再在全分辨率窄带内精化
+        lanedetector.pyramidEdgeDetector(frame, work.edges);
+        lanedetector.mask(work.edges, work.masked);
+    } else if (lanedetector.frameThreads() > 0 && !options.legacy_edge) {
+        // 帧内并行：ROI按行分条，各条带并行完成边缘检测与掩码（标准Hough模式下同时投票），结果与串行阶段相同
+        lanedetector.parallelDetect(frame, work.masked, work.lines);
+        strip_lines = true;
+    } else if (lanedetector.bitmapMode() && !options.legacy_edge) {
+        // 位图模式：边缘按行打包为1位，掩码按行区间在同一遍中完成，并输出稀疏边缘点
+        lanedetector.bitmapEdgeDetector(frame, work.bitmap);
+        packed = true;
+        // 仅在输出边缘视频时展开为字节图像
+        if (options.edge_image)
+            work.bitmap.unpack(work.masked);
+    } else {
+        if (options.legacy_edge) {
+            // 采用Gaussian滤波器去噪声
+            lanedetector.deNoise(frame, work.denoised);
+
+            // 边缘检测
+            lanedetector.edgeDetector(work.denoised, work.edges);
+        } else {
+            // 去噪与边缘检测单遍融合
+            lanedetector.fusedEdgeDetector(frame, work.edges);
+        }
+
+        // 裁剪图像以获取ROI
+        lanedetector.mask(work.edges, work.masked);
+    }
+    const cv::Mat& img_mask = band ? work.band : work.masked;
+
+    // 将边缘检测结果转换为3通道以便写入视频；ROI模式下先贴回整帧
+    if (!options.edge_image) {
+        // 不输出边缘视频时跳过转换
+    } else if (img_mask.size() == frame.size()) {
+        cv::cvtColor(img_mask, edge_bgr, cv::COLOR_GRAY2BGR);
+    } else {
+        if (edge_frame.size() != frame.size())
+            edge_frame = cv::Mat::zeros(frame.size(), CV_8UC1);
+        cv::Rect area = packed ? lanedetector.laneBounds(frame.size()) : lanedetector.roi(frame.size());
+        cv::Mat target = edge_frame(area);
+        if (img_mask.size() == area.size()) {
+            img_mask.copyTo(target);
+        } else {
+            // 粗尺度边缘图放大回原尺寸
+            cv::resize(img_mask, target, area.size(), 0, 0, cv::INTER_NEAREST);
+        }
+        cv::cvtColor(edge_frame, edge_bgr, cv::COLOR_GRAY2BGR);
+    }
+
+    // 在ROI区域通过Hough变换得到Hough线
+    if (packed)
+        lanedetector.houghLines(work.bitmap, work.lines);
+    else if (!strip_lines)
+        lanedetector.houghLines(img_mask, work.lines);
+    if (work.lines.empty()) {
+        // 跟踪模式下本帧按漏检处理，连续漏检会解除锁定并回到全ROI检测
+        if (lanedetector.trackingMode())
+            lanedetector.tracker().miss();
+        return -1;
+    }
+
+    // 分离左右车道线
+    lanedetector.lineSeparation(work.lines, work.left_right_lines, work.fits);
+
+    // 采用回归法获取单边车道线
+    lanedetector.regression(work.left_right_lines, work.fits, frame, work.lane);
+
+    // 预测车道线是向左、向右还是直行
+    lanedetector.predictTurn(turn);
+
+    // 无需彩色视频时只输出车道线数据，不绘制
+    if (!options.plot)
+        return 0;
+
+    // 在视频图上绘制车道线
+    return lanedetector.plotLane(frame, work.lane, turn);
+}
+
+} // namespace
+
+int detectFrame(LaneDetector& lanedetector, cv::Mat& frame, const DetectOptions& options,
+                cv::Mat& edge_frame, cv::Mat& edge_bgr, std::string& turn)
+{
+    ChangeGate& gate = lanedetector.changeGate();
+    if (!gate.enabled())
+        return detectStages(lanedetector, frame, options, edge_frame, edge_bgr, turn);
+
+    // 车道区域与上次完整检测的帧几乎相同：沿用上次的车道线、转向与边缘图
+    // edge_bgr可能是流水线中轮转的缓冲区，不能假定其中仍是上一帧的边缘图，因此从工作区复制
+    FrameWorkspace& work = lanedetector.workspace();
+    if (gate.unchanged(frame, lanedetector.laneBounds(frame.size()))) {
+        if (options.edge_image)
+            work.gate_edges.copyTo(edge_bgr);
+        if (gate.flag() != 0)
+            return gate.flag();
+        turn = gate.turn();
+        if (!options.plot)
+            return 0;
+        return lanedetector.plotLane(frame, work.lane, turn);
+    }
+
+    int flag_plot = detectStages(lanedetector, frame, options, edge_frame, edge_bgr, turn);
+    gate.remember(flag_plot, turn);
+    if (options.edge_image)
+        edge_bgr.copyTo(work.gate_edges);
+    return flag_plot;
+}
+
+int detectFrame(LaneDetector& lanedetector, const FrameSource& source, const DetectOptions& options,
+                cv::Mat& color, cv::Mat& edge_frame, cv::Mat& edge_bgr, std::string& turn)
+{
+    // 检测直接读取解码缓冲区中的Y平面（或帧存储中的BGR帧），不做颜色转换
+    DetectOptions luma_options = options;
+    luma_options.plot = false;
+    cv::Mat image = source.image();
+    int flag_plot = detectFrame(lanedetector, image, luma_options, edge_frame, edge_bgr, turn);
+
+    // 仅在需要彩色视频时转换为BGR并绘制
+    if (!options.plot)
+        return flag_plot;
+    source.bgr(color);
+    if (flag_plot != 0)
+        return flag_plot;
+    return lanedetector.plotLane(color, lanedetector.workspace().lane, turn);
+}
+
+bool adaptToSource(LaneDetector& lanedetector, const FrameSource& source)
+{
+    if (source.bandTop() == 0)
+        return true;
+    lanedetector.setRoiMode(true);
+    return lanedetector.laneBounds(source.size()).y - 1 >= source.bandTop();
+}
+
+bool OutputSelection::parse(const std::string& list)
+{
+    color_video = false;
+    edge_video = false;
+    records = false;
+
+    size_t begin = 0;
+    while (begin <= list.size()) {
+        size_t end = list.find(',', begin);
+        if (end == std::string::npos)
+            end = list.size();
+        std::string name = list.substr(begin, end - begin);
+        if (name == "color")
+            color_video = true;
+        else if (name == "edge")
+            edge_video = true;
+        else if (name == "record")
+            records = true;
+        else
+            return false;
+        begin = end + 1;
+    }
+    return true;
+}
+
+void OutputSelection::applyTo(DetectOptions& options) const
+{
+    options.plot = color_video;
+    options.edge_image = edge_video;
+}
+
+FramePipeline::FramePipeline(LaneDetector& detector, const DetectOptions& options, int queue_depth)
+    : detector(detector), options(options), queue_depth(std::max(queue_depth, 1)),
+      decoded(this->queue_depth), color_out(this->queue_depth), edge_out(this->queue_depth),
+      wall_ms(0.0)
+{
+    decode_timing.name = "解码";
+    detect_timing.name = "检测";
+    color_timing.name = "彩色编码";
+    edge_timing.name = "边缘编码";
+}
+
+/**
+*@brief Decode stage: read frames into free slots of the decode queue
+*/
+void FramePipeline::decodeStage(cv::VideoCapture& cap)
+{
+    Tracer::setThreadName("decode");
+    while (true) {
+        FrameSlot* slot = nullptr;
+        Tracer::setFrame(decode_timing.frames);
+        decode_timing.wait_out_ms += waitUntil("wait decode queue", [&] { return (slot = decoded.tryAcquireWrite()) != nullptr; });
+
+        Clock::time_point t0 = Clock::now();
+        // read() reuses the slot's buffer once it has the frame size
+        bool ok;
+        {
+            TraceScope trace("decode");
+            ok = cap.read(slot->frame);
+        }
+        decode_timing.busy_ms += msSince(t0);
+        if (!ok)
+            break;
+
+        decoded.commitWrite();
+        decode_timing.frames++;
+    }
+    decoded.close();
+}
+
+/**
+*@brief Detection stage: run the LaneDetector stages and fan the results out to both encoders
+*/
+void FramePipeline::detectStage(int& flag_plot)
+{
+    cv::Mat edge_frame;
+    std::string turn;
+    LaneRecord record;
+
+    Tracer::setThreadName("detect");
+    while (true) {
+        FrameSlot* in = nullptr;
+        Tracer::setFrame(detect_timing.frames);
+        detect_timing.wait_in_ms += waitUntil("wait decoded frame", [&] {
+            in = decoded.tryAcquireRead();
+            return in != nullptr || decoded.finished();
+        });
+        if (in == nullptr)
+            break;
+        detect_timing.occupancy_sum += decoded.size();
+
+        FrameSlot* color = nullptr;
+        FrameSlot* edge = nullptr;
+        detect_timing.wait_out_ms += waitUntil("wait color queue", [&] { return (color = color_out.tryAcquireWrite()) != nullptr; });
+        detect_timing.wait_out_ms += waitUntil("wait edge queue", [&] { return (edge = edge_out.tryAcquireWrite()) != nullptr; });
+
+        Clock::time_point t0 = Clock::now();
+        {
+            TraceScope trace("detect");
+            flag_plot = detectFrame(detector, in->frame, options, edge_frame, edge->frame, turn);
+        }
+        double detect_ms = msSince(t0);
+        if (records != nullptr) {
+            makeLaneRecord(detector, detect_timing.frames, record_fps, flag_plot == 0, turn, record);
+            records->write(record);
+        }
+
+        // Hand the frame to the color encoder by swapping buffers: the decode slot gets the
+        // encoder's already written buffer back, so no frame is copied or allocated
+        cv::swap(in->frame, color->frame);
+        detect_timing.busy_ms += msSince(t0);
+
+        decoded.releaseRead();
+        color_out.commitWrite();
+        edge_out.commitWrite();
+        if (logger != nullptr)
+            logger->frame(detect_timing.frames, flag_plot == 0, flag_plot == 0 ? turn : std::string(), detect_ms);
+        detect_timing.frames++;
+    }
+    color_out.close();
+    edge_out.close();
+}
+
+/**
+*@brief Encoder stage: write the frames of one output queue to its video file
+*/
+void FramePipeline::encodeStage(SpscRing<FrameSlot>& input, cv::VideoWriter& writer, StageTiming& timing)
+{
+    Tracer::setThreadName(&input == &color_out ? "encode color" : "encode edge");
+    while (true) {
+        FrameSlot* slot = nullptr;
+        Tracer::setFrame(timing.frames);
+        timing.wait_in_ms += waitUntil("wait detected frame", [&] {
+            slot = input.tryAcquireRead();
+            return slot != nullptr || input.finished();
+        });
+        if (slot == nullptr)
+            break;
+        timing.occupancy_sum += input.size();
+
+        Clock::time_point t0 = Clock::now();
+        if (writer.isOpened()) {
+            TraceScope trace("encode");
+            writer.write(slot->frame);
+        }
+        timing.busy_ms += msSince(t0);
+
+        input.releaseRead();
+        timing.frames++;
+    }
+}
+
+int FramePipeline::run(cv::VideoCapture& cap, cv::VideoWriter& color_writer, cv::VideoWriter& bw_writer, int& flag_plot)
+{
+    Clock::time_point t0 = Clock::now();
+
+    std::thread color_thread(&FramePipeline::encodeStage, this, std::ref(color_out), std::ref(color_writer), std::ref(color_timing));
+    std::thread edge_thread(&FramePipeline::encodeStage, this, std::ref(edge_out), std::ref(bw_writer), std::ref(edge_timing));
+    std::thread detect_thread(&FramePipeline::detectStage, this, std::ref(flag_plot));
+
+    // 解码在调用线程中进行
+    decodeStage(cap);
+
+    detect_thread.join();
+    color_thread.join();
+    edge_thread.join();
+
+    wall_ms = msSince(t0);
+    return static_cast<int>(detect_timing.frames);
+}
+
+void FramePipeline::printReport() const
+{
+    const StageTiming* stages[] = { &decode_timing, &detect_timing, &color_timing, &edge_timing };
+    const StageTiming* slowest = stages[0];
+
+    std::cout << "\n流水线统计 (队列深度: " << queue_depth << ")" << std::endl;
+    std::cout << "阶段\t帧数\t忙碌(ms/帧)\t等待输入(ms)\t等待输出(ms)\t输入队列平均占用" << std::endl;
+    for (const StageTiming* t : stages) {
+        double per_frame = t->frames > 0 ? t->busy_ms / t->frames : 0.0;
+        std::cout << std::fixed << std::setprecision(2)
+                  << t->name << "\t" << t->frames << "\t" << per_frame << "\t\t"
+                  << t->wait_in_ms << "\t\t" << t->wait_out_ms << "\t\t";
+        if (t == &decode_timing)
+            std::cout << "-" << std::endl;
+        else
+            std::cout << (t->frames > 0 ? t->occupancy_sum / t->frames : 0.0) << "/" << queue_depth << std::endl;
+
+        if (t->frames > 0 && per_frame > slowest->busy_ms / std::max(slowest->frames, 1L))
+            slowest = t;
+    }
+    std::cout.unsetf(std::ios::fixed);
+
+    double slowest_ms = slowest->frames > 0 ? slowest->busy_ms / slowest->frames : 0.0;
+    double fps = wall_ms > 0 ? detect_timing.frames * 1000.0 / wall_ms : 0.0;
+    std::cout << "最慢阶段: " << slowest->name << " (" << slowest_ms << " ms/帧, 上限 "
+              << (slowest_ms > 0 ? 1000.0 / slowest_ms : 0.0) << " FPS)" << std::endl;
+    std::cout << "流水线吞吐: " << fps << " FPS" << std::endl;
+}
@@ -0,0 +1,121 @@
+/**
+*@file FramePipeline.h
+*@brief Per-frame detection and the multi-threaded decode -> detect -> encode pipeline.
+*/
+#ifndef FRAME_PIPELINE_H
+#define FRAME_PIPELINE_H
+
+#include <string>
+#include <opencv2/opencv.hpp>
+#include "FrameSource.h"
+#include "LaneDetector.h"
+#include "LaneRecord.h"
+#include "Logger.h"
+#include "SpscRing.h"
+
+// Options that select how a frame goes through the LaneDetector stages
+struct DetectOptions
+{
+	bool legacy_edge = false;   // deNoise + edgeDetector instead of the fused kernel
+	bool plot = true;           // Draw the lane and turn message into the frame
+	bool edge_image = true;     // Produce the 3-channel edge image for the edge video
+};
+
+// Outputs of a run, each selectable on its own; records need no rendering or encoding
+struct OutputSelection
+{
+	bool color_video = true;    // Frames with the plotted lane
+	bool edge_video = true;     // Masked edge images
+	bool records = false;       // One LaneRecord per frame
+	RecordWriter::Format record_format = RecordWriter::FORMAT_CSV;
+
+	// Comma separated list of color, edge and record; false on an unknown name
+	bool parse(const std::string& list);
+
+	// Only render what the selected videos need
+	void applyTo(DetectOptions& options) const;
+};
+
+/**
+*@brief Run every LaneDetector stage on one frame
+*@param lanedetector is the detector that owns the per-stream state
+*@param frame is the input frame, the lane is plotted on it in place
+*@param options selects the edge path (a locked tracker always uses the fused band kernel)
+*@param edge_frame is a caller-owned full-frame gray buffer used to paste ROI edge images
+*@param edge_bgr receives the 3-channel masked edge image for the edge video (if options.edge_image)
+*@param turn receives the turn prediction
+*@return 0 if a lane was found (and plotted if options.plot), -1 if no Hough lines were found
+*/
+int detectFrame(LaneDetector& lanedetector, cv::Mat& frame, const DetectOptions& options,
+                cv::Mat& edge_frame, cv::Mat& edge_bgr, std::string& turn);
+
+/**
+*@brief Run every LaneDetector stage on the luma plane of a FrameSource frame
+*@brief The stages read the Y plane in the decoder buffer (or a mapped BGR store frame) without a
+*@brief copy; the BGR image is only converted when options.plot is set, and the lane is plotted on it
+*@param source holds the current frame
+*@param color receives the BGR frame (with the lane if one was found) when options.plot is set
+*@return 0 if a lane was found, -1 if no Hough lines were found
+*/
+int detectFrame(LaneDetector& lanedetector, const FrameSource& source, const DetectOptions& options,
+                cv::Mat& color, cv::Mat& edge_frame, cv::Mat& edge_bgr, std::string& turn);
+
+// Cropped frame stores are only valid in ROI mode: turn it on; false if the stored band
+// does not cover the lane bounding box and its blur margin under the detector's configuration
+bool adaptToSource(LaneDetector& lanedetector, const FrameSource& source);
+
+class FramePipeline
+{
+public:
+	FramePipeline(LaneDetector& detector, const DetectOptions& options, int queue_depth);
+
+	// Write one LaneRecord per detected frame; fps gives the record timestamps
+	void setRecordWriter(RecordWriter* writer, double fps) { records = writer; record_fps = fps; }
+
+	// Queue one [FRAME] entry per detected frame; the detect thread never writes it itself
+	void setLogger(Logger* frame_logger) { logger = frame_logger; }
+
+	// Decode, detect and encode on four threads until the input ends; returns the frame count
+	// Writers that are not opened are skipped
+	int run(cv::VideoCapture& cap, cv::VideoWriter& color_writer, cv::VideoWriter& bw_writer, int& flag_plot);
+
+	// Print per-stage busy/stall time and queue occupancy of the last run
+	void printReport() const;
+
+private:
+	struct FrameSlot
+	{
+		cv::Mat frame;
+	};
+
+	struct StageTiming
+	{
+		const char* name;
+		long frames = 0;
+		double busy_ms = 0.0;          // Time spent doing the stage's work
+		double wait_in_ms = 0.0;       // Time blocked on an empty input queue
+		double wait_out_ms = 0.0;      // Time blocked on a full output queue
+		double occupancy_sum = 0.0;    // Input queue fill level sampled at each dequeue
+	};
+
+	LaneDetector& detector;
+	DetectOptions options;
+	int queue_depth;
+	SpscRing<FrameSlot> decoded;     // decode -> detect
+	SpscRing<FrameSlot> color_out;   // detect -> color encoder
+	SpscRing<FrameSlot> edge_out;    // detect -> edge encoder
+	StageTiming decode_timing;
+	StageTiming detect_timing;
+	StageTiming color_timing;
+	StageTiming edge_timing;
+	double wall_ms;
+	RecordWriter* records = nullptr;
+	double record_fps = 0.0;
+	Logger* logger = nullptr;
+
+	void decodeStage(cv::VideoCapture& cap);
+	void detectStage(int& flag_plot);
+	void encodeStage(SpscRing<FrameSlot>& input, cv::VideoWriter& writer, StageTiming& timing);
+};
+
+#endif // FRAME_PIPELINE_H
@@ -0,0 +1,295 @@
+/**
+*@file FrameSource.cpp
+*@brief Y4M reading/writing and the GStreamer appsink input of FrameSource.
+*@brief A Y4M stream is a text header line ("YUV4MPEG2 W1280 H720 F30:1 C420jpeg ...") followed
+*@brief by frames, each a "FRAME" line and the planes Y, U, V one after another.
+*/
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include "FrameSource.h"
+
+namespace {
+
+const char Y4M_MAGIC[] = "YUV4MPEG2";
+const char GST_PREFIX[] = "gst:";
+
+// Header and FRAME lines are short; longer ones are not Y4M
+const size_t MAX_LINE = 1024;
+
+bool endsWith(const std::string& s, const std::string& suffix)
+{
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Read up to and excluding '\n'; false at the end of the file or on an over-long line
+bool readLine(FILE* file, std::string& line)
+{
+    line.clear();
+    int c;
+    while ((c = std::fgetc(file)) != EOF && c != '\n') {
+        if (line.size() >= MAX_LINE)
+            return false;
+        line.push_back(static_cast<char>(c));
+    }
+    return c == '\n';
+}
+
+} // namespace
+
+FrameSource::FrameSource()
+    : frame_layout(LAYOUT_BGR), frame_fps(0.0), y4m(nullptr), frame_bytes(0), store_next(0), gray_valid(false)
+{
+}
+
+FrameSource::~FrameSource()
+{
+    release();
+}
+
+bool FrameSource::isRaw(const std::string& input)
+{
+    return endsWith(input, ".y4m") || FrameStore::isStore(input) || input.compare(0, sizeof(GST_PREFIX) - 1, GST_PREFIX) == 0;
+}
+
+const char* FrameSource::layoutName(Layout layout)
+{
+    switch (layout) {
+    case LAYOUT_GRAY: return "gray";
+    case LAYOUT_I420: return "i420";
+    case LAYOUT_NV12: return "nv12";
+    default:          return "bgr";
+    }
+}
+
+bool FrameSource::open(const std::string& input)
+{
+    release();
+    if (endsWith(input, ".y4m"))
+        return openY4m(input);
+    if (input.compare(0, sizeof(GST_PREFIX) - 1, GST_PREFIX) == 0)
+        return openGStreamer(input.substr(sizeof(GST_PREFIX) - 1));
+    if (FrameStore::isStore(input)) {
+        if (!store.open(input))
+            return false;
+        frame_layout = store.channels() == 1 ? LAYOUT_GRAY : LAYOUT_BGR;
+        frame_size = store.size();
+        frame_fps = store.fps();
+        store_next = 0;
+        return true;
+    }
+
+    frame_layout = LAYOUT_BGR;
+    if (!capture.open(input))
+        return false;
+    frame_size = cv::Size(static_cast<int>(capture.get(cv::CAP_PROP_FRAME_WIDTH)),
+                          static_cast<int>(capture.get(cv::CAP_PROP_FRAME_HEIGHT)));
+    frame_fps = capture.get(cv::CAP_PROP_FPS);
+    return true;
+}
+
+void FrameSource::release()
+{
+    if (y4m != nullptr) {
+        std::fclose(y4m);
+        y4m = nullptr;
+    }
+    capture.release();
+    store.close();
+    buffer.release();
+    luma_plane.release();
+    gray_valid = false;
+}
+
+/**
+*@brief Parse the stream header: W and H are required, F defaults to 30 fps, C to 420jpeg;
+*@brief every 4:2:0 chroma siting is read as I420, mono as gray, other samplings are refused
+*/
+bool FrameSource::openY4m(const std::string& path)
+{
+    y4m = std::fopen(path.c_str(), "rb");
+    if (y4m == nullptr)
+        return false;
+
+    std::string header;
+    if (!readLine(y4m, header) || header.compare(0, sizeof(Y4M_MAGIC) - 1, Y4M_MAGIC) != 0) {
+        release();
+        return false;
+    }
+
+    int width = 0;
+    int height = 0;
+    int fps_num = 30;
+    int fps_den = 1;
+    frame_layout = LAYOUT_I420;
+    std::istringstream tokens(header.substr(sizeof(Y4M_MAGIC) - 1));
+    std::string token;
+    while (tokens >> token) {
+        const char* value = token.c_str() + 1;
+        switch (token[0]) {
+        case 'W': width = std::atoi(value); break;
+        case 'H': height = std::atoi(value); break;
+        case 'F': std::sscanf(value, "%d:%d", &fps_num, &fps_den); break;
+        case 'C':
+            if (std::strcmp(value, "mono") == 0) {
+                frame_layout = LAYOUT_GRAY;
+            } else if (std::strncmp(value, "420", 3) != 0) {
+                release();
+                return false;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    if (width <= 0 || height <= 0 || (frame_layout == LAYOUT_I420 && (width % 2 != 0 || height % 2 != 0))) {
+        release();
+        return false;
+    }
+
+    frame_size = cv::Size(width, height);
+    frame_fps = fps_den > 0 ? static_cast<double>(fps_num) / fps_den : 0.0;
+    int rows = frame_layout == LAYOUT_I420 ? height * 3 / 2 : height;
+    buffer.create(rows, width, CV_8UC1);
+    frame_bytes = static_cast<size_t>(rows) * width;
+    luma_plane = buffer.rowRange(0, height);
+    return true;
+}
+
+/**
+*@brief With RGB conversion off the GStreamer backend returns the appsink buffer as it is:
+*@brief I420/NV12 as one 8-bit image of height * 3 / 2 rows, GRAY8 as the plane itself
+*/
+bool FrameSource::openGStreamer(const std::string& pipeline)
+{
+    frame_layout = LAYOUT_BGR;
+    size_t format = pipeline.rfind("format=");
+    if (format != std::string::npos) {
+        std::string name = pipeline.substr(format + 7, 5);
+        if (name.compare(0, 4, "I420") == 0)
+            frame_layout = LAYOUT_I420;
+        else if (name.compare(0, 4, "NV12") == 0)
+            frame_layout = LAYOUT_NV12;
+        else if (name.compare(0, 5, "GRAY8") == 0)
+            frame_layout = LAYOUT_GRAY;
+    }
+
+    if (!capture.open(pipeline, cv::CAP_GSTREAMER))
+        return false;
+    if (frame_layout != LAYOUT_BGR)
+        capture.set(cv::CAP_PROP_CONVERT_RGB, 0);
+    frame_size = cv::Size(static_cast<int>(capture.get(cv::CAP_PROP_FRAME_WIDTH)),
+                          static_cast<int>(capture.get(cv::CAP_PROP_FRAME_HEIGHT)));
+    frame_fps = capture.get(cv::CAP_PROP_FPS);
+    return true;
+}
+
+bool FrameSource::read()
+{
+    gray_valid = false;
+    if (y4m != nullptr)
+        return readY4m();
+    return store.isOpened() ? readStore() : readCapture();
+}
+
+const cv::Mat& FrameSource::luma() const
+{
+    if (frame_layout != LAYOUT_BGR)
+        return luma_plane;
+    if (!gray_valid && !buffer.empty()) {
+        cv::cvtColor(buffer, gray, cv::COLOR_BGR2GRAY);
+        gray_valid = true;
+    }
+    return gray;
+}
+
+bool FrameSource::readY4m()
+{
+    std::string line;
+    if (!readLine(y4m, line) || line.compare(0, 5, "FRAME") != 0)
+        return false;
+    return std::fread(buffer.data, 1, frame_bytes, y4m) == frame_bytes;
+}
+
+bool FrameSource::readCapture()
+{
+    if (!capture.read(buffer) || buffer.empty())
+        return false;
+
+    // A backend that ignores the RGB conversion setting delivers BGR anyway; take what arrived
+    if (buffer.type() != CV_8UC1)
+        frame_layout = LAYOUT_BGR;
+    if (frame_layout == LAYOUT_BGR) {
+        frame_size = buffer.size();
+        return true;
+    }
+
+    int height = frame_layout == LAYOUT_GRAY ? buffer.rows : buffer.rows * 2 / 3;
+    frame_size = cv::Size(buffer.cols, height);
+    luma_plane = buffer.rowRange(0, height);
+    return true;
+}
+
+// A full frame is a header into the mapping, no bytes are copied; a cropped frame's band is
+// copied into a buffer of its own whose rows above the band stay zero
+bool FrameSource::readStore()
+{
+    if (store_next >= store.frames())
+        return false;
+    if (store.bandTop() > 0)
+        store.frame(store_next++, buffer);
+    else
+        buffer = store.frame(store_next++);
+    if (frame_layout == LAYOUT_GRAY)
+        luma_plane = buffer;
+    return true;
+}
+
+void FrameSource::bgr(cv::Mat& output) const
+{
+    switch (frame_layout) {
+    case LAYOUT_GRAY:
+        cv::cvtColor(buffer, output, cv::COLOR_GRAY2BGR);
+        break;
+    case LAYOUT_I420:
+        cv::cvtColor(buffer, output, cv::COLOR_YUV2BGR_I420);
+        break;
+    case LAYOUT_NV12:
+        cv::cvtColor(buffer, output, cv::COLOR_YUV2BGR_NV12);
+        break;
+    default:
+        buffer.copyTo(output);
+        break;
+    }
+}
+
+int FrameSource::convertToY4m(const std::string& input, const std::string& output, int max_frames)
+{
+    cv::VideoCapture cap(input);
+    if (!cap.isOpened())
+        return -1;
+    FILE* file = std::fopen(output.c_str(), "wb");
+    if (file == nullptr)
+        return -1;
+
+    double fps = cap.get(cv::CAP_PROP_FPS);
+    if (fps <= 0)
+        fps = 30.0;
+    cv::Mat frame;
+    cv::Mat yuv;
+    int frames = 0;
+    while ((max_frames <= 0 || frames < max_frames) && cap.read(frame)) {
+        cv::Rect even(0, 0, frame.cols & ~1, frame.rows & ~1);
+        if (frames == 0) {
+            std::fprintf(file, "%s W%d H%d F%ld:1000 Ip A1:1 C420jpeg\n", Y4M_MAGIC, even.width, even.height,
+                         std::lround(fps * 1000.0));
+        }
+        cv::cvtColor(frame(even), yuv, cv::COLOR_BGR2YUV_I420);
+        std::fputs("FRAME\n", file);
+        std::fwrite(yuv.data, 1, yuv.total(), file);
+        frames++;
+    }
+    std::fclose(file);
+    return frames;
+}
@@ -0,0 +1,86 @@
+/**
+*@file FrameSource.h
+*@brief Input frames in the decoder's native YUV layout, so detection runs on the luma plane.
+*@brief cv::VideoCapture converts every decoded NV12/I420 frame to BGR and the edge stage then
+*@brief reduces it to gray again. FrameSource keeps the decoder's layout: Y4M files (4:2:0 or
+*@brief mono, a local stand-in for the hardware decoder) are read straight into the frame buffer,
+*@brief and "gst:" GStreamer pipelines ending in an appsink with format=I420, NV12 or GRAY8 are
+*@brief read with RGB conversion off. luma() is a Mat header on the Y rows of that buffer;
+*@brief BGR is only produced on request, for plotting and the color video.
+*@brief *.frames raw frame stores (FrameStore) are memory-mapped and their full frames used in place;
+*@brief the band of a cropped store is copied into a frame buffer whose rows above it are zero.
+*@brief Decoder luma is usually limited range (16..235), so the edge threshold cuts slightly
+*@brief lower than on full-range gray; edge_threshold in the config can compensate.
+*/
+#ifndef FRAME_SOURCE_H
+#define FRAME_SOURCE_H
+
+#include <cstdio>
+#include <string>
+#include <opencv2/opencv.hpp>
+#include "FrameStore.h"
+
+class FrameSource
+{
+public:
+	// Layout of the frame buffer: planes are stacked as rows, 4:2:0 buffers have height * 3 / 2 rows
+	enum Layout { LAYOUT_BGR = 0, LAYOUT_GRAY, LAYOUT_I420, LAYOUT_NV12 };
+
+	FrameSource();
+	~FrameSource();
+
+	// *.y4m is read directly, *.frames is mapped, "gst:<pipeline>" opens the pipeline with OpenCV's
+	// GStreamer backend (layout from its last format=), anything else is decoded to BGR by cv::VideoCapture
+	bool open(const std::string& input);
+	bool isOpened() const { return y4m != nullptr || store.isOpened() || capture.isOpened(); }
+	void release();
+
+	// Read the next frame into the buffer; false at the end of the input
+	bool read();
+
+	// 8-bit Y plane of the current frame, sharing the buffer (BGR input is converted to gray)
+	const cv::Mat& luma() const;
+
+	// Image the detector runs on without a conversion: the BGR frame of a BGR input, luma() otherwise
+	const cv::Mat& image() const { return frame_layout == LAYOUT_BGR ? buffer : luma(); }
+
+	// BGR image of the current frame
+	void bgr(cv::Mat& output) const;
+
+	cv::Size size() const { return frame_size; }
+	double fps() const { return frame_fps; }
+	Layout layout() const { return frame_layout; }
+
+	// First row holding frame data; rows above it are zero (frame stores may crop)
+	int bandTop() const { return store.isOpened() ? store.bandTop() : 0; }
+	static const char* layoutName(Layout layout);
+
+	// Whether open() reads this input in its stored layout, without a BGR conversion
+	static bool isRaw(const std::string& input);
+
+	// Convert up to max_frames (0 is all) of a video to Y4M 4:2:0, cropped to even size;
+	// returns the number of frames written, -1 if either file cannot be opened
+	static int convertToY4m(const std::string& input, const std::string& output, int max_frames);
+
+private:
+	Layout frame_layout;
+	cv::Size frame_size;
+	double frame_fps;
+	FILE* y4m;                  // Y4M input
+	size_t frame_bytes;         // Payload of one Y4M frame
+	cv::VideoCapture capture;   // GStreamer and BGR inputs
+	FrameStore store;           // Memory-mapped frame store input
+	int store_next;             // Index of the next store frame
+	cv::Mat buffer;             // Decoder buffer of the current frame
+	cv::Mat luma_plane;         // Header on the Y rows of buffer
+	mutable cv::Mat gray;       // Luma converted from a BGR input, on first use per frame
+	mutable bool gray_valid;    //
+
+	bool openY4m(const std::string& path);
+	bool openGStreamer(const std::string& pipeline);
+	bool readY4m();
+	bool readCapture();
+	bool readStore();
+};
+
+#endif // FRAME_SOURCE_H
@@ -0,0 +1,175 @@
+/**
+*@file FrameStore.cpp
+*@brief Writer and mmap reader of the raw frame store.
+*@brief The file is mapped private and writable: frames are read in place, and a frame the
+*@brief lane is plotted on is copied page by page by the kernel, never written back to the file.
+*/
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "FrameSource.h"
+#include "FrameStore.h"
+
+namespace {
+
+const char STORE_MAGIC[8] = { 'L', 'A', 'N', 'E', 'F', 'R', 'S', '1' };
+const uint32_t STORE_VERSION = 1;
+const uint64_t PAGE = 4096;
+
+uint64_t alignUp(uint64_t n, uint64_t a)
+{
+    return (n + a - 1) / a * a;
+}
+
+bool endsWith(const std::string& s, const std::string& suffix)
+{
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+} // namespace
+
+FrameStore::FrameStore()
+    : base(nullptr), map_size(0), index(nullptr)
+{
+    std::memset(&header, 0, sizeof(header));
+}
+
+FrameStore::~FrameStore()
+{
+    close();
+}
+
+bool FrameStore::isStore(const std::string& path)
+{
+    return endsWith(path, ".frames");
+}
+
+bool FrameStore::open(const std::string& path)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Header)) {
+        ::close(fd);
+        return false;
+    }
+    map_size = static_cast<size_t>(st.st_size);
+    void* p = ::mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        map_size = 0;
+        return false;
+    }
+    base = static_cast<uchar*>(p);
+    std::memcpy(&header, base, sizeof(header));
+
+    // Every frame must lie between the data offset and the index
+    const Header& h = header;
+    uint64_t row_bytes = static_cast<uint64_t>(h.width) * h.channels;
+    bool valid = std::memcmp(h.magic, STORE_MAGIC, sizeof(STORE_MAGIC)) == 0 && h.version == STORE_VERSION &&
+                 (h.channels == 1 || h.channels == 3) && h.width > 0 && h.height > 0 &&
+                 h.band_top >= 0 && h.band_top < h.height &&
+                 h.frame_bytes == row_bytes * (h.height - h.band_top) &&
+                 h.data_offset >= sizeof(Header) &&
+                 h.index_offset + h.frame_count * sizeof(uint64_t) <= map_size;
+    if (valid) {
+        index = reinterpret_cast<const uint64_t*>(base + h.index_offset);
+        for (uint64_t i = 0; valid && i < h.frame_count; i++)
+            valid = index[i] >= h.data_offset && index[i] + h.frame_bytes <= h.index_offset;
+    }
+    if (!valid) {
+        close();
+        return false;
+    }
+    ::madvise(base, map_size, MADV_SEQUENTIAL);
+    return true;
+}
+
+void FrameStore::close()
+{
+    if (base != nullptr)
+        ::munmap(base, map_size);
+    base = nullptr;
+    map_size = 0;
+    index = nullptr;
+    std::memset(&header, 0, sizeof(header));
+}
+
+cv::Mat FrameStore::frame(int i) const
+{
+    CV_Assert(base != nullptr && i >= 0 && i < frames());
+    size_t row_bytes = static_cast<size_t>(header.width) * header.channels;
+    return cv::Mat(header.height - header.band_top, header.width, CV_8UC(header.channels), base + index[i], row_bytes);
+}
+
+void FrameStore::frame(int i, cv::Mat& output) const
+{
+    if (output.size() != size() || output.type() != CV_8UC(header.channels))
+        output = cv::Mat::zeros(size(), CV_8UC(header.channels));
+    frame(i).copyTo(output.rowRange(header.band_top, header.height));
+}
+
+/**
+*@brief The header is written last, once the frame count and index position are known
+*/
+int FrameStore::convert(const std::string& input, const std::string& output, int channels, int band_top, int max_frames)
+{
+    FrameSource source;
+    if ((channels != 1 && channels != 3) || !source.open(input))
+        return -1;
+    FILE* file = std::fopen(output.c_str(), "wb");
+    if (file == nullptr)
+        return -1;
+
+    Header h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, STORE_MAGIC, sizeof(STORE_MAGIC));
+    h.version = STORE_VERSION;
+    h.channels = channels;
+    h.fps = source.fps() > 0 ? source.fps() : 30.0;
+
+    std::vector<uint64_t> offsets;
+    cv::Mat color;
+    bool ok = true;
+    while (ok && (max_frames <= 0 || static_cast<int>(offsets.size()) < max_frames) && source.read()) {
+        if (offsets.empty()) {
+            // Geometry comes from the first frame
+            h.width = source.size().width;
+            h.height = source.size().height;
+            h.band_top = std::min(std::max(band_top, 0), h.height - 1);
+            uint64_t row_bytes = static_cast<uint64_t>(h.width) * channels;
+            h.frame_bytes = row_bytes * (h.height - h.band_top);
+            h.data_offset = alignUp(sizeof(Header), PAGE);
+            ok = std::fseek(file, static_cast<long>(h.data_offset), SEEK_SET) == 0;
+        } else if (source.size() != cv::Size(h.width, h.height)) {
+            break;
+        }
+
+        const cv::Mat* image = &source.luma();
+        if (channels == 3) {
+            source.bgr(color);
+            image = &color;
+        }
+        offsets.push_back(h.data_offset + offsets.size() * h.frame_bytes);
+        for (int y = h.band_top; ok && y < h.height; y++)
+            ok = std::fwrite(image->ptr<uchar>(y), 1, static_cast<size_t>(h.width) * channels, file) ==
+                 static_cast<size_t>(h.width) * channels;
+    }
+
+    h.frame_count = offsets.size();
+    h.index_offset = offsets.empty() ? sizeof(Header) : alignUp(h.data_offset + h.frame_count * h.frame_bytes, sizeof(uint64_t));
+    if (ok && !offsets.empty())
+        ok = std::fseek(file, static_cast<long>(h.index_offset), SEEK_SET) == 0 &&
+             std::fwrite(offsets.data(), sizeof(uint64_t), offsets.size(), file) == offsets.size();
+    if (ok)
+        ok = std::fseek(file, 0, SEEK_SET) == 0 && std::fwrite(&h, sizeof(h), 1, file) == 1;
+    ok = std::fclose(file) == 0 && ok;
+    return ok ? static_cast<int>(offsets.size()) : -1;
+}
@@ -0,0 +1,78 @@
+/**
+*@file FrameStore.h
+*@brief Memory-mapped raw frame file for replaying a recorded clip without decoding it again.
+*@brief Layout: a fixed header, the frames one after another at a page-aligned data offset,
+*@brief and an index of frame offsets at the end. Frames are 8-bit gray (Y) or BGR.
+*@brief A store may hold only the rows from band_top to the bottom of the frame (the lane ROI
+*@brief plus the blur's one-row margin). frame() then returns only those rows; the full-size
+*@brief overload copies them into a frame whose rows above band_top are zero, so such stores are
+*@brief only valid for ROI-mode detection, which never reads those rows.
+*/
+#ifndef FRAME_STORE_H
+#define FRAME_STORE_H
+
+#include <cstdint>
+#include <string>
+#include <opencv2/opencv.hpp>
+
+class FrameStore
+{
+public:
+	// On-disk header, native byte order
+	struct Header
+	{
+		char magic[8];          // "LANEFRS1"
+		uint32_t version;
+		uint32_t channels;      // 1 (Y) or 3 (BGR)
+		int32_t width;
+		int32_t height;
+		int32_t band_top;       // First stored row, 0 for full frames
+		int32_t reserved;
+		double fps;
+		uint64_t frame_count;
+		uint64_t frame_bytes;   // Stored bytes of one frame
+		uint64_t data_offset;   // File offset of the first frame
+		uint64_t index_offset;  // File offset of frame_count uint64 frame offsets
+	};
+
+	FrameStore();
+	~FrameStore();
+
+	// Map a store read-only; false if it cannot be opened or is not a valid store
+	bool open(const std::string& path);
+	bool isOpened() const { return base != nullptr; }
+	void close();
+
+	// Header on the stored rows of frame i in the mapping (bandTop() to the bottom), no copy
+	cv::Mat frame(int i) const;
+
+	// Frame i at full size: the stored rows are copied below bandTop(); output is reallocated,
+	// zero-filled, only when its size or type does not match, so the rows above stay zero
+	void frame(int i, cv::Mat& output) const;
+
+	int frames() const { return static_cast<int>(header.frame_count); }
+	cv::Size size() const { return cv::Size(header.width, header.height); }
+	int channels() const { return static_cast<int>(header.channels); }
+	int bandTop() const { return header.band_top; }
+	double fps() const { return header.fps; }
+
+	static bool isStore(const std::string& path);
+
+	/**
+	*@brief Convert a clip once into a store
+	*@param input is anything FrameSource opens (Y4M and YUV pipelines keep their luma plane)
+	*@param channels is 1 to store the Y plane, 3 to store BGR
+	*@param band_top is the first row to keep (0 keeps full frames), clamped to the frame
+	*@param max_frames limits the frame count, 0 converts all
+	*@return the number of frames written, -1 if either file cannot be opened
+	*/
+	static int convert(const std::string& input, const std::string& output, int channels, int band_top, int max_frames);
+
+private:
+	Header header;
+	uchar* base;                // Mapping of the whole file
+	size_t map_size;
+	const uint64_t* index;      // Frame offsets inside the mapping
+};
+
+#endif // FRAME_STORE_H
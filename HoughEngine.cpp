@@ -0,0 +1,588 @@
+/**
+*@file HoughEngine.cpp
+*@brief Restricted-angle progressive probabilistic Hough transform.
+*@brief
+*@brief The control flow follows OpenCV's HoughLinesProbabilistic step by step (same random
+*@brief generator, point order, rounding and line walk), so with setFullRange() the output is
+*@brief identical to cv::HoughLinesP. With a slope range only the bins of those angles vote:
+*@brief for the lane bands that is 56 of 180 bins, which cuts the voting work by 3x and the
+*@brief accumulator (int16, rho range of the actual image instead of 2*(w+h)) by more.
+*@brief The counters are signed on purpose: like OpenCV, removing a line takes back the votes
+*@brief of all its points, including points that were never drawn, so a bin can go below 0.
+*@brief Results then differ from OpenCV only where a point's strongest bin lies outside the
+*@brief bands, i.e. for lines lineSeparation would discard anyway.
+*@brief
+*@brief The strip interface (beginStrips / voteRow / finishStrips) is a standard, not
+*@brief progressive, Hough transform: every point votes, so row strips can vote in parallel
+*@brief into their own accumulators, and segments are extracted from the merged peaks.
+*@brief
+*@brief detect() also takes a packed EdgeBitmap: its point list replaces the scan of the image
+*@brief and the points still available are kept as bits, so the walk touches 1/8 of the memory.
+*/
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <opencv2/opencv.hpp>
+#include "HoughEngine.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define HOUGH_ENGINE_SSE2 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define HOUGH_ENGINE_NEON 1
+#endif
+
+namespace {
+
+const int SIMD_WIDTH = 4;   // Tables are padded to a multiple of this
+const int LINE_SHIFT = 16;  // Fixed-point fraction bits of the line walk
+
+// cv::RNG's multiply-with-carry generator, seeded like HoughLinesProbabilistic
+class HoughRng
+{
+public:
+    HoughRng() : state(~static_cast<uint64_t>(0)) {}
+
+    int uniform(int a, int b)
+    {
+        state = static_cast<uint64_t>(static_cast<unsigned>(state)) * 4164903690U + static_cast<unsigned>(state >> 32);
+        return a == b ? a : static_cast<int>(static_cast<unsigned>(state) % static_cast<unsigned>(b - a) + a);
+    }
+
+private:
+    uint64_t state;
+};
+
+// Number of angle bins in [0, pi), computed like OpenCV
+int numAngles(double theta)
+{
+    int n = cvFloor(CV_PI / theta) + 1;
+    if (n > 1 && std::fabs(CV_PI - (n - 1) * theta) < theta / 2)
+        --n;
+    return n;
+}
+
+// Points not yet part of a line, one byte per pixel
+struct ByteMask
+{
+    uchar* data;
+    int width;
+
+    bool test(int x, int y) const { return data[y * width + x] != 0; }
+    void clear(int x, int y) { data[y * width + x] = 0; }
+};
+
+// The same, one bit per pixel in the layout of EdgeBitmap
+struct BitMask
+{
+    uint64_t* data;
+    int stride;
+
+    bool test(int x, int y) const { return (data[y * stride + (x >> 6)] >> (x & 63)) & 1; }
+    void clear(int x, int y) { data[y * stride + (x >> 6)] &= ~(1ULL << (x & 63)); }
+};
+
+} // namespace
+
+HoughEngine::HoughEngine()
+    : irho(1.0f), theta(CV_PI / 180), threshold(20), min_length(20), max_gap(30), num_angle(0),
+      min_slope(-1.0), max_slope(-1.0), margin_bins(0), num_rho(0)
+{
+    configure(1, CV_PI / 180, 20, 20, 30);
+}
+
+void HoughEngine::configure(double rho_, double theta_, int threshold_, int min_length_, int max_gap_)
+{
+    // HoughLinesP works in float
+    float rho_f = static_cast<float>(rho_);
+    irho = 1 / rho_f;
+    theta = static_cast<float>(theta_);
+    threshold = threshold_;
+    min_length = min_length_;
+    max_gap = max_gap_;
+    num_angle = numAngles(theta);
+    buildTables();
+}
+
+void HoughEngine::setSlopeRange(double min_slope_, double max_slope_, int margin_bins_)
+{
+    min_slope = min_slope_;
+    max_slope = max_slope_;
+    margin_bins = margin_bins_;
+    buildTables();
+}
+
+void HoughEngine::setFullRange()
+{
+    min_slope = max_slope = -1.0;
+    buildTables();
+}
+
+/**
+*@brief Select the voted angle bins and precompute their sin/cos
+*@brief A bin with normal angle t holds lines of slope -cos(t)/sin(t), so |slope| in
+*@brief [min, max] means the angle to the vertical axis, min(t, pi - t), lies in
+*@brief [atan(1/max), atan(1/min)].
+*/
+void HoughEngine::buildTables()
+{
+    bool full = min_slope < 0;
+    double lo = 0.0;
+    double hi = CV_PI;
+    if (!full) {
+        double margin = margin_bins * theta + 1e-9;
+        lo = std::atan2(1.0, max_slope) - margin;
+        hi = std::atan2(1.0, min_slope) + margin;
+    }
+
+    angles.clear();
+    for (int n = 0; n < num_angle; n++) {
+        double t = static_cast<double>(n) * theta;
+        double from_vertical = std::min(t, CV_PI - t);
+        if (full || (from_vertical >= lo && from_vertical <= hi))
+            angles.push_back(n);
+    }
+
+    int padded = (static_cast<int>(angles.size()) + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+    cos_tab.assign(padded, 0.0f);
+    sin_tab.assign(padded, 0.0f);
+    row_base.assign(padded, 0);
+    bins.assign(padded, 0);
+    for (size_t k = 0; k < angles.size(); k++) {
+        cos_tab[k] = static_cast<float>(std::cos(static_cast<double>(angles[k]) * theta) * irho);
+        sin_tab[k] = static_cast<float>(std::sin(static_cast<double>(angles[k]) * theta) * irho);
+    }
+
+    // Force prepare() to size the accumulator again
+    acc_size = cv::Size();
+}
+
+/**
+*@brief Size the accumulator for the rho range the voted angles can produce on this image
+*/
+void HoughEngine::prepare(cv::Size size)
+{
+    if (size == acc_size)
+        return;
+
+    // |count| stays below the number of pixels in one rho strip, which is < 2 * (w + h)
+    CV_Assert(2 * (size.width + size.height) < 32768);
+
+    int na = static_cast<int>(angles.size());
+    int xs[2] = { 0, size.width - 1 };
+    int ys[2] = { 0, size.height - 1 };
+    int rmin = 0;
+    int rmax = 0;
+    for (int k = 0; k < na; k++) {
+        for (int cx = 0; cx < 2; cx++) {
+            for (int cy = 0; cy < 2; cy++) {
+                int r = cvRound(xs[cx] * cos_tab[k] + ys[cy] * sin_tab[k]);
+                rmin = std::min(rmin, r);
+                rmax = std::max(rmax, r);
+            }
+        }
+    }
+
+    // One spare bin on each side absorbs float rounding between corners and interior points
+    num_rho = rmax - rmin + 3;
+    for (int k = 0; k < na; k++)
+        row_base[k] = k * num_rho - rmin + 1;
+
+    accum.resize(static_cast<size_t>(na) * num_rho);
+    edge_mask.resize(static_cast<size_t>(size.width) * size.height);
+    points.reserve(static_cast<size_t>(size.width) * size.height / 8);
+    acc_size = size;
+}
+
+/**
+*@brief Accumulator index of point (x, y) for every voted angle, written to out
+*/
+void HoughEngine::computeBins(int x, int y, int* out) const
+{
+    int n = static_cast<int>(cos_tab.size());
+    const float* c = cos_tab.data();
+    const float* s = sin_tab.data();
+    const int* base = row_base.data();
+    int k = 0;
+
+#if defined(HOUGH_ENGINE_SSE2)
+    __m128 vx = _mm_set1_ps(static_cast<float>(x));
+    __m128 vy = _mm_set1_ps(static_cast<float>(y));
+    for (; k < n; k += SIMD_WIDTH) {
+        __m128 r = _mm_add_ps(_mm_mul_ps(vx, _mm_loadu_ps(c + k)), _mm_mul_ps(vy, _mm_loadu_ps(s + k)));
+        __m128i idx = _mm_add_epi32(_mm_cvtps_epi32(r), _mm_loadu_si128(reinterpret_cast<const __m128i*>(base + k)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + k), idx);
+    }
+#elif defined(HOUGH_ENGINE_NEON)
+    float32x4_t vx = vdupq_n_f32(static_cast<float>(x));
+    float32x4_t vy = vdupq_n_f32(static_cast<float>(y));
+    for (; k < n; k += SIMD_WIDTH) {
+        // Separate multiply and add, so the result matches the unfused scalar expression
+        float32x4_t r = vaddq_f32(vmulq_f32(vx, vld1q_f32(c + k)), vmulq_f32(vy, vld1q_f32(s + k)));
+        vst1q_s32(out + k, vaddq_s32(vcvtnq_s32_f32(r), vld1q_s32(base + k)));
+    }
+#endif
+
+    for (; k < n; k++)
+        out[k] = cvRound(x * c[k] + y * s[k]) + base[k];
+}
+
+/**
+*@brief Detect line segments; same steps as HoughLinesProbabilistic
+*@param binary is the 8-bit edge image
+*@param lines receives the segments (x1, y1, x2, y2)
+*/
+void HoughEngine::detect(const cv::Mat& binary, std::vector<cv::Vec4i>& lines)
+{
+    CV_Assert(binary.type() == CV_8UC1);
+
+    lines.clear();
+    int width = binary.cols;
+    int height = binary.rows;
+    if (angles.empty() || width == 0 || height == 0)
+        return;
+
+    prepare(binary.size());
+
+    // Collect the edge points in raster order; 8 zero bytes are skipped at once
+    points.clear();
+    uchar* mask0 = edge_mask.data();
+    for (int y = 0; y < height; y++) {
+        const uchar* src = binary.ptr<uchar>(y);
+        uchar* m = mask0 + static_cast<size_t>(y) * width;
+        int x = 0;
+        for (; x + 8 <= width; x += 8) {
+            uint64_t word;
+            std::memcpy(&word, src + x, sizeof(word));
+            if (word == 0) {
+                std::memset(m + x, 0, 8);
+                continue;
+            }
+            for (int i = x; i < x + 8; i++) {
+                m[i] = src[i] != 0;
+                if (src[i])
+                    points.push_back(cv::Point(i, y));
+            }
+        }
+        for (; x < width; x++) {
+            m[x] = src[x] != 0;
+            if (src[x])
+                points.push_back(cv::Point(x, y));
+        }
+    }
+
+    ByteMask mask = { mask0, width };
+    progressive(mask, lines);
+}
+
+/**
+*@brief Same transform on a packed edge image: the point list comes with the bitmap and a copy
+*@brief of its words is the mask of points not yet part of a line, 1/8 of the byte mask
+*@param bitmap is the packed edge image
+*@param lines receives the segments (x1, y1, x2, y2), identical to detect() on the unpacked image
+*/
+void HoughEngine::detect(const EdgeBitmap& bitmap, std::vector<cv::Vec4i>& lines)
+{
+    lines.clear();
+    cv::Size size = bitmap.size();
+    if (angles.empty() || size.area() == 0)
+        return;
+
+    prepare(size);
+    const uint64_t* src = bitmap.row(0);
+    bit_mask.assign(src, src + static_cast<size_t>(bitmap.wordsPerRow()) * size.height);
+    points.assign(bitmap.points().begin(), bitmap.points().end());
+
+    BitMask mask = { bit_mask.data(), bitmap.wordsPerRow() };
+    progressive(mask, lines);
+}
+
+/**
+*@brief Random-order voting and line walk of HoughLinesProbabilistic over points and the mask
+*@brief of points still available (test / clear of pixel x, y); the accumulator is cleared here
+*/
+template <typename Mask>
+void HoughEngine::progressive(Mask& mask, std::vector<cv::Vec4i>& lines)
+{
+    int width = acc_size.width;
+    int height = acc_size.height;
+    int na = static_cast<int>(angles.size());
+    std::fill(accum.begin(), accum.end(), static_cast<short>(0));
+
+    HoughRng rng;
+    short* acc = accum.data();
+    const int* bin = bins.data();
+
+    for (int count = static_cast<int>(points.size()); count > 0; count--) {
+        // Draw a random point and remove it by overwriting it with the last one
+        int idx = rng.uniform(0, count);
+        cv::Point point = points[idx];
+        points[idx] = points[count - 1];
+        int i = point.y;
+        int j = point.x;
+
+        // Already part of an extracted line
+        if (!mask.test(j, i))
+            continue;
+
+        // Vote and find the most probable line through the point
+        computeBins(j, i, bins.data());
+        int max_val = threshold - 1;
+        int max_k = 0;
+        for (int k = 0; k < na; k++) {
+            int val = ++acc[bin[k]];
+            if (max_val < val) {
+                max_val = val;
+                max_k = k;
+            }
+        }
+        if (max_val < threshold)
+            continue;
+
+        // Walk from the point in both directions along the line to find the segment ends
+        float a = -sin_tab[max_k];
+        float b = cos_tab[max_k];
+        int x0 = j;
+        int y0 = i;
+        int dx0;
+        int dy0;
+        bool xflag;
+        if (std::fabs(a) > std::fabs(b)) {
+            xflag = true;
+            dx0 = a > 0 ? 1 : -1;
+            dy0 = cvRound(b * (1 << LINE_SHIFT) / std::fabs(a));
+            y0 = (y0 << LINE_SHIFT) + (1 << (LINE_SHIFT - 1));
+        } else {
+            xflag = false;
+            dy0 = b > 0 ? 1 : -1;
+            dx0 = cvRound(a * (1 << LINE_SHIFT) / std::fabs(b));
+            x0 = (x0 << LINE_SHIFT) + (1 << (LINE_SHIFT - 1));
+        }
+
+        cv::Point line_end[2];
+        for (int k = 0; k < 2; k++) {
+            int gap = 0;
+            int x = x0;
+            int y = y0;
+            int dx = k > 0 ? -dx0 : dx0;
+            int dy = k > 0 ? -dy0 : dy0;
+
+            // Stop at the image border or when the gap gets too big
+            for (;; x += dx, y += dy) {
+                int j1 = xflag ? x : x >> LINE_SHIFT;
+                int i1 = xflag ? y >> LINE_SHIFT : y;
+                if (j1 < 0 || j1 >= width || i1 < 0 || i1 >= height)
+                    break;
+
+                if (mask.test(j1, i1)) {
+                    gap = 0;
+                    line_end[k] = cv::Point(j1, i1);
+                } else if (++gap > max_gap) {
+                    break;
+                }
+            }
+        }
+
+        bool good_line = std::abs(line_end[1].x - line_end[0].x) >= min_length ||
+                         std::abs(line_end[1].y - line_end[0].y) >= min_length;
+
+        // Walk again to clear the segment's points, and take back their votes if it is kept
+        for (int k = 0; k < 2; k++) {
+            int x = x0;
+            int y = y0;
+            int dx = k > 0 ? -dx0 : dx0;
+            int dy = k > 0 ? -dy0 : dy0;
+
+            for (;; x += dx, y += dy) {
+                int j1 = xflag ? x : x >> LINE_SHIFT;
+                int i1 = xflag ? y >> LINE_SHIFT : y;
+
+                if (mask.test(j1, i1)) {
+                    if (good_line) {
+                        computeBins(j1, i1, bins.data());
+                        for (int n = 0; n < na; n++)
+                            acc[bin[n]]--;
+                    }
+                    mask.clear(j1, i1);
+                }
+
+                if (i1 == line_end[k].y && j1 == line_end[k].x)
+                    break;
+            }
+        }
+
+        if (good_line)
+            lines.push_back(cv::Vec4i(line_end[0].x, line_end[0].y, line_end[1].x, line_end[1].y));
+    }
+}
+
+/**
+*@brief Size one accumulator per strip for this image and clear them
+*/
+void HoughEngine::beginStrips(cv::Size size, int strip_count)
+{
+    prepare(size);
+    size_t cells = accum.size();
+    strips.resize(std::max(strip_count, 1));
+    for (StripVotes& sv : strips) {
+        sv.accum.assign(cells, 0);
+        sv.bins.resize(bins.size());
+    }
+}
+
+/**
+*@brief Vote every edge point of one row into the strip's accumulator and mark it in edge_mask
+*@param row is the binary image row y, acc_size.width pixels
+*/
+void HoughEngine::voteRow(int strip, int y, const uchar* row)
+{
+    StripVotes& sv = strips[strip];
+    short* acc = sv.accum.data();
+    int* bin = sv.bins.data();
+    int na = static_cast<int>(angles.size());
+    int width = acc_size.width;
+    uchar* m = edge_mask.data() + static_cast<size_t>(y) * width;
+
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        uint64_t word;
+        std::memcpy(&word, row + x, sizeof(word));
+        if (word == 0) {
+            std::memset(m + x, 0, 8);
+            continue;
+        }
+        for (int i = x; i < x + 8; i++) {
+            m[i] = row[i] != 0;
+            if (!row[i])
+                continue;
+            computeBins(i, y, bin);
+            for (int k = 0; k < na; k++)
+                acc[bin[k]]++;
+        }
+    }
+    for (; x < width; x++) {
+        m[x] = row[x] != 0;
+        if (!row[x])
+            continue;
+        computeBins(x, y, bin);
+        for (int k = 0; k < na; k++)
+            acc[bin[k]]++;
+    }
+}
+
+/**
+*@brief Merge the strip accumulators, find the peaks and extract their segments
+*@param lines receives the segments, strongest peak first
+*@param offset is added to every segment (frame position of the image origin)
+*/
+void HoughEngine::finishStrips(std::vector<cv::Vec4i>& lines, cv::Point offset)
+{
+    lines.clear();
+    int na = static_cast<int>(angles.size());
+    if (na == 0 || strips.empty() || acc_size.area() == 0)
+        return;
+
+    // Sum of the strips; no bin can exceed the pixels of one rho strip, so int16 holds it
+    short* acc = accum.data();
+    size_t cells = accum.size();
+    std::copy(strips[0].accum.begin(), strips[0].accum.end(), accum.begin());
+    for (size_t s = 1; s < strips.size(); s++) {
+        const short* src = strips[s].accum.data();
+        for (size_t i = 0; i < cells; i++)
+            acc[i] += src[i];
+    }
+
+    // Local maxima over the neighbouring angle and rho bins; ties go to the lower index
+    peaks.clear();
+    for (int k = 0; k < na; k++) {
+        const short* row = acc + static_cast<size_t>(k) * num_rho;
+        for (int r = 1; r + 1 < num_rho; r++) {
+            int v = row[r];
+            if (v < threshold || v <= row[r - 1] || v < row[r + 1])
+                continue;
+            if (k > 0 && angles[k - 1] + 1 == angles[k] && v <= row[r - num_rho])
+                continue;
+            if (k + 1 < na && angles[k + 1] == angles[k] + 1 && v < row[r + num_rho])
+                continue;
+            peaks.push_back(cv::Vec3i(v, k, r));
+        }
+    }
+    std::sort(peaks.begin(), peaks.end(), [](const cv::Vec3i& a, const cv::Vec3i& b) {
+        if (a[0] != b[0])
+            return a[0] > b[0];
+        return a[1] != b[1] ? a[1] < b[1] : a[2] < b[2];
+    });
+
+    for (const cv::Vec3i& p : peaks)
+        walkPeak(p[1], p[2], lines, offset);
+}
+
+/**
+*@brief Walk the line of accumulator bin (k, r) across the image and keep the runs of edge points
+*@brief that are not yet part of a line; a run ends after more than max_gap steps without a point
+*@brief and becomes a segment if it spans min_length pixels in x or y. Its points are then taken
+*@brief out of edge_mask, so weaker peaks of the same line do not report it again.
+*/
+void HoughEngine::walkPeak(int k, int r, std::vector<cv::Vec4i>& lines, cv::Point offset)
+{
+    int width = acc_size.width;
+    int height = acc_size.height;
+    uchar* mask0 = edge_mask.data();
+
+    // Points of the bin satisfy round(x * c + y * s) = rho
+    double c = cos_tab[k];
+    double s = sin_tab[k];
+    double rho = r - (row_base[k] - k * num_rho);
+
+    // Step along the longer axis of the line: one pixel per step on it, the other one follows
+    bool along_x = std::fabs(s) >= std::fabs(c);
+    int steps = along_x ? width : height;
+
+    // A point counts if it is on the line or next to it across the walk, which absorbs the
+    // quantization of the angle and rho bins on long lines
+    auto hitAt = [&](int t, cv::Point& pt) {
+        double f = along_x ? (rho - t * c) / s : (rho - t * s) / c;
+        int centre = cvRound(f);
+        for (int d = 0; d < 3; d++) {
+            int u = centre + (d == 0 ? 0 : (d == 1 ? -1 : 1));
+            pt = along_x ? cv::Point(t, u) : cv::Point(u, t);
+            if (pt.x >= 0 && pt.x < width && pt.y >= 0 && pt.y < height &&
+                mask0[static_cast<size_t>(pt.y) * width + pt.x])
+                return true;
+        }
+        return false;
+    };
+
+    int start = -1;
+    int last = -1;
+    cv::Point first_pt;
+    cv::Point last_pt;
+    for (int t = 0; t <= steps; t++) {
+        cv::Point pt;
+        if (t < steps && hitAt(t, pt)) {
+            if (start < 0) {
+                start = t;
+                first_pt = pt;
+            }
+            last = t;
+            last_pt = pt;
+            continue;
+        }
+        if (start < 0 || (t < steps && t - last <= max_gap))
+            continue;
+
+        // The run ended
+        if (std::abs(last_pt.x - first_pt.x) >= min_length || std::abs(last_pt.y - first_pt.y) >= min_length) {
+            for (int u = start; u <= last; u++) {
+                cv::Point q;
+                while (hitAt(u, q))
+                    mask0[static_cast<size_t>(q.y) * width + q.x] = 0;
+            }
+            lines.push_back(cv::Vec4i(first_pt.x + offset.x, first_pt.y + offset.y,
+                                      last_pt.x + offset.x, last_pt.y + offset.y));
+        }
+        start = -1;
+    }
+}
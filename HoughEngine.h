@@ -0,0 +1,90 @@
+/**
+*@file HoughEngine.h
+*@brief Progressive probabilistic Hough transform restricted to lane-plausible angles.
+*@brief Same algorithm as cv::HoughLinesP (random point order, vote, walk the line, remove
+*@brief its votes), but the accumulator only holds the angle bins of the bands lineSeparation
+*@brief keeps, uses int16 counters sized for the image, and the per-point rho bins are
+*@brief computed with SIMD from precomputed sin/cos tables.
+*/
+#ifndef HOUGH_ENGINE_H
+#define HOUGH_ENGINE_H
+
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "EdgeBitmap.h"
+
+class HoughEngine
+{
+public:
+	HoughEngine();
+
+	// Same meaning as the arguments of cv::HoughLinesP
+	void configure(double rho, double theta, int threshold, int min_length, int max_gap);
+
+	// Keep only the angle bins whose line |slope| (dy/dx) is inside [min_slope, max_slope],
+	// widened by margin_bins on each side so segments near the limits are still found
+	void setSlopeRange(double min_slope, double max_slope, int margin_bins = 2);
+
+	// Vote over all angles; the output is then identical to cv::HoughLinesP
+	void setFullRange();
+
+	// Detect line segments in a binary image (any non-zero pixel is an edge point)
+	void detect(const cv::Mat& binary, std::vector<cv::Vec4i>& lines);
+
+	// Same as detect() on the unpacked image, driven by the bitmap's edge point list
+	void detect(const EdgeBitmap& bitmap, std::vector<cv::Vec4i>& lines);
+
+	// Strip-parallel standard Hough over the same angle bins. The rows of the image are split
+	// into strips that vote into one accumulator each: every strip must be voted by a single
+	// thread, different strips may vote concurrently. finishStrips() sums the accumulators,
+	// takes the local maxima above the threshold, strongest first, and walks each peak's line
+	// for segments with the min_length / max_gap rules of detect(). The result does not depend
+	// on the number of strips or on the order in which they were voted.
+	void beginStrips(cv::Size size, int strips);
+	void voteRow(int strip, int y, const uchar* row);
+	void finishStrips(std::vector<cv::Vec4i>& lines, cv::Point offset = cv::Point());
+
+	int angleBins() const { return static_cast<int>(angles.size()); }
+	int totalAngleBins() const { return num_angle; }
+
+private:
+	float irho;
+	double theta;
+	int threshold;
+	int min_length;
+	int max_gap;
+	int num_angle;                  // Bins of the full [0, pi) range
+	double min_slope;               // Slope band; min_slope < 0 means full range
+	double max_slope;
+	int margin_bins;
+
+	std::vector<int> angles;        // Angle bins voted for, ascending
+	std::vector<float> cos_tab;     // cos/sin of those bins divided by rho
+	std::vector<float> sin_tab;
+	std::vector<int> row_base;      // Offset of each angle's accumulator row minus the smallest rho
+
+	cv::Size acc_size;              // Image size the accumulator was sized for
+	int num_rho;
+	std::vector<short> accum;       // angles.size() x num_rho vote counters (may go negative)
+	std::vector<uchar> edge_mask;   // 1 while an edge point is not yet part of a line
+	std::vector<uint64_t> bit_mask; // Same for a packed input, in the EdgeBitmap layout
+	std::vector<cv::Point> points;  // Edge points still to be drawn
+	std::vector<int> bins;          // Accumulator indices of the current point
+
+	struct StripVotes
+	{
+		std::vector<short> accum;   // Votes of the strip's rows
+		std::vector<int> bins;      // Accumulator indices of the strip's current point
+	};
+	std::vector<StripVotes> strips; // Per-strip state of the strip-parallel transform
+	std::vector<cv::Vec3i> peaks;   // (votes, angle index, rho bin) of the merged accumulator
+
+	void buildTables();
+	void prepare(cv::Size size);
+	void computeBins(int x, int y, int* out) const;
+	template <typename Mask>
+	void progressive(Mask& mask, std::vector<cv::Vec4i>& lines);
+	void walkPeak(int k, int r, std::vector<cv::Vec4i>& lines, cv::Point offset);
+};
+
+#endif // HOUGH_ENGINE_H
@@ -5,58 +5,201 @@
 *@brief The class will take RGB images as inputs and will output the same RGB image but
 *@brief with the plot of the detected lanes and the turn prediction.
 */
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <string>
 #include <vector>
 #include <opencv2/opencv.hpp>   
-#include <chrono>
-#include <iostream>
 #include "LaneDetector.h"
+#include "ThreadPool.h"
 
-// 全局变量用于记录模块执行时间
-std::chrono::high_resolution_clock::time_point module_start_time;
-std::chrono::high_resolution_clock::time_point module_end_time;
-double total_denoise_time = 0.0;
-double total_edge_detection_time = 0.0;
-double total_mask_time = 0.0;
-double total_hough_time = 0.0;
-double total_line_separation_time = 0.0;
-double total_regression_time = 0.0;
-double total_predict_time = 0.0;
-double total_plot_time = 0.0;
-int frame_count = 0;
-
-// 时间测量函数
-void start_timer() {
-    module_start_time = std::chrono::high_resolution_clock::now();
-}
-
-double end_timer() {
-    module_end_time = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(module_end_time - module_start_time);
-    return duration.count() / 1000.0; // 转换为毫秒
-}
-
-// 打印性能统计信息
-void print_performance_stats() {
-    if (frame_count > 0) {
-        std::cout << "=== 性能统计信息 ===" << std::endl;
-        std::cout << "总帧数: " << frame_count << std::endl;
-        std::cout << "平均去噪时间: " << total_denoise_time / frame_count << " ms" << std::endl;
-        std::cout << "平均边缘检测时间: " << total_edge_detection_time / frame_count << " ms" << std::endl;
-        std::cout << "平均掩码时间: " << total_mask_time / frame_count << " ms" << std::endl;
-        std::cout << "平均Hough变换时间: " << total_hough_time / frame_count << " ms" << std::endl;
-        std::cout << "平均线分离时间: " << total_line_separation_time / frame_count << " ms" << std::endl;
-        std::cout << "平均回归时间: " << total_regression_time / frame_count << " ms" << std::endl;
-        std::cout << "平均预测时间: " << total_predict_time / frame_count << " ms" << std::endl;
-        std::cout << "平均绘制时间: " << total_plot_time / frame_count << " ms" << std::endl;
-        
-        double total_avg_time = (total_denoise_time + total_edge_detection_time + total_mask_time + 
-                                total_hough_time + total_line_separation_time + total_regression_time + 
-                                total_predict_time + total_plot_time) / frame_count;
-        std::cout << "平均总处理时间: " << total_avg_time << " ms" << std::endl;
-        std::cout << "理论最大帧率: " << 1000.0 / total_avg_time << " FPS" << std::endl;
-        std::cout << "===================" << std::endl;
-    }
+namespace {
+
+// Fitted lines flatter than this (|dy/dx|) cannot be intersected with the lane rows and are rejected
+const double MIN_FIT_SLOPE = 1e-3;
+
+// Slopes of (near) vertical lines are clamped to this so the line equations stay finite
+const double MAX_FIT_SLOPE = 1e4;
+
+// dy/dx clamped to +-MAX_FIT_SLOPE; a vertical line (dx == 0) gets +MAX_FIT_SLOPE
+double boundedSlope(double dy, double dx)
+{
+    if (std::fabs(dx) * MAX_FIT_SLOPE <= std::fabs(dy))
+        return dx * dy < 0 ? -MAX_FIT_SLOPE : MAX_FIT_SLOPE;
+    return dy / dx;
+}
+
+// Column of the line through b with slope m at row y; a flat line keeps its column
+double lineX(double m, const cv::Point& b, double y)
+{
+    if (std::fabs(m) < MIN_FIT_SLOPE)
+        return b.x;
+    return (y - b.y) / m + b.x;
+}
+
+// Standard Hough transform of the engine on the calling thread: one strip voted row by row
+void standardHough(HoughEngine& engine, const cv::Mat& binary, std::vector<cv::Vec4i>& lines)
+{
+    engine.beginStrips(binary.size(), 1);
+    for (int y = 0; y < binary.rows; y++)
+        engine.voteRow(0, y, binary.ptr<uchar>(y));
+    engine.finishStrips(lines);
+}
+
+} // namespace
+
+LaneDetector::LaneDetector()
+{
+    band_spans.reserve(2048);
+    strip.reserve(64);
+    setConfig(LaneDetectorConfig());
+    // Until the first frame arrives the geometry is that of the reference 1280x720 frame
+    prepare(cv::Size(1280, 720));
+}
+
+/**
+*@brief Replace the tuning; the per-resolution values are rebuilt by the next prepare()
+*@param cfg is the new configuration
+*/
+void LaneDetector::setConfig(const LaneDetectorConfig& cfg)
+{
+    config = cfg;
+    hough_engine.setSlopeRange(config.slope_min, config.slope_max);
+    coarse_engine.setSlopeRange(config.slope_min, config.slope_max);
+    change_gate.configure(config.gate_threshold, config.gate_max_reuse, config.gate_step);
+    geometry_size = cv::Size();
+    mask_image.release();
+}
+
+LaneDetector::~LaneDetector()
+{
+}
+
+/**
+*@brief Return the per-stream state to that of a new detector; tuning, modes and buffers are kept
+*/
+void LaneDetector::resetStream()
+{
+    lane_tracker.reset();
+    change_gate.reset();
+    left_flag = false;
+    right_flag = false;
+    right_b = cv::Point();
+    right_m = 1.0;
+    left_b = cv::Point();
+    left_m = -1.0;
+    coarse_lines = false;
+}
+
+/**
+*@brief Start or stop the strip-parallel path; the pool is kept until the thread count changes
+*@param threads is the number of strips and workers, 0 disables the path
+*/
+void LaneDetector::setFrameThreads(int threads)
+{
+    threads = std::max(threads, 0);
+    if (threads == frame_threads)
+        return;
+    frame_threads = threads;
+    strip_pool.reset(threads > 1 ? new ThreadPool(threads) : nullptr);
+    strip_kernels.assign(std::max(threads, 1), FusedEdgeKernel());
+    strip_rows.clear();
+}
+
+/**
+*@brief Select the coarse-to-fine scale; the coarse parameters are rebuilt by the next prepare()
+*@param factor is the downsampling factor, clamped to 1..4
+*/
+void LaneDetector::setScale(int factor)
+{
+    scale_factor = std::min(std::max(factor, 1), 4);
+    geometry_size = cv::Size();
+}
+
+// 预留足够容量，稳态下各阶段不再触发堆分配
+FrameWorkspace::FrameWorkspace()
+    : left_right_lines(2), lane(4)
+{
+    lines.reserve(1024);
+    left_right_lines[0].reserve(1024);
+    left_right_lines[1].reserve(1024);
+    poly_points.reserve(4);
+    turn.reserve(16);
+
+    // Create the kernel [-1 0 1]
+    // This kernel is based on the one found in the
+    // Lane Departure Warning System by Mathworks
+    filter_kernel = cv::Mat(1, 3, CV_32F);
+    filter_kernel.at<float>(0, 0) = -1;
+    filter_kernel.at<float>(0, 1) = 0;
+    filter_kernel.at<float>(0, 2) = 1;
+}
+
+// PER-RESOLUTION PRECOMPUTATION
+/**
+*@brief Turn the configuration into pixel values for one input resolution
+*@brief Everything that depends on the frame size is computed here, once per resolution,
+*@brief so the stages themselves only read precomputed members
+*@param frame_size is the size of the input frames
+*/
+void LaneDetector::prepare(cv::Size frame_size)
+{
+    if (frame_size == geometry_size)
+        return;
+
+    double w = frame_size.width;
+    double h = frame_size.height;
+    double scale = config.pixelScale(frame_size.height);
+
+    for (int i = 0; i < 4; i++)
+        roi_points[i] = cv::Point(cvRound(config.roi_polygon[i].x * w), cvRound(config.roi_polygon[i].y * h));
+    std::vector<cv::Point> pts(roi_points, roi_points + 4);
+    roi_rect = cv::boundingRect(pts) & cv::Rect(0, 0, frame_size.width, frame_size.height);
+
+    img_size = w;
+    img_center = config.center_x * w;
+    center_split = cvRound(config.center_x * w);
+    lane_top = cvRound(config.lane_top_y * h);
+    turn_threshold = config.turn_threshold * scale;
+    huber_k = config.fit_huber_k * scale;
+
+    // Votes and lengths are proportional to the line length in pixels
+    hough_threshold = std::max(1, cvRound(config.hough_threshold * scale));
+    hough_min_length = std::max(1, cvRound(config.hough_min_length * scale));
+    hough_max_gap = std::max(0, cvRound(config.hough_max_gap * scale));
+    hough_engine.configure(config.hough_rho, config.hough_theta, hough_threshold, hough_min_length, hough_max_gap);
+
+    // The coarse image sees every length divided by the scale factor
+    coarse_threshold = std::max(1, cvRound(hough_threshold / static_cast<double>(scale_factor)));
+    coarse_min_length = std::max(1, cvRound(hough_min_length / static_cast<double>(scale_factor)));
+    coarse_max_gap = std::max(0, cvRound(hough_max_gap / static_cast<double>(scale_factor)));
+    coarse_engine.configure(config.hough_rho, config.hough_theta, coarse_threshold, coarse_min_length, coarse_max_gap);
+    coarse_mask.release();
+
+    lane_tracker.setPixelScale(scale);
+    mask_image.release();
+    strip_rows.clear();
+    geometry_size = frame_size;
+}
+
+/**
+*@brief Get the region that is processed for frames of the given size
+*@param frame_size is the size of the input frames
+*@return The trapezoid bounding box in ROI mode, the whole frame otherwise
+*/
+cv::Rect LaneDetector::roi(cv::Size frame_size)
+{
+    prepare(frame_size);
+    if (!roi_mode)
+        return cv::Rect(0, 0, frame_size.width, frame_size.height);
+    return roi_rect;
+}
+
+cv::Rect LaneDetector::laneBounds(cv::Size frame_size)
+{
+    prepare(frame_size);
+    return roi_rect;
 }
 
 // IMAGE BLURRING
@@ -64,18 +207,20 @@ void print_performance_stats() {
 *@brief Apply gaussian filter to the input image to denoise it
 *@param inputImage is the frame of a video in which the
 *@param lane is going to be detected
-*@return Blurred and denoised image
+*@param output receives the blurred and denoised image, its buffer is reused
 */
-cv::Mat LaneDetector::deNoise(cv::Mat inputImage) 
+void LaneDetector::deNoise(const cv::Mat& inputImage, cv::Mat& output) 
 {
-    start_timer();
+    ScopedStageTimer timer(perf_stats, STAGE_DENOISE);
     
+    // In ROI mode blur only the bounding box; pixels around it still act as real neighbours
+    cv::GaussianBlur(inputImage(roi(inputImage.size())), output, cv::Size(3, 3), 0, 0);
+}
+
+cv::Mat LaneDetector::deNoise(cv::Mat inputImage) 
+{
     cv::Mat output;
-    cv::GaussianBlur(inputImage, output, cv::Size(3, 3), 0, 0);
-    
-    double elapsed = end_timer();
-    total_denoise_time += elapsed;
-    
+    deNoise(inputImage, output);
     return output;
 }
 
@@ -83,37 +228,219 @@ cv::Mat LaneDetector::deNoise(cv::Mat inputImage)
 /**
 *@brief Detect all the edges in the blurred frame by filtering the image
 *@param img_noise is the previously blurred frame
-*@return Binary image with only the edges represented in white
+*@param output receives the binary image with only the edges represented in white
 */
-cv::Mat LaneDetector::edgeDetector(cv::Mat img_noise) 
+void LaneDetector::edgeDetector(const cv::Mat& img_noise, cv::Mat& output) 
 {
-    start_timer();
+    ScopedStageTimer timer(perf_stats, STAGE_EDGE);
+    perf_stats.countFrame();
     
-    cv::Mat output;
-    cv::Mat kernel;
-    cv::Point anchor;
+    cv::Point anchor = cv::Point(-1, -1);
 
-    // Convert image from RGB to gray
-    cv::cvtColor(img_noise, output, cv::COLOR_RGB2GRAY);
-    // Binarize gray image
-    cv::threshold(output, output, 140, 255, cv::THRESH_BINARY);
+    // Convert image from BGR to gray; a luma plane is gray already
+    if (img_noise.channels() == 1) {
+        cv::threshold(img_noise, work.gray, config.edge_threshold, 255, cv::THRESH_BINARY);
+    } else {
+        cv::cvtColor(img_noise, work.gray, cv::COLOR_BGR2GRAY);
+        // Binarize gray image
+        cv::threshold(work.gray, work.gray, config.edge_threshold, 255, cv::THRESH_BINARY);
+    }
 
-    // Create the kernel [-1 0 1]
-    // This kernel is based on the one found in the
-    // Lane Departure Warning System by Mathworks
-    anchor = cv::Point(-1, -1);
-    kernel = cv::Mat(1, 3, CV_32F);
-    kernel.at<float>(0, 0) = -1;
-    kernel.at<float>(0, 1) = 0;
-    kernel.at<float>(0, 2) = 1;
-
-    // Filter the binary image to obtain the edges
-    cv::filter2D(output, output, -1, kernel, anchor, 0, cv::BORDER_DEFAULT);
+    // Filter the binary image with the [-1 0 1] kernel to obtain the edges
+    cv::filter2D(work.gray, output, -1, work.filter_kernel, anchor, 0, cv::BORDER_DEFAULT);
     // 移除显示：cv::imshow("output", output);
-    
-    double elapsed = end_timer();
-    total_edge_detection_time += elapsed;
-    
+}
+
+cv::Mat LaneDetector::edgeDetector(cv::Mat img_noise) 
+{
+    cv::Mat output;
+    edgeDetector(img_noise, output);
+    return output;
+}
+
+// FUSED DENOISE + EDGE DETECTION
+/**
+*@brief Single-pass replacement for edgeDetector(deNoise(inputImage))
+*@brief The 3x3 Gaussian, gray conversion, threshold and [-1 0 1] filter are computed row by row
+*@brief with integer arithmetic, without the intermediate blurred and gray images
+*@param inputImage is the frame of a video in which the lane is going to be detected
+*@param output receives the binary image with only the edges represented in white
+*/
+void LaneDetector::fusedEdgeDetector(const cv::Mat& inputImage, cv::Mat& output)
+{
+    ScopedStageTimer timer(perf_stats, STAGE_EDGE);
+    perf_stats.countFrame();
+
+    edge_kernel.run(inputImage, roi(inputImage.size()), output, config.edge_threshold);
+}
+
+// COARSE EDGE DETECTION
+/**
+*@brief Edge image of the ROI at 1/scale_factor resolution for the coarse-to-fine mode
+*@brief The area average of each block replaces the Gaussian blur of deNoise
+*@param inputImage is the frame of a video in which the lane is going to be detected
+*@param output receives the coarse binary edge image
+*/
+void LaneDetector::pyramidEdgeDetector(const cv::Mat& inputImage, cv::Mat& output)
+{
+    ScopedStageTimer timer(perf_stats, STAGE_EDGE);
+    perf_stats.countFrame();
+
+    coarse_area = roi(inputImage.size());
+    edge_kernel.runDownsampled(inputImage, coarse_area, scale_factor, output, config.edge_threshold);
+
+    // The coarse mask only changes with the geometry (prepare() releases it)
+    if (coarse_mask.size() != output.size()) {
+        cv::Point pts[4];
+        for (int i = 0; i < 4; i++) {
+            pts[i] = cv::Point(cvFloor((roi_points[i].x - coarse_area.x) / static_cast<double>(scale_factor)),
+                               cvFloor((roi_points[i].y - coarse_area.y) / static_cast<double>(scale_factor)));
+        }
+        coarse_mask = cv::Mat::zeros(output.size(), CV_8UC1);
+        cv::fillConvexPoly(coarse_mask, pts, 4, cv::Scalar(255, 0, 0));
+    }
+}
+
+// STRIP-PARALLEL DETECTION
+/**
+*@brief Fused edge detection and mask split over row strips of the ROI, then the configured Hough
+*@brief Only the mask run of each row is computed (the kernel reads real neighbours, so it equals
+*@brief the masked full edge image). In HOUGH_STANDARD mode each strip votes into its own
+*@brief accumulator and the merge, peak search and segment walk run once all strips are done;
+*@brief the other modes run houghLines on the merged image. The strips are cut so that each
+*@brief holds about the same mask area, since the trapezoid is much wider at the bottom.
+*@param inputImage is the frame of a video in which the lane is going to be detected
+*@param output receives the masked edges: the ROI bounding box in ROI mode, else the whole frame
+*@param lines receives the Hough segments in frame coordinates
+*/
+void LaneDetector::parallelDetect(const cv::Mat& inputImage, cv::Mat& output, std::vector<cv::Vec4i>& lines)
+{
+    prepare(inputImage.size());
+    cv::Rect area = roi_rect;
+    int count = std::max(frame_threads, 1);
+    bool vote = hough_mode == HOUGH_STANDARD;
+    coarse_lines = false;
+    {
+        ScopedStageTimer timer(perf_stats, STAGE_EDGE);
+        perf_stats.countFrame();
+
+        updateMask(area.size(), area.tl());
+        // Same geometry as the serial stages, so houghLines sees the same image
+        cv::Point origin;
+        if (roi_mode) {
+            output.create(area.size(), CV_8UC1);
+        } else {
+            output.create(inputImage.size(), CV_8UC1);
+            output.setTo(cv::Scalar(0));
+            origin = area.tl();
+        }
+        if (vote) {
+            hough_engine.beginStrips(output.size(), count);
+            // Rows outside the box hold no edges but still reset their rows of the engine
+            for (int y = 0; y < output.rows; y++) {
+                if (y < origin.y || y >= origin.y + area.height)
+                    hough_engine.voteRow(0, y, output.ptr<uchar>(y));
+            }
+        }
+
+        // Rows of equal mask area per strip; recomputed only with the geometry
+        if (static_cast<int>(strip_rows.size()) != count || strip_rows.back()[1] != area.height) {
+            long total = 0;
+            for (int y = 0; y < area.height; y++)
+                total += mask_rows[y][1] - mask_rows[y][0];
+            strip_rows.assign(count, cv::Vec2i(area.height, area.height));
+            long acc = 0;
+            int s = 0;
+            strip_rows[0][0] = 0;
+            for (int y = 0; y < area.height && s + 1 < count; y++) {
+                acc += mask_rows[y][1] - mask_rows[y][0];
+                if (acc * count >= total * (s + 1)) {
+                    strip_rows[s][1] = y + 1;
+                    strip_rows[++s][0] = y + 1;
+                }
+            }
+            strip_rows[s][1] = area.height;
+        }
+
+        if (strip_pool) {
+            for (int i = 0; i < count; i++) {
+                strip_pool->submit([this, &inputImage, &area, origin, &output, i, vote] {
+                    processStrip(inputImage, area, origin, i, output, vote);
+                });
+            }
+            strip_pool->wait();
+        } else {
+            processStrip(inputImage, area, origin, 0, output, vote);
+        }
+    }
+
+    if (!vote) {
+        houghLines(output, lines);
+        return;
+    }
+    ScopedStageTimer timer(perf_stats, STAGE_HOUGH);
+    hough_engine.finishStrips(lines, roi_mode ? area.tl() : cv::Point());
+}
+
+void LaneDetector::processStrip(const cv::Mat& inputImage, const cv::Rect& area, cv::Point origin, int index,
+                                cv::Mat& output, bool vote)
+{
+    FusedEdgeKernel& kernel = strip_kernels[index];
+    if (kernel.isa() != edge_kernel.isa())
+        kernel.setIsa(edge_kernel.isa());
+
+    for (int y = strip_rows[index][0]; y < strip_rows[index][1]; y++) {
+        const cv::Vec2i& run = mask_rows[y];
+        uchar* row = output.ptr<uchar>(y + origin.y);
+        uchar* dst = row + origin.x;
+        if (run[0] >= run[1]) {
+            std::memset(dst, 0, area.width);
+        } else {
+            std::memset(dst, 0, run[0]);
+            std::memset(dst + run[1], 0, area.width - run[1]);
+            kernel.runRow(inputImage, y + area.y, run[0] + area.x, run[1] + area.x, dst + run[0], config.edge_threshold);
+        }
+        if (vote)
+            hough_engine.voteRow(index, y + origin.y, row);
+    }
+}
+
+// PACKED EDGE DETECTION
+/**
+*@brief Fused edge detection of the lane bounding box packed into a bitmap
+*@brief The mask is the span table of updateMask: only the mask run of each row is computed
+*@brief (into a one-row buffer), packed to bits and listed as edge points; rows without a run
+*@brief are cleared. The bits equal mask(fusedEdgeDetector(frame)) in ROI mode.
+*@param inputImage is the frame of a video in which the lane is going to be detected
+*@param output receives the packed masked edges and their points
+*/
+void LaneDetector::bitmapEdgeDetector(const cv::Mat& inputImage, EdgeBitmap& output)
+{
+    ScopedStageTimer timer(perf_stats, STAGE_EDGE);
+    perf_stats.countFrame();
+
+    prepare(inputImage.size());
+    cv::Rect area = roi_rect;
+    updateMask(area.size(), area.tl());
+    output.create(area.size());
+    bitmap_row.resize(area.width);
+    coarse_lines = false;
+
+    for (int y = 0; y < area.height; y++) {
+        const cv::Vec2i& run = mask_rows[y];
+        if (run[0] >= run[1]) {
+            output.clearRow(y);
+            continue;
+        }
+        edge_kernel.runRow(inputImage, y + area.y, run[0] + area.x, run[1] + area.x, bitmap_row.data(), config.edge_threshold);
+        output.packRow(y, bitmap_row.data(), run[0], run[1]);
+    }
+}
+
+cv::Mat LaneDetector::fusedEdgeDetector(cv::Mat inputImage)
+{
+    cv::Mat output;
+    fusedEdgeDetector(inputImage, output);
     return output;
 }
 
@@ -121,29 +448,135 @@ cv::Mat LaneDetector::edgeDetector(cv::Mat img_noise)
 /**
 *@brief Mask the image so that only the edges that form part of the lane are detected
 *@param img_edges is the edges image from the previous function
-*@return Binary image with only the desired edges being represented
+*@param output receives the binary image with only the desired edges being represented
 */
-cv::Mat LaneDetector::mask(cv::Mat img_edges) 
+void LaneDetector::mask(const cv::Mat& img_edges, cv::Mat& output) 
 {
-    start_timer();
+    ScopedStageTimer timer(perf_stats, STAGE_MASK);
     
-    cv::Mat output;
-    cv::Mat mask = cv::Mat::zeros(img_edges.size(), img_edges.type());
-    cv::Point pts[4] = {
-        cv::Point(210, 720),
-        cv::Point(550, 450),
-        cv::Point(717, 450),
-        cv::Point(1280, 720)
-    };
-
-    // Create a binary polygon mask
-    cv::fillConvexPoly(mask, pts, 4, cv::Scalar(255, 0, 0));
+    // Coarse edge images use the mask built by pyramidEdgeDetector
+    if (scale_factor > 1 && !coarse_mask.empty() && img_edges.size() == coarse_mask.size()) {
+        cv::bitwise_and(img_edges, coarse_mask, output);
+        return;
+    }
+
+    // Edge images of ROI size come from ROI mode, their origin is the ROI corner
+    cv::Point offset(0, 0);
+    if (roi_mode && img_edges.size() == roi_rect.size())
+        offset = roi_rect.tl();
+    else
+        prepare(img_edges.size());
+    updateMask(img_edges.size(), offset);
+
     // Multiply the edges image and the mask to get the output
-    cv::bitwise_and(img_edges, mask, output);
-    
-    double elapsed = end_timer();
-    total_mask_time += elapsed;
-    
+    cv::bitwise_and(img_edges, mask_image, output);
+}
+
+/**
+*@brief Create the binary polygon mask, only when the geometry changes
+*@param size is the size of the edge image
+*@param offset is the frame position of the edge image's origin
+*/
+void LaneDetector::updateMask(cv::Size size, cv::Point offset)
+{
+    if (!mask_image.empty() && size == mask_size && offset == mask_offset)
+        return;
+
+    cv::Point pts[4];
+    for (int i = 0; i < 4; i++)
+        pts[i] = roi_points[i] - offset;
+
+    mask_image = cv::Mat::zeros(size, CV_8UC1);
+    cv::fillConvexPoly(mask_image, pts, 4, cv::Scalar(255, 0, 0));
+    mask_size = size;
+    mask_offset = offset;
+
+    // The polygon is convex, so each row of the mask is one run
+    mask_rows.assign(size.height, cv::Vec2i(0, 0));
+    for (int y = 0; y < size.height; y++) {
+        const uchar* row = mask_image.ptr<uchar>(y);
+        int x0 = 0;
+        while (x0 < size.width && !row[x0])
+            x0++;
+        int x1 = x0;
+        while (x1 < size.width && row[x1])
+            x1++;
+        mask_rows[y] = cv::Vec2i(x0, x1);
+    }
+}
+
+// TRACKING BAND EDGE DETECTION
+/**
+*@brief Fused edge detection only inside the bands around the lines predicted by the tracker
+*@brief The result equals the masked full edge image inside the bands and is zero elsewhere;
+*@brief only the spans written by the previous call are cleared, so the cost scales with the
+*@brief band area instead of the ROI
+*@param inputImage is the frame of a video in which the lane is going to be detected
+*@param output receives the masked band edges, in the same geometry as mask() produces
+*/
+void LaneDetector::bandEdgeDetector(const cv::Mat& inputImage, cv::Mat& output)
+{
+    ScopedStageTimer timer(perf_stats, STAGE_EDGE);
+    perf_stats.countFrame();
+
+    cv::Rect area = roi(inputImage.size());
+    updateMask(area.size(), area.tl());
+
+    // A new or resized buffer has no valid spans to clear
+    output.create(area.size(), CV_8UC1);
+    if (output.data != band_data || output.size() != band_size) {
+        output.setTo(cv::Scalar(0));
+        band_spans.clear();
+        band_data = output.data;
+        band_size = output.size();
+    }
+    for (const auto& span : band_spans)
+        std::memset(output.ptr<uchar>(span[0]) + span[1], 0, span[2] - span[1]);
+    band_spans.clear();
+    // At most one span per side and row, so later frames never grow the list
+    band_spans.reserve(2 * area.height);
+
+    for (int y = 0; y < area.height; y++) {
+        const cv::Vec2i& run = mask_rows[y];
+        if (run[0] >= run[1])
+            continue;
+
+        // Band of each side in edge image columns, clipped to the mask run
+        double fy = y + area.y;
+        int x0[2];
+        int x1[2];
+        for (int side = 0; side < 2; side++) {
+            LaneTracker::Side id = static_cast<LaneTracker::Side>(side);
+            double cx = lane_tracker.predictedX(id, fy) - area.x;
+            double half = lane_tracker.bandHalfWidth(id, fy);
+            x0[side] = std::max(run[0], static_cast<int>(std::floor(cx - half)));
+            x1[side] = std::min(run[1], static_cast<int>(std::ceil(cx + half)) + 1);
+        }
+
+        // Merge the bands where they overlap near the vanishing point
+        if (x0[0] > x0[1]) {
+            std::swap(x0[0], x0[1]);
+            std::swap(x1[0], x1[1]);
+        }
+        if (x1[0] >= x0[1] && x0[1] < x1[1]) {
+            x1[0] = std::max(x1[0], x1[1]);
+            x0[1] = x1[1] = 0;
+        }
+
+        uchar* dst = output.ptr<uchar>(y);
+        for (int side = 0; side < 2; side++) {
+            if (x0[side] >= x1[side])
+                continue;
+            edge_kernel.runRow(inputImage, y + area.y, x0[side] + area.x, x1[side] + area.x, dst + x0[side], config.edge_threshold);
+            band_spans.push_back(cv::Vec3i(y, x0[side], x1[side]));
+        }
+    }
+}
+
+cv::Mat LaneDetector::mask(cv::Mat img_edges) 
+{
+    cv::Mat output;
+    mask(img_edges, output);
     return output;
 }
 
@@ -151,20 +584,83 @@ cv::Mat LaneDetector::mask(cv::Mat img_edges)
 /**
 *@brief Obtain all the line segments in the masked images which are going to be part of the lane boundaries
 *@param img_mask is the masked binary image from the previous function
-*@return Vector that contains all the detected lines in the image
+*@param line receives all the detected lines in the image
 */
-std::vector<cv::Vec4i> LaneDetector::houghLines(cv::Mat img_mask) 
+void LaneDetector::houghLines(const cv::Mat& img_mask, std::vector<cv::Vec4i>& line) 
 {
-    start_timer();
+    ScopedStageTimer timer(perf_stats, STAGE_HOUGH);
     
-    std::vector<cv::Vec4i> line;
+    coarse_lines = scale_factor > 1 && !coarse_mask.empty() && img_mask.size() == coarse_mask.size();
+    if (coarse_lines) {
+        if (hough_mode == HOUGH_LANE)
+            coarse_engine.detect(img_mask, line);
+        else if (hough_mode == HOUGH_STANDARD)
+            standardHough(coarse_engine, img_mask, line);
+        else
+            HoughLinesP(img_mask, line, config.hough_rho, config.hough_theta, coarse_threshold, coarse_min_length, coarse_max_gap);
 
-    // rho and theta are selected by trial and error
-    HoughLinesP(img_mask, line, 1, CV_PI / 180, 20, 20, 30);
-    
-    double elapsed = end_timer();
-    total_hough_time += elapsed;
-    
+        // A coarse pixel covers a scale_factor block of the frame: map it to the block center
+        int half = scale_factor / 2;
+        for (auto& l : line) {
+            l[0] = l[0] * scale_factor + half + coarse_area.x;
+            l[1] = l[1] * scale_factor + half + coarse_area.y;
+            l[2] = l[2] * scale_factor + half + coarse_area.x;
+            l[3] = l[3] * scale_factor + half + coarse_area.y;
+        }
+        return;
+    }
+
+    if (hough_mode == HOUGH_LANE)
+        hough_engine.detect(img_mask, line);
+    else if (hough_mode == HOUGH_STANDARD)
+        standardHough(hough_engine, img_mask, line);
+    else
+        HoughLinesP(img_mask, line, config.hough_rho, config.hough_theta, hough_threshold, hough_min_length, hough_max_gap);
+
+    // Lines found in the ROI image are translated back to frame coordinates
+    if (roi_mode && img_mask.size() == roi_rect.size()) {
+        for (auto& l : line) {
+            l[0] += roi_rect.x;
+            l[1] += roi_rect.y;
+            l[2] += roi_rect.x;
+            l[3] += roi_rect.y;
+        }
+    }
+}
+
+/**
+*@brief Hough lines of the packed edges; HoughLinesP and the standard transform need the bytes,
+*@brief so those modes unpack
+*@param bitmap is the output of bitmapEdgeDetector
+*@param line receives the detected lines in frame coordinates
+*/
+void LaneDetector::houghLines(const EdgeBitmap& bitmap, std::vector<cv::Vec4i>& line)
+{
+    ScopedStageTimer timer(perf_stats, STAGE_HOUGH);
+
+    if (hough_mode == HOUGH_LANE) {
+        hough_engine.detect(bitmap, line);
+    } else if (hough_mode == HOUGH_STANDARD) {
+        bitmap.unpack(work.masked);
+        standardHough(hough_engine, work.masked, line);
+    } else {
+        bitmap.unpack(work.masked);
+        HoughLinesP(work.masked, line, config.hough_rho, config.hough_theta, hough_threshold, hough_min_length, hough_max_gap);
+    }
+
+    // The bitmap covers the lane bounding box
+    for (auto& l : line) {
+        l[0] += roi_rect.x;
+        l[1] += roi_rect.y;
+        l[2] += roi_rect.x;
+        l[3] += roi_rect.y;
+    }
+}
+
+std::vector<cv::Vec4i> LaneDetector::houghLines(cv::Mat img_mask) 
+{
+    std::vector<cv::Vec4i> line;
+    houghLines(img_mask, line);
     return line;
 }
 
@@ -172,40 +668,59 @@ std::vector<cv::Vec4i> LaneDetector::houghLines(cv::Mat img_mask)
 /**
 *@brief Separate lines into right and left lines
 *@param lines is the input that contains all the detected lines
-*@param img_edges is used for computational purposes
-*@return The output is a vector that contains all the classified lines
+*@param output receives the classified lines: output[0] right, output[1] left
 */
-std::vector<std::vector<cv::Vec4i> > LaneDetector::lineSeparation(std::vector<cv::Vec4i> lines, cv::Mat img_edges) 
+void LaneDetector::lineSeparation(const std::vector<cv::Vec4i>& lines, std::vector<std::vector<cv::Vec4i> >& output) 
 {
-    start_timer();
+    // Nothing reads these fits: regression without fits accumulates its own
+    lineSeparation(lines, output, line_fit);
+}
+
+/**
+*@brief Separate lines into right and left lines and accumulate the fit of each side
+*@brief Each kept line is added to the line fit of its side while it is classified, so the
+*@brief regression overload that takes the fits needs no further pass over the points
+*@param lines is the input that contains all the detected lines
+*@param output receives the classified lines: output[0] right, output[1] left
+*@param fits receives the fits of output[0] and output[1]
+*/
+void LaneDetector::lineSeparation(const std::vector<cv::Vec4i>& lines, std::vector<std::vector<cv::Vec4i> >& output,
+                                  LineFit (&fits)[2])
+{
+    ScopedStageTimer timer(perf_stats, STAGE_SEPARATION);
     
-    std::vector<std::vector<cv::Vec4i> > output(2);
-    size_t j = 0;
+    output.resize(2);
+    output[0].clear();
+    output[1].clear();
+    fits[0].reset();
+    fits[1].reset();
     cv::Point ini;
     cv::Point fini;
-    double slope_thresh_min = 0.3;
-    double slope_thresh_max = 0.85;
 
-    for (auto i : lines) {
+    for (const auto& i : lines) {
         ini = cv::Point(i[0], i[1]);
         fini = cv::Point(i[2], i[3]);
 
         double slope = (static_cast<double>(fini.y) - static_cast<double>(ini.y)) /
                       (static_cast<double>(fini.x) - static_cast<double>(ini.x) + 0.00001);
 
-        if ((abs(slope) > slope_thresh_min) && (abs(slope) < slope_thresh_max)) {
-            if (slope > 0 && fini.x > 640) {
+        if ((abs(slope) > config.slope_min) && (abs(slope) < config.slope_max)) {
+            if (slope > 0 && fini.x > center_split) {
                 output[0].push_back(i);
+                fits[0].add(i);
             }
-            else if (slope < 0 && fini.x < 640) {
+            else if (slope < 0 && fini.x < center_split) {
                 output[1].push_back(i);
+                fits[1].add(i);
             }
         }
     }
-    
-    double elapsed = end_timer();
-    total_line_separation_time += elapsed;
-    
+}
+
+std::vector<std::vector<cv::Vec4i> > LaneDetector::lineSeparation(std::vector<cv::Vec4i> lines, cv::Mat img_edges) 
+{
+    std::vector<std::vector<cv::Vec4i> > output;
+    lineSeparation(lines, output);
     return output;
 }
 
@@ -214,78 +729,191 @@ std::vector<std::vector<cv::Vec4i> > LaneDetector::lineSeparation(std::vector<cv
 *@brief Regression takes all the classified line coordinates initial and final and returns a function
 *@param left_right_lines is the output of the lineSeparation function
 *@param inputImage is used to select where do the lines will end
-*@return The function returns a vector containing the initial and final points of the line functions
+*@param output receives the initial and final points of the line functions
 */
-std::vector<cv::Point> LaneDetector::regression(std::vector<std::vector<cv::Vec4i> > left_right_lines, cv::Mat inputImage) 
+void LaneDetector::regression(const std::vector<std::vector<cv::Vec4i> >& left_right_lines, const cv::Mat& inputImage, std::vector<cv::Point>& output) 
 {
-    start_timer();
-    
-    std::vector<cv::Point> output(4);
-    cv::Point ini;
-    cv::Point fini;
-    cv::Point ini2;
-    cv::Point fini2;
-    cv::Vec4d right_line;
-    cv::Vec4d left_line;
-    std::vector<cv::Point> right_pts;
-    std::vector<cv::Point> left_pts;
-
-    // If right lines are being detected, fit a line using all the init and final points of the lines
-    if (left_right_lines[0].size() > 0) {
-        for (auto j : left_right_lines[0]) {
-            ini = cv::Point(j[0], j[1]);
-            fini = cv::Point(j[2], j[3]);
-
-            right_pts.push_back(ini);
-            right_pts.push_back(fini);
-        }
+    ScopedStageTimer timer(perf_stats, STAGE_REGRESSION);
+
+    for (int side = 0; side < 2; side++) {
+        line_fit[side].reset();
+        for (const auto& j : left_right_lines[side])
+            line_fit[side].add(j);
     }
+    solveRegression(left_right_lines, inputImage, output);
+}
 
-    // If left lines are being detected, fit a line using all the init and final points of the lines
-    if (left_right_lines[1].size() > 0) {
-        for (auto j : left_right_lines[1]) {
-            ini2 = cv::Point(j[0], j[1]);
-            fini2 = cv::Point(j[2], j[3]);
+/**
+*@brief Regression from the fits lineSeparation accumulated while it classified the lines
+*@param left_right_lines is the output of lineSeparation, only revisited by the Huber fit
+*@param fits are the fits lineSeparation returned with left_right_lines
+*@param inputImage is used to select where do the lines will end
+*@param output receives the initial and final points of the line functions
+*/
+void LaneDetector::regression(const std::vector<std::vector<cv::Vec4i> >& left_right_lines, const LineFit (&fits)[2],
+                              const cv::Mat& inputImage, std::vector<cv::Point>& output)
+{
+    ScopedStageTimer timer(perf_stats, STAGE_REGRESSION);
 
-            left_pts.push_back(ini2);
-            left_pts.push_back(fini2);
-        }
-    }
+    // The Huber fit reweights the moments, so the caller's fits are copied
+    line_fit[0] = fits[0];
+    line_fit[1] = fits[1];
+    solveRegression(left_right_lines, inputImage, output);
+}
 
-    // If right lines are being detected, fit a line using all the init and final points of the lines
-    if (right_pts.size() > 0) {
-        // The right line is formed here
-        cv::fitLine(right_pts, right_line, cv::DIST_L2, 0, 0.01, 0.01);
-        right_m = right_line[1] / right_line[0];
-        right_b = cv::Point(right_line[2], right_line[3]);
-    }
+void LaneDetector::solveRegression(const std::vector<std::vector<cv::Vec4i> >& left_right_lines, const cv::Mat& inputImage,
+                                   std::vector<cv::Point>& output)
+{
+    prepare(inputImage.size());
+    
+    output.resize(4);
+
+    // A side without lines (or with a degenerate fit) keeps the line of the previous frame
+    right_flag = fitSide(0, left_right_lines[0], right_m, right_b);
+    left_flag = fitSide(1, left_right_lines[1], left_m, left_b);
 
-    // If left lines are being detected, fit a line using all the init and final points of the lines
-    if (left_pts.size() > 0) {
-        // The left line is formed here
-        cv::fitLine(left_pts, left_line, cv::DIST_L2, 0, 0.01, 0.01);
-        left_m = left_line[1] / left_line[0];
-        left_b = cv::Point(left_line[2], left_line[3]);
+    // Lines found on the coarse image are only accurate to a block: refine them at full resolution
+    if (coarse_lines) {
+        if (right_flag)
+            refineLine(inputImage, right_m, right_b);
+        if (left_flag)
+            refineLine(inputImage, left_m, left_b);
     }
 
     // One the slope and offset points have been obtained, apply the line equation to obtain the line points
     int ini_y = inputImage.rows;
-    int fin_y = 470;
+    int fin_y = lane_top;
+
+    // In tracking mode the fitted lines are only measurements: the filtered lines replace them,
+    // so a side without lines coasts on its prediction instead of keeping a stale fit
+    if (tracking_mode) {
+        bool valid[2] = { right_flag, left_flag };
+        double x_bottom[2] = { 0.0, 0.0 };
+        double x_top[2] = { 0.0, 0.0 };
+        if (right_flag) {
+            x_bottom[0] = lineX(right_m, right_b, ini_y);
+            x_top[0] = lineX(right_m, right_b, fin_y);
+        }
+        if (left_flag) {
+            x_bottom[1] = lineX(left_m, left_b, ini_y);
+            x_top[1] = lineX(left_m, left_b, fin_y);
+        }
+        lane_tracker.update(valid, x_bottom, x_top, ini_y, fin_y);
+
+        if (lane_tracker.hasModel()) {
+            double rb = lane_tracker.x(LaneTracker::RIGHT, ini_y);
+            double rt = lane_tracker.x(LaneTracker::RIGHT, fin_y);
+            double lb = lane_tracker.x(LaneTracker::LEFT, ini_y);
+            double lt = lane_tracker.x(LaneTracker::LEFT, fin_y);
+            right_m = boundedSlope(fin_y - ini_y, rt - rb);
+            right_b = cv::Point(cvRound(rb), ini_y);
+            left_m = boundedSlope(fin_y - ini_y, lt - lb);
+            left_b = cv::Point(cvRound(lb), ini_y);
+        }
+    }
 
-    double right_ini_x = ((ini_y - right_b.y) / right_m) + right_b.x;
-    double right_fin_x = ((fin_y - right_b.y) / right_m) + right_b.x;
+    double right_ini_x = lineX(right_m, right_b, ini_y);
+    double right_fin_x = lineX(right_m, right_b, fin_y);
 
-    double left_ini_x = ((ini_y - left_b.y) / left_m) + left_b.x;
-    double left_fin_x = ((fin_y - left_b.y) / left_m) + left_b.x;
+    double left_ini_x = lineX(left_m, left_b, ini_y);
+    double left_fin_x = lineX(left_m, left_b, fin_y);
 
     output[0] = cv::Point(right_ini_x, ini_y);
     output[1] = cv::Point(right_fin_x, fin_y);
     output[2] = cv::Point(left_ini_x, ini_y);
     output[3] = cv::Point(left_fin_x, fin_y);
-    
-    double elapsed = end_timer();
-    total_regression_time += elapsed;
-    
+}
+
+/**
+*@brief Solve the accumulated fit of one side and turn it into slope and point form
+*@param side is 0 for the right and 1 for the left line
+*@param lines are the classified lines of that side, revisited only by the Huber mode
+*@param m receives the slope, clamped for (near) vertical lines
+*@param b receives the centroid of the fit
+*@return false if the side has no lines or its fit is degenerate or (near) horizontal;
+*@return m and b are left unchanged then
+*/
+bool LaneDetector::fitSide(int side, const std::vector<cv::Vec4i>& lines, double& m, cv::Point& b)
+{
+    double vx, vy, x0, y0;
+    bool solved = fit_mode == FIT_HUBER
+        ? line_fit[side].solveHuber(lines, huber_k, config.fit_iterations, vx, vy, x0, y0)
+        : line_fit[side].solve(vx, vy, x0, y0);
+    if (!solved || std::fabs(vy) < MIN_FIT_SLOPE * std::fabs(vx))
+        return false;
+
+    m = boundedSlope(vy, vx);
+    b = cv::Point(cvRound(x0), cvRound(y0));
+    return true;
+}
+
+// COARSE LINE REFINEMENT
+/**
+*@brief Refit a line found on the coarse image to full-resolution edge pixels
+*@brief On every scale_factor-th row between the lane top and the bottom of the frame, the fused
+*@brief kernel computes the edges of a narrow strip around the line; the edge pixel closest to
+*@brief the line is taken as a sample, and x = a*y + c is fitted to the samples by least squares
+*@param inputImage is the full-resolution frame
+*@param m is the slope of the line, replaced by the refined slope
+*@param b is a point of the line, replaced by the refined point on the bottom row
+*@return false if there were too few samples; m and b are left unchanged then
+*/
+bool LaneDetector::refineLine(const cv::Mat& inputImage, double& m, cv::Point& b)
+{
+    if (!std::isfinite(m) || std::fabs(m) < 1e-6)
+        return false;
+
+    // The strip covers the quantization of the coarse image plus some slope error
+    const int half = 2 * scale_factor + 2;
+    const int min_samples = 8;
+    strip.resize(2 * half + 1);
+
+    double sy = 0.0, sx = 0.0, syy = 0.0, sxy = 0.0;
+    int n = 0;
+    for (int y = std::max(lane_top, 0); y < inputImage.rows; y += scale_factor) {
+        double xc = (y - b.y) / m + b.x;
+        int x0 = std::max(cvFloor(xc) - half, 0);
+        int x1 = std::min(cvFloor(xc) + half + 1, inputImage.cols);
+        if (x1 <= x0)
+            continue;
+        edge_kernel.runRow(inputImage, y, x0, x1, strip.data(), config.edge_threshold);
+
+        int best = -1;
+        double best_dist = half + 1.0;
+        for (int x = x0; x < x1; x++) {
+            if (strip[x - x0] && std::fabs(x - xc) < best_dist) {
+                best = x;
+                best_dist = std::fabs(x - xc);
+            }
+        }
+        if (best < 0)
+            continue;
+        sy += y;
+        sx += best;
+        syy += static_cast<double>(y) * y;
+        sxy += static_cast<double>(y) * best;
+        n++;
+    }
+    if (n < min_samples)
+        return false;
+
+    double den = n * syy - sy * sy;
+    if (std::fabs(den) < 1e-9)
+        return false;
+    double a = (n * sxy - sy * sx) / den;
+    double c = (sx - a * sy) / n;
+    if (std::fabs(a) < 1e-6)
+        return false;
+
+    m = 1.0 / a;
+    b = cv::Point(cvRound(a * inputImage.rows + c), inputImage.rows);
+    return true;
+}
+
+std::vector<cv::Point> LaneDetector::regression(std::vector<std::vector<cv::Vec4i> > left_right_lines, cv::Mat inputImage) 
+{
+    std::vector<cv::Point> output;
+    regression(left_right_lines, inputImage, output);
     return output;
 }
 
@@ -293,15 +921,20 @@ std::vector<cv::Point> LaneDetector::regression(std::vector<std::vector<cv::Vec4
 /**
 *@brief Predict if the lane is turning left, right or if it is going straight
 *@brief It is done by seeing where the vanishing point is with respect to the center of the image
-*@return String that says if there is left or right turn or if the road is straight
+*@param output receives the string that says if there is left or right turn or if the road is straight
 */
-std::string LaneDetector::predictTurn() 
+void LaneDetector::predictTurn(std::string& output) 
 {
-    start_timer();
+    ScopedStageTimer timer(perf_stats, STAGE_PREDICT);
     
-    std::string output;
     double vanish_x;
-    double thr_vp = 10;
+    double thr_vp = turn_threshold;
+
+    // Parallel lines have no vanishing point
+    if (std::fabs(right_m - left_m) < MIN_FIT_SLOPE) {
+        output.clear();
+        return;
+    }
 
     // The vanishing point is the point where both lane boundary lines intersect
     vanish_x = static_cast<double>(((right_m*right_b.x) - (left_m*left_b.x) - right_b.y + left_b.y) / (right_m - left_m));
@@ -313,30 +946,41 @@ std::string LaneDetector::predictTurn()
         output = "Turn right";
     else if (vanish_x >= (img_center - thr_vp) && vanish_x <= (img_center + thr_vp))
         output = "Straight";
-    
-    double elapsed = end_timer();
-    total_predict_time += elapsed;
-    
+    else
+        output.clear();
+}
+
+std::string LaneDetector::predictTurn() 
+{
+    std::string output;
+    predictTurn(output);
     return output;
 }
 
 // PLOT RESULTS
 /**
 *@brief This function plots both sides of the lane, the turn prediction message and a transparent polygon that covers the area inside the lane boundaries
+*@brief In span mode the overlay renderer blends only the covered pixels, in place
 *@param inputImage is the original captured frame
 *@param lane is the vector containing the information of both lines
 *@param turn is the output string containing the turn information
 *@return The function returns a 0
 */
-int LaneDetector::plotLane(cv::Mat inputImage, std::vector<cv::Point> lane, std::string turn) 
+int LaneDetector::plotLane(cv::Mat inputImage, const std::vector<cv::Point>& lane, const std::string& turn) 
 {
-    start_timer();
+    ScopedStageTimer timer(perf_stats, STAGE_PLOT);
+
+    if (plot_mode == PLOT_SPANS) {
+        overlay_renderer.render(inputImage, lane, turn);
+        return 0;
+    }
     
-    std::vector<cv::Point> poly_points;
-    cv::Mat output;
+    std::vector<cv::Point>& poly_points = work.poly_points;
+    cv::Mat& output = work.overlay;
 
     // Create the transparent polygon for a better visualization of the lane
     inputImage.copyTo(output);
+    poly_points.clear();
     poly_points.push_back(lane[2]);
     poly_points.push_back(lane[0]);
     poly_points.push_back(lane[1]);
@@ -355,10 +999,6 @@ int LaneDetector::plotLane(cv::Mat inputImage, std::vector<cv::Point> lane, std:
     // cv::namedWindow("Lane", cv::WINDOW_AUTOSIZE);
     // cv::imshow("Lane", inputImage);
     
-    double elapsed = end_timer();
-    total_plot_time += elapsed;
-    frame_count++;
-    
     return 0;
 }
 
@@ -366,34 +1006,20 @@ int LaneDetector::plotLane(cv::Mat inputImage, std::vector<cv::Point> lane, std:
 void LaneDetector::getPerformanceStats(double& avg_denoise, double& avg_edge, double& avg_mask, 
                                       double& avg_hough, double& avg_separation, double& avg_regression,
                                       double& avg_predict, double& avg_plot, double& avg_total, int& frames) {
-    if (frame_count > 0) {
-        avg_denoise = total_denoise_time / frame_count;
-        avg_edge = total_edge_detection_time / frame_count;
-        avg_mask = total_mask_time / frame_count;
-        avg_hough = total_hough_time / frame_count;
-        avg_separation = total_line_separation_time / frame_count;
-        avg_regression = total_regression_time / frame_count;
-        avg_predict = total_predict_time / frame_count;
-        avg_plot = total_plot_time / frame_count;
-        avg_total = (total_denoise_time + total_edge_detection_time + total_mask_time + 
-                    total_hough_time + total_line_separation_time + total_regression_time + 
-                    total_predict_time + total_plot_time) / frame_count;
-        frames = frame_count;
-    } else {
-        avg_denoise = avg_edge = avg_mask = avg_hough = avg_separation = avg_regression = avg_predict = avg_plot = avg_total = 0.0;
-        frames = 0;
-    }
+    avg_denoise = perf_stats.averagePerFrameMs(STAGE_DENOISE);
+    avg_edge = perf_stats.averagePerFrameMs(STAGE_EDGE);
+    avg_mask = perf_stats.averagePerFrameMs(STAGE_MASK);
+    avg_hough = perf_stats.averagePerFrameMs(STAGE_HOUGH);
+    avg_separation = perf_stats.averagePerFrameMs(STAGE_SEPARATION);
+    avg_regression = perf_stats.averagePerFrameMs(STAGE_REGRESSION);
+    avg_predict = perf_stats.averagePerFrameMs(STAGE_PREDICT);
+    avg_plot = perf_stats.averagePerFrameMs(STAGE_PLOT);
+    avg_total = avg_denoise + avg_edge + avg_mask + avg_hough + avg_separation + avg_regression + 
+                avg_predict + avg_plot;
+    frames = perf_stats.frames();
 }
 
 // 重置性能统计
 void LaneDetector::resetPerformanceStats() {
-    total_denoise_time = 0.0;
-    total_edge_detection_time = 0.0;
-    total_mask_time = 0.0;
-    total_hough_time = 0.0;
-    total_line_separation_time = 0.0;
-    total_regression_time = 0.0;
-    total_predict_time = 0.0;
-    total_plot_time = 0.0;
-    frame_count = 0;
-}
\ No newline at end of file
+    perf_stats.reset();
+}
@@ -1,45 +1,279 @@
+#ifndef LANE_DETECTOR_H
+#define LANE_DETECTOR_H
+
+#include "ChangeGate.h"
+#include "EdgeBitmap.h"
+#include "EdgeKernel.h"
+#include "HoughEngine.h"
+#include "LaneTracker.h"
+#include "LaneDetectorConfig.h"
+#include "LineFit.h"
+#include "OverlayRenderer.h"
+#include "PerfStats.h"
+#include <memory>
+
+class ThreadPool;
+
+// Per-frame working buffers. They keep their capacity between frames, so after the
+// first frame the by-reference stage API runs without heap allocations.
+struct FrameWorkspace
+{
+	cv::Mat denoised;           // deNoise output
+	cv::Mat gray;               // Gray/binary intermediate of edgeDetector
+	cv::Mat edges;              // Edge image
+	cv::Mat masked;             // Edge image after the polygon mask
+	cv::Mat band;               // Masked edges inside the tracking bands only, zero elsewhere
+	EdgeBitmap bitmap;          // Packed masked edges of the lane bounding box
+	cv::Mat overlay;            // Copy of the frame the lane polygon is drawn on
+	cv::Mat gate_edges;         // Edge image of the last fully detected frame, repeated on gate hits
+	cv::Mat filter_kernel;      // [-1 0 1] kernel of edgeDetector
+	std::vector<cv::Vec4i> lines;
+	std::vector<std::vector<cv::Vec4i> > left_right_lines;
+	LineFit fits[2];            // Fits lineSeparation accumulated for left_right_lines
+	std::vector<cv::Point> lane;
+	std::vector<cv::Point> poly_points;
+	std::string turn;
+
+	FrameWorkspace();
+};
+
 class LaneDetector
 {
+public:
+	// Implementation of houghLines: HoughLinesP, the engine's progressive transform over the lane
+	// angles, or the engine's standard transform over the same angles (the one strips can vote)
+	enum HoughMode { HOUGH_OPENCV = 0, HOUGH_LANE, HOUGH_STANDARD };
+
+	// Line fit of regression: plain length-weighted least squares or Huber IRLS
+	enum FitMode { FIT_LSQ = 0, FIT_HUBER };
+
+	// Renderer of plotLane: OpenCV drawing over a full-frame copy, or in-place span blending
+	enum PlotMode { PLOT_OPENCV = 0, PLOT_SPANS };
+
 private:
-	double img_size;
-	double img_center;
+	LaneDetectorConfig config;  // Resolution-independent tuning
+	cv::Size geometry_size;     // Frame size the pixel values below were computed for
+	double img_size;            // Frame width
+	double img_center;          // Column of the image center line used by predictTurn
+	cv::Point roi_points[4];    // Lane trapezoid in frame pixels
+	int center_split;           // lineSeparation column between right and left lines
+	int lane_top;               // Row where the regression lines end
+	int hough_threshold;        // Hough parameters scaled to the frame height
+	int hough_min_length;       //
+	int hough_max_gap;          //
+	double turn_threshold;      // Vanishing point offset for a turn, in pixels
+	double huber_k;             // Huber threshold of the robust fit, in pixels
 	bool left_flag = false;     // Tells us if there's left boundary of lane detected
 	bool right_flag = false;    // Tells us if there's right boundary of lane detected
 	cv::Point right_b;          // Members of both line equations of the lane boundaries:
-	double right_m;             // y = m*x + b
+	double right_m = 1.0;       // y = m*x + b
 	cv::Point left_b;           //
-	double left_m;              //
+	double left_m = -1.0;       //
+	LineFit line_fit[2];        // Right and left fits solved by regression
+	FitMode fit_mode = FIT_LSQ;
+	FusedEdgeKernel edge_kernel;  // Single-pass blur + gray + threshold + [-1 0 1]
+	PerfStats perf_stats;       // Stage timings of this instance only
+	bool roi_mode = false;      // Process only the bounding box of the lane trapezoid
+	cv::Rect roi_rect;          // Bounding box of the trapezoid in frame coordinates
+	cv::Size roi_frame_size;    // Frame size roi_rect was computed for
+	cv::Mat mask_image;         // Precomputed polygon mask, reused while its geometry is unchanged
+	cv::Size mask_size;         //
+	cv::Point mask_offset;      //
+	std::vector<cv::Vec2i> mask_rows;   // [start, end) of the mask on each row of mask_image
+	FrameWorkspace work;        // Buffers reused by every frame
+	HoughEngine hough_engine;   // Hough voting only over the angles lineSeparation keeps
+	HoughMode hough_mode = HOUGH_OPENCV;
+	LaneTracker lane_tracker;   // Smoothed lane lines across frames
+	bool tracking_mode = false; // Use lane_tracker to smooth the lane and narrow the search
+	std::vector<cv::Vec3i> band_spans;  // (row, x0, x1) written into the band image last frame
+	const uchar* band_data = nullptr;   // Band image buffer and size the spans refer to
+	cv::Size band_size;                 //
+	int scale_factor = 1;       // Coarse search on a 1/scale_factor image, refined at full resolution
+	cv::Rect coarse_area;       // Frame region the coarse edge image was downsampled from
+	cv::Mat coarse_mask;        // Lane trapezoid mask at the coarse scale
+	HoughEngine coarse_engine;  // Hough on the coarse image, lengths divided by scale_factor
+	int coarse_threshold;       // Same parameters for HoughLinesP on the coarse image
+	int coarse_min_length;      //
+	int coarse_max_gap;         //
+	bool coarse_lines = false;  // The last houghLines ran on the coarse image
+	std::vector<uchar> strip;   // Full-resolution edges of one refinement strip
+	int frame_threads = 0;      // Strip-parallel edge + mask + Hough on this many threads, 0 off
+	std::unique_ptr<ThreadPool> strip_pool;     // Persistent workers of the strip-parallel path
+	std::vector<FusedEdgeKernel> strip_kernels; // One kernel (row buffers) per strip
+	std::vector<cv::Vec2i> strip_rows;          // [first, last) edge image rows of each strip
+	bool bitmap_mode = false;   // Packed 1-bit edge image instead of the byte image and mask
+	std::vector<uchar> bitmap_row;  // Edge bytes of one mask run before packing
+	OverlayRenderer overlay_renderer;   // Span renderer of plotLane
+	ChangeGate change_gate;     // Reuse of the last result for near-identical frames
+	PlotMode plot_mode = PLOT_SPANS;
 
-	
+	// Rebuild mask_image and mask_rows when the edge image geometry changes
+	void updateMask(cv::Size size, cv::Point offset);
+
+	// Solve line_fit[side] into slope/point form; false keeps m and b
+	bool fitSide(int side, const std::vector<cv::Vec4i>& lines, double& m, cv::Point& b);
+
+	// Regression from the fits already in line_fit
+	void solveRegression(const std::vector<std::vector<cv::Vec4i> >& left_right_lines, const cv::Mat& inputImage,
+	                     std::vector<cv::Point>& output);
+
+	// Edge + mask (+ Hough votes) of the rows of one strip; origin is the ROI box corner in output
+	void processStrip(const cv::Mat& inputImage, const cv::Rect& area, cv::Point origin, int index,
+	                  cv::Mat& output, bool vote);
+
+	// Refit a coarse line (through b with slope m) to full-resolution edges near it
+	bool refineLine(const cv::Mat& inputImage, double& m, cv::Point& b);
 
 public:
+	LaneDetector();
+	~LaneDetector();
+
+	// Buffers for the by-reference stage API below
+	FrameWorkspace& workspace() { return work; }
+
+	// Replace the tuning; pixel values are recomputed on the next frame
+	void setConfig(const LaneDetectorConfig& cfg);
+	const LaneDetectorConfig& configuration() const { return config; }
+
+	// Compute the ROI, mask geometry, split column, lane rows and scaled Hough parameters for
+	// frames of this size. Stages call it themselves; it only does work when the size changes.
+	void prepare(cv::Size frame_size);
+
 	// Apply Gaussian blurring to the input Image
 	cv::Mat deNoise(cv::Mat inputImage);
+	void deNoise(const cv::Mat& inputImage, cv::Mat& output);
 
 	// Filter the image to obtain only edges
 	cv::Mat edgeDetector(cv::Mat img_noise);
+	void edgeDetector(const cv::Mat& img_noise, cv::Mat& output);
+
+	// Denoise and edge detection fused into a single pass over the input image
+	cv::Mat fusedEdgeDetector(cv::Mat inputImage);
+	void fusedEdgeDetector(const cv::Mat& inputImage, cv::Mat& output);
+
+	// Enable/disable cropping to the ROI bounding box before denoising
+	void setRoiMode(bool enable) { roi_mode = enable; }
+	bool roiMode() const { return roi_mode; }
+
+	// ROI bounding box for frames of the given size
+	cv::Rect roi(cv::Size frame_size);
+
+	// Bounding box of the lane trapezoid, whatever the ROI mode
+	cv::Rect laneBounds(cv::Size frame_size);
+
+	// Smooth the lane across frames and, once locked, only search narrow bands around it
+	void setTrackingMode(bool enable) { tracking_mode = enable; lane_tracker.reset(); }
+	bool trackingMode() const { return tracking_mode; }
+	bool trackingLocked() const { return tracking_mode && lane_tracker.locked(); }
+	LaneTracker& tracker() { return lane_tracker; }
+
+	// Start a new input stream: forget the tracked lane, the change gate's reference and result,
+	// and the line models and turn inputs regression keeps from earlier frames
+	void resetStream();
+
+	// Fused edge detection and mask restricted to the bands around the tracked lines
+	void bandEdgeDetector(const cv::Mat& inputImage, cv::Mat& output);
+
+	// Coarse-to-fine mode: edges and Hough on a 1/factor area-downsampled image (factor 1..4),
+	// lines refined on full-resolution edge strips in regression; 1 disables it
+	void setScale(int factor);
+	int scale() const { return scale_factor; }
+
+	// Downsampled fused edge detection of the ROI for the coarse-to-fine mode
+	void pyramidEdgeDetector(const cv::Mat& inputImage, cv::Mat& output);
+
+	// Intra-frame parallelism: the ROI is split into row strips, balanced by mask area, that
+	// run fused edge detection and the mask on a persistent pool. In HOUGH_STANDARD mode each
+	// strip also votes into its own accumulator and the accumulators are merged; the other
+	// modes run their Hough on the merged mask. threads 1 runs the same path on the calling
+	// thread, 0 returns to the serial stages.
+	void setFrameThreads(int threads);
+	int frameThreads() const { return frame_threads; }
+
+	// Strip-parallel detection: the masked edge image mask(fusedEdgeDetector()) would give (same
+	// size and values) and the Hough lines of the configured mode in frame coordinates, in one
+	// call replacing fusedEdgeDetector, mask and houghLines
+	void parallelDetect(const cv::Mat& inputImage, cv::Mat& output, std::vector<cv::Vec4i>& lines);
+
+	// Packed edges: the fused kernel runs only on each row's mask run of the lane bounding box and
+	// the row is packed to bits right away, so neither the byte edge image nor the mask image is
+	// written; Hough then walks the bitmap's point list
+	void setBitmapMode(bool enable) { bitmap_mode = enable; }
+	bool bitmapMode() const { return bitmap_mode; }
+
+	// Masked edges of the lane bounding box as a bitmap with its edge point list
+	void bitmapEdgeDetector(const cv::Mat& inputImage, EdgeBitmap& output);
+
+	// Change-detection gate used by detectFrame, configured from the gate_* config values
+	ChangeGate& changeGate() { return change_gate; }
+
+	// Access to the fused kernel, e.g. to force an instruction set
+	FusedEdgeKernel& edgeKernel() { return edge_kernel; }
 
 	// Mask the edges image to only care about ROI
 	cv::Mat mask(cv::Mat img_edges);
+	void mask(const cv::Mat& img_edges, cv::Mat& output);
 
 	// Detect Hough lines in masked edges image
 	std::vector<cv::Vec4i> houghLines(cv::Mat img_mask);
+	void houghLines(const cv::Mat& img_mask, std::vector<cv::Vec4i>& lines);
+
+	// Hough lines of a bitmap from bitmapEdgeDetector, in frame coordinates
+	void houghLines(const EdgeBitmap& bitmap, std::vector<cv::Vec4i>& lines);
+
+	// Select HoughLinesP or the in-tree restricted-angle engine
+	void setHoughMode(HoughMode mode) { hough_mode = mode; }
+	HoughMode houghMode() const { return hough_mode; }
+	HoughEngine& houghEngine() { return hough_engine; }
+	static const char* houghModeName(HoughMode mode)
+	{
+		return mode == HOUGH_LANE ? "lane" : mode == HOUGH_STANDARD ? "standard" : "opencv";
+	}
 
 	// Sprt detected lines by their slope into right and left lines
 	std::vector<std::vector<cv::Vec4i> > lineSeparation(std::vector<cv::Vec4i> lines, cv::Mat img_edges);
+	void lineSeparation(const std::vector<cv::Vec4i>& lines, std::vector<std::vector<cv::Vec4i> >& output);
+	// Also accumulate the line fit of each side, for the regression overload that takes fits
+	void lineSeparation(const std::vector<cv::Vec4i>& lines, std::vector<std::vector<cv::Vec4i> >& output,
+	                    LineFit (&fits)[2]);
+
+	// Select the line fit of regression
+	void setFitMode(FitMode mode) { fit_mode = mode; }
+	FitMode fitMode() const { return fit_mode; }
+	static const char* fitModeName(FitMode mode) { return mode == FIT_HUBER ? "huber" : "lsq"; }
 
 	// Get only one line for each side of the lane
 	std::vector<cv::Point> regression(std::vector<std::vector<cv::Vec4i> > left_right_lines, cv::Mat inputImage);
+	void regression(const std::vector<std::vector<cv::Vec4i> >& left_right_lines, const cv::Mat& inputImage,
+	                std::vector<cv::Point>& output);
+	// Use the fits lineSeparation accumulated for these lines instead of fitting them again
+	void regression(const std::vector<std::vector<cv::Vec4i> >& left_right_lines, const LineFit (&fits)[2],
+	                const cv::Mat& inputImage, std::vector<cv::Point>& output);
+
+	// Result of the last regression: which sides had lines in this frame and the slopes in use
+	bool rightDetected() const { return right_flag; }
+	bool leftDetected() const { return left_flag; }
+	double rightSlope() const { return right_m; }
+	double leftSlope() const { return left_m; }
 
 	// Determine if the lane is turning or not by calculating the position of the vanishing point
 	std::string predictTurn();
+	void predictTurn(std::string& output);
 
 	// Plot the resultant lane and turn prediction in the frame.
-	int plotLane(cv::Mat inputImage, std::vector<cv::Point> lane, std::string turn);
+	int plotLane(cv::Mat inputImage, const std::vector<cv::Point>& lane, const std::string& turn);
+
+	// Select the renderer of plotLane
+	void setPlotMode(PlotMode mode) { plot_mode = mode; }
+	PlotMode plotMode() const { return plot_mode; }
+	static const char* plotModeName(PlotMode mode) { return mode == PLOT_SPANS ? "spans" : "opencv"; }
 
 	// Performance monitoring functions
 	void getPerformanceStats(double& avg_denoise, double& avg_edge, double& avg_mask, 
 	                        double& avg_hough, double& avg_separation, double& avg_regression,
 	                        double& avg_predict, double& avg_plot, double& avg_total, int& frames);
 	void resetPerformanceStats();
-};
\ No newline at end of file
+	const PerfStats& performanceStats() const { return perf_stats; }
+};
+
+#endif // LANE_DETECTOR_H
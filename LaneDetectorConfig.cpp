@@ -0,0 +1,96 @@
+/**
+*@file LaneDetectorConfig.cpp
+*@brief Default tuning and the cv::FileStorage loader.
+*/
+#include <iostream>
+#include "LaneDetectorConfig.h"
+
+namespace {
+
+// Assign the node only if the key is present
+template <typename T>
+void readKey(const cv::FileNode& root, const char* key, T& value)
+{
+    cv::FileNode node = root[key];
+    if (!node.empty())
+        cv::read(node, value, value);
+}
+
+} // namespace
+
+LaneDetectorConfig::LaneDetectorConfig()
+    : center_x(0.5),
+      lane_top_y(470.0 / 720.0),
+      edge_threshold(140),
+      hough_rho(1),
+      hough_theta(CV_PI / 180),
+      hough_threshold(20),
+      hough_min_length(20),
+      hough_max_gap(30),
+      slope_min(0.3),
+      slope_max(0.85),
+      turn_threshold(10),
+      fit_huber_k(3.0),
+      fit_iterations(4),
+      reference_height(720),
+      gate_threshold(0.0),
+      gate_max_reuse(5),
+      gate_step(8)
+{
+    // The original trapezoid (210,720) (550,450) (717,450) (1280,720) in a 1280x720 frame
+    roi_polygon[0] = cv::Point2d(210.0 / 1280.0, 1.0);
+    roi_polygon[1] = cv::Point2d(550.0 / 1280.0, 450.0 / 720.0);
+    roi_polygon[2] = cv::Point2d(717.0 / 1280.0, 450.0 / 720.0);
+    roi_polygon[3] = cv::Point2d(1.0, 1.0);
+}
+
+/**
+*@brief Load overrides from a configuration file
+*@param path is a file cv::FileStorage can read (.yml, .yaml, .json, .xml)
+*@return false if the file cannot be opened or holds invalid values; the config is unchanged then
+*/
+bool LaneDetectorConfig::load(const std::string& path)
+{
+    cv::FileStorage fs;
+    if (!fs.open(path, cv::FileStorage::READ))
+        return false;
+    cv::FileNode root = fs.root();
+
+    LaneDetectorConfig c = *this;
+    cv::FileNode polygon = root["roi_polygon"];
+    if (!polygon.empty()) {
+        if (!polygon.isSeq() || polygon.size() != 8) {
+            std::cout << "roi_polygon 需要8个数值: " << path << std::endl;
+            return false;
+        }
+        for (int i = 0; i < 4; i++)
+            c.roi_polygon[i] = cv::Point2d(static_cast<double>(polygon[2 * i]), static_cast<double>(polygon[2 * i + 1]));
+    }
+    double theta_deg = c.hough_theta * 180.0 / CV_PI;
+    readKey(root, "center_x", c.center_x);
+    readKey(root, "lane_top_y", c.lane_top_y);
+    readKey(root, "edge_threshold", c.edge_threshold);
+    readKey(root, "hough_rho", c.hough_rho);
+    readKey(root, "hough_theta_deg", theta_deg);
+    readKey(root, "hough_threshold", c.hough_threshold);
+    readKey(root, "hough_min_length", c.hough_min_length);
+    readKey(root, "hough_max_gap", c.hough_max_gap);
+    readKey(root, "slope_min", c.slope_min);
+    readKey(root, "slope_max", c.slope_max);
+    readKey(root, "turn_threshold", c.turn_threshold);
+    readKey(root, "fit_huber_k", c.fit_huber_k);
+    readKey(root, "fit_iterations", c.fit_iterations);
+    readKey(root, "reference_height", c.reference_height);
+    readKey(root, "gate_threshold", c.gate_threshold);
+    readKey(root, "gate_max_reuse", c.gate_max_reuse);
+    readKey(root, "gate_step", c.gate_step);
+    c.hough_theta = theta_deg * CV_PI / 180.0;
+
+    if (c.reference_height <= 0 || c.hough_rho <= 0 || c.hough_theta <= 0 || c.slope_min >= c.slope_max ||
+        c.fit_huber_k <= 0 || c.fit_iterations < 0 || c.gate_threshold < 0 || c.gate_max_reuse < 0 || c.gate_step <= 0) {
+        std::cout << "配置参数无效: " << path << std::endl;
+        return false;
+    }
+    *this = c;
+    return true;
+}
@@ -0,0 +1,62 @@
+/**
+*@file LaneDetectorConfig.h
+*@brief Resolution-independent tuning of LaneDetector.
+*@brief Positions are fractions of the frame size and pixel quantities are given for a
+*@brief reference frame height, so one configuration serves 1280x720, 640x360 or 480x270
+*@brief input. LaneDetector turns it into pixel values once per input resolution.
+*/
+#ifndef LANE_DETECTOR_CONFIG_H
+#define LANE_DETECTOR_CONFIG_H
+
+#include <string>
+#include <opencv2/opencv.hpp>
+
+struct LaneDetectorConfig
+{
+	// Lane trapezoid as fractions of width/height: bottom left, top left, top right, bottom right
+	cv::Point2d roi_polygon[4];
+	double center_x;            // Column splitting right from left lines, fraction of the width
+	double lane_top_y;          // Row where the plotted lane ends, fraction of the height
+	int edge_threshold;         // Gray level of the edge binarization
+
+	// Hough parameters; threshold, min_length and max_gap are pixels at reference_height
+	double hough_rho;
+	double hough_theta;         // Radians
+	int hough_threshold;
+	int hough_min_length;
+	int hough_max_gap;
+
+	double slope_min;           // |dy/dx| range of the lines kept by lineSeparation
+	double slope_max;
+	double turn_threshold;      // Vanishing point offset from center_x for a turn, pixels at reference_height
+
+	double fit_huber_k;         // Huber threshold of the robust line fit, pixels at reference_height
+	int fit_iterations;         // Reweighting passes of the robust line fit (bounds its time)
+
+	int reference_height;       // Frame height the pixel quantities above were tuned for
+
+	// Change-detection gate (ChangeGate): frames whose lane area differs from the last detected
+	// frame by less than gate_threshold gray levels (mean absolute difference on a gate_step grid)
+	// reuse its result, at most gate_max_reuse frames in a row; 0 disables the gate
+	double gate_threshold;
+	int gate_max_reuse;
+	int gate_step;
+
+	// The values tuned on the 1280x720 project videos
+	LaneDetectorConfig();
+
+	// Override any of the keys below from a YAML/JSON/XML file (cv::FileStorage); missing keys
+	// keep their value. Keys: roi_polygon (8 numbers x0 y0 .. x3 y3), center_x, lane_top_y,
+	// edge_threshold, hough_rho, hough_theta_deg, hough_threshold, hough_min_length,
+	// hough_max_gap, slope_min, slope_max, turn_threshold, fit_huber_k, fit_iterations,
+	// reference_height, gate_threshold, gate_max_reuse, gate_step
+	bool load(const std::string& path);
+
+	// Factor from reference_height pixels to pixels of a frame of the given height
+	double pixelScale(int frame_height) const
+	{
+		return static_cast<double>(frame_height) / reference_height;
+	}
+};
+
+#endif // LANE_DETECTOR_CONFIG_H
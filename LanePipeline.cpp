@@ -0,0 +1,172 @@
+/**
+*@file LanePipeline.cpp
+*@brief Row kernel and Hough voting of the compile-time specialized front end.
+*@brief The kernel is the integer chain of FusedEdgeKernel (bit-exact [1 2 1]x[1 2 1] blur, 15-bit
+*@brief gray weights, threshold, [-1 0 1]); the reflected border taps are copied into the guard
+*@brief elements of the row buffers first, so every loop below runs without a border case.
+*/
+#include <cstring>
+#include "LanePipeline.h"
+
+namespace {
+
+const int R2Y = 9798;   // Weights of cvtColor BGR2GRAY, 15-bit fixed point (as in FusedEdgeKernel)
+const int G2Y = 19235;
+const int B2Y = 3735;
+const int GRAY_SHIFT = 15;
+
+} // namespace
+
+constexpr double LaneParams::roi_x0;
+constexpr double LaneParams::roi_y0;
+constexpr double LaneParams::roi_x1;
+constexpr double LaneParams::roi_y1;
+constexpr double LaneParams::roi_x2;
+constexpr double LaneParams::roi_y2;
+constexpr double LaneParams::roi_x3;
+constexpr double LaneParams::roi_y3;
+constexpr int LaneParams::edge_threshold;
+constexpr double LaneParams::hough_rho;
+constexpr double LaneParams::hough_theta;
+constexpr int LaneParams::hough_threshold;
+constexpr int LaneParams::hough_min_length;
+constexpr int LaneParams::hough_max_gap;
+constexpr double LaneParams::slope_min;
+constexpr double LaneParams::slope_max;
+constexpr int LaneParams::reference_height;
+
+template <int Width, int Height, class Params>
+constexpr lane_geometry::MaskTable<LaneGeometry<Width, Height, Params>::BOX_H> LanePipeline<Width, Height, Params>::mask_table;
+
+template <int Width, int Height, class Params>
+LanePipeline<Width, Height, Params>::LanePipeline()
+{
+    engine.configure(Params::hough_rho, Params::hough_theta, Geometry::HOUGH_THRESHOLD,
+                     Geometry::HOUGH_MIN_LENGTH, Geometry::HOUGH_MAX_GAP);
+    engine.setSlopeRange(Params::slope_min, Params::slope_max);
+    std::memset(vsum, 0, sizeof(vsum));
+    std::memset(blur, 0, sizeof(blur));
+    std::memset(bin, 0, sizeof(bin));
+}
+
+template <int Width, int Height, class Params>
+LaneDetectorConfig LanePipeline<Width, Height, Params>::config()
+{
+    LaneDetectorConfig c;
+    c.roi_polygon[0] = cv::Point2d(Params::roi_x0, Params::roi_y0);
+    c.roi_polygon[1] = cv::Point2d(Params::roi_x1, Params::roi_y1);
+    c.roi_polygon[2] = cv::Point2d(Params::roi_x2, Params::roi_y2);
+    c.roi_polygon[3] = cv::Point2d(Params::roi_x3, Params::roi_y3);
+    c.edge_threshold = Params::edge_threshold;
+    c.hough_rho = Params::hough_rho;
+    c.hough_theta = Params::hough_theta;
+    c.hough_threshold = Params::hough_threshold;
+    c.hough_min_length = Params::hough_min_length;
+    c.hough_max_gap = Params::hough_max_gap;
+    c.slope_min = Params::slope_min;
+    c.slope_max = Params::slope_max;
+    c.reference_height = Params::reference_height;
+    return c;
+}
+
+template <int Width, int Height, class Params>
+void LanePipeline<Width, Height, Params>::detect(const cv::Mat& frame, std::vector<cv::Vec4i>& lines)
+{
+    CV_Assert(frame.cols == Width && frame.rows == Height && (frame.type() == CV_8UC3 || frame.type() == CV_8UC1));
+    if (frame.channels() == 1)
+        run<1>(frame, nullptr, lines);
+    else
+        run<3>(frame, nullptr, lines);
+}
+
+template <int Width, int Height, class Params>
+void LanePipeline<Width, Height, Params>::detect(const cv::Mat& frame, cv::Mat& masked, std::vector<cv::Vec4i>& lines)
+{
+    CV_Assert(frame.cols == Width && frame.rows == Height && (frame.type() == CV_8UC3 || frame.type() == CV_8UC1));
+    masked.create(Geometry::BOX_H, Geometry::BOX_W, CV_8UC1);
+    if (frame.channels() == 1)
+        run<1>(frame, &masked, lines);
+    else
+        run<3>(frame, &masked, lines);
+}
+
+/**
+*@brief Edges of every mask run, voted row by row into a single-strip standard Hough transform
+*@param masked receives the masked edges of the bounding box, or nullptr to use a one-row buffer
+*/
+template <int Width, int Height, class Params>
+template <int CN>
+void LanePipeline<Width, Height, Params>::run(const cv::Mat& frame, cv::Mat* masked, std::vector<cv::Vec4i>& lines)
+{
+    engine.beginStrips(cv::Size(Geometry::BOX_W, Geometry::BOX_H), 1);
+    for (int r = 0; r < Geometry::BOX_H; r++) {
+        const lane_geometry::MaskRun& span = mask_table.run[r];
+        uchar* dst = masked != nullptr ? masked->ptr<uchar>(r) : edge_row;
+        std::memset(dst, 0, span.begin);
+        std::memset(dst + span.end, 0, Geometry::BOX_W - span.end);
+        if (span.begin < span.end)
+            edgeRow<CN>(frame, Geometry::BOX_Y + r, Geometry::BOX_X + span.begin, Geometry::BOX_X + span.end, dst + span.begin);
+        engine.voteRow(0, r, dst);
+    }
+    engine.finishStrips(lines, cv::Point(Geometry::BOX_X, Geometry::BOX_Y));
+}
+
+/**
+*@brief Edge values of frame row y, columns [x0, x1), written to dst[0 .. x1-x0)
+*/
+template <int Width, int Height, class Params>
+template <int CN>
+void LanePipeline<Width, Height, Params>::edgeRow(const cv::Mat& frame, int y, int x0, int x1, uchar* dst)
+{
+    // Columns needed: edges in [x0, x1) read bin in [x0-1, x1+1), which read blur one further out
+    const int bs = x0 > 0 ? x0 - 1 : 0;
+    const int be = x1 < Width ? x1 + 1 : Width;
+    const int vs = bs > 0 ? bs - 1 : 0;
+    const int ve = be < Width ? be + 1 : Width;
+
+    const uchar* r0 = frame.ptr<uchar>(y > 0 ? y - 1 : 1);
+    const uchar* r1 = frame.ptr<uchar>(y);
+    const uchar* r2 = frame.ptr<uchar>(y + 1 < Height ? y + 1 : Height - 2);
+    ushort* v = vsum + GUARD;
+    uchar* b = blur + GUARD;
+    uchar* t = bin + GUARD;
+
+    for (int i = CN * vs; i < CN * ve; i++)
+        v[i] = static_cast<ushort>(r0[i] + 2 * r1[i] + r2[i]);
+
+    // BORDER_REFLECT_101 columns -1 and Width go into the guard elements
+    if (vs == 0) {
+        for (int k = 0; k < CN; k++)
+            v[k - CN] = v[k + CN];
+    }
+    if (ve == Width) {
+        for (int k = 0; k < CN; k++)
+            v[CN * Width + k] = v[CN * (Width - 2) + k];
+    }
+
+    for (int i = CN * bs; i < CN * be; i++)
+        b[i] = static_cast<uchar>((v[i - CN] + 2 * v[i] + v[i + CN] + 8) >> 4);
+
+    if (CN == 1) {
+        for (int c = bs; c < be; c++)
+            t[c] = b[c] > Params::edge_threshold ? 255 : 0;
+    } else {
+        for (int c = bs; c < be; c++) {
+            const uchar* p = b + 3 * c;
+            int gray = (p[0] * B2Y + p[1] * G2Y + p[2] * R2Y + (1 << (GRAY_SHIFT - 1))) >> GRAY_SHIFT;
+            t[c] = gray > Params::edge_threshold ? 255 : 0;
+        }
+    }
+
+    for (int x = x0; x < x1; x++)
+        dst[x - x0] = t[x + 1] & static_cast<uchar>(~t[x - 1]);
+
+    // The reflected border makes the [-1 0 1] response zero in the first and last frame column
+    if (x0 == 0)
+        dst[0] = 0;
+    if (x1 == Width)
+        dst[x1 - 1 - x0] = 0;
+}
+
+template class LanePipeline<1280, 720>;
+template class LanePipeline<640, 360>;
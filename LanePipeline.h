@@ -0,0 +1,216 @@
+/**
+*@file LanePipeline.h
+*@brief Front end of the detector specialized at compile time for one frame size and tuning.
+*@brief LanePipeline<Width, Height, Params> runs the same edge + mask + Hough voting as
+*@brief LaneDetector::parallelDetect on one thread (ROI mode, standard Hough), but everything the
+*@brief runtime path derives per resolution is a constant here: the trapezoid corners, the lane
+*@brief bounding box, the mask run of every row (a constexpr table), the scaled Hough parameters,
+*@brief the edge threshold, the channel count and the fixed 3x3 / 1x3 kernel taps. The row kernel
+*@brief therefore has no ISA dispatch and no per-column border handling, and its constants are
+*@brief visible to the compiler.
+*@brief
+*@brief The mask table includes the pixels whose centers lie inside the trapezoid; cv::fillConvexPoly
+*@brief (the runtime mask) also draws the outline, so a run may differ by one pixel at its ends.
+*@brief
+*@brief The member definitions live in LanePipeline.cpp, which instantiates the supported
+*@brief configurations explicitly; add a line there for a new frame size.
+*/
+#ifndef LANE_PIPELINE_H
+#define LANE_PIPELINE_H
+
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "HoughEngine.h"
+#include "LaneDetectorConfig.h"
+
+// Compile-time tuning, the defaults of LaneDetectorConfig (tuned on the 1280x720 project videos)
+struct LaneParams
+{
+	// Lane trapezoid as fractions of width/height: bottom left, top left, top right, bottom right.
+	// The top and bottom edges must be horizontal.
+	static constexpr double roi_x0 = 210.0 / 1280.0;
+	static constexpr double roi_y0 = 1.0;
+	static constexpr double roi_x1 = 550.0 / 1280.0;
+	static constexpr double roi_y1 = 450.0 / 720.0;
+	static constexpr double roi_x2 = 717.0 / 1280.0;
+	static constexpr double roi_y2 = 450.0 / 720.0;
+	static constexpr double roi_x3 = 1.0;
+	static constexpr double roi_y3 = 1.0;
+	static constexpr int edge_threshold = 140;
+
+	// Hough parameters; threshold, min_length and max_gap are pixels at reference_height
+	static constexpr double hough_rho = 1;
+	static constexpr double hough_theta = CV_PI / 180;
+	static constexpr int hough_threshold = 20;
+	static constexpr int hough_min_length = 20;
+	static constexpr int hough_max_gap = 30;
+	static constexpr double slope_min = 0.3;
+	static constexpr double slope_max = 0.85;
+	static constexpr int reference_height = 720;
+};
+
+namespace lane_geometry {
+
+// Nearest integer with ties to even, i.e. cvRound in the default rounding mode (v >= 0)
+constexpr int roundEven(double v)
+{
+	return v - static_cast<int>(v) > 0.5 ? static_cast<int>(v) + 1
+	     : v - static_cast<int>(v) < 0.5 ? static_cast<int>(v)
+	     : static_cast<int>(v) + (static_cast<int>(v) & 1);
+}
+
+constexpr int minOf(int a, int b) { return a < b ? a : b; }
+constexpr int maxOf(int a, int b) { return a > b ? a : b; }
+constexpr int min4(int a, int b, int c, int d) { return minOf(minOf(a, b), minOf(c, d)); }
+constexpr int max4(int a, int b, int c, int d) { return maxOf(maxOf(a, b), maxOf(c, d)); }
+constexpr int clampTo(int v, int lo, int hi) { return v < lo ? lo : (v > hi ? hi : v); }
+
+// floor(a / b) and ceil(a / b) for b > 0
+constexpr int floorDiv(int a, int b) { return a >= 0 ? a / b : -((-a + b - 1) / b); }
+constexpr int ceilDiv(int a, int b) { return a >= 0 ? (a + b - 1) / b : -(-a / b); }
+
+// Column where the edge from (xa, ya) down to (xb, yb) crosses row y, rounded up or down
+constexpr int edgeCeil(int xa, int ya, int xb, int yb, int y) { return xa + ceilDiv((xb - xa) * (y - ya), yb - ya); }
+constexpr int edgeFloor(int xa, int ya, int xb, int yb, int y) { return xa + floorDiv((xb - xa) * (y - ya), yb - ya); }
+
+// 0, 1, .., N-1 as a parameter pack; built by halving so the template depth stays log2(N)
+template <int... I>
+struct IndexList {};
+
+template <class A, class B>
+struct ConcatIndices;
+
+template <int... I, int... J>
+struct ConcatIndices<IndexList<I...>, IndexList<J...> >
+{
+	typedef IndexList<I..., (static_cast<int>(sizeof...(I)) + J)...> type;
+};
+
+template <int N>
+struct MakeIndexList
+{
+	typedef typename ConcatIndices<typename MakeIndexList<N / 2>::type, typename MakeIndexList<N - N / 2>::type>::type type;
+};
+
+template <> struct MakeIndexList<0> { typedef IndexList<> type; };
+template <> struct MakeIndexList<1> { typedef IndexList<0> type; };
+
+// [begin, end) of the mask on one row of the bounding box, empty rows are [0, 0)
+struct MaskRun
+{
+	int begin;
+	int end;
+};
+
+template <int Rows>
+struct MaskTable
+{
+	MaskRun run[Rows];
+};
+
+} // namespace lane_geometry
+
+// Pixel geometry of Params for Width x Height frames, computed like LaneDetector::prepare
+template <int Width, int Height, class Params>
+struct LaneGeometry
+{
+	static constexpr int X0 = lane_geometry::roundEven(Params::roi_x0 * Width);
+	static constexpr int Y0 = lane_geometry::roundEven(Params::roi_y0 * Height);
+	static constexpr int X1 = lane_geometry::roundEven(Params::roi_x1 * Width);
+	static constexpr int Y1 = lane_geometry::roundEven(Params::roi_y1 * Height);
+	static constexpr int X2 = lane_geometry::roundEven(Params::roi_x2 * Width);
+	static constexpr int Y2 = lane_geometry::roundEven(Params::roi_y2 * Height);
+	static constexpr int X3 = lane_geometry::roundEven(Params::roi_x3 * Width);
+	static constexpr int Y3 = lane_geometry::roundEven(Params::roi_y3 * Height);
+
+	// Bounding box of the corners clipped to the frame (cv::boundingRect & frame)
+	static constexpr int BOX_X = lane_geometry::maxOf(lane_geometry::min4(X0, X1, X2, X3), 0);
+	static constexpr int BOX_Y = lane_geometry::maxOf(lane_geometry::min4(Y0, Y1, Y2, Y3), 0);
+	static constexpr int BOX_W = lane_geometry::minOf(lane_geometry::max4(X0, X1, X2, X3) + 1, Width) - BOX_X;
+	static constexpr int BOX_H = lane_geometry::minOf(lane_geometry::max4(Y0, Y1, Y2, Y3) + 1, Height) - BOX_Y;
+
+	// Hough parameters scaled to the frame height
+	static constexpr int HOUGH_THRESHOLD = lane_geometry::maxOf(1, lane_geometry::roundEven(
+		Params::hough_threshold * (static_cast<double>(Height) / Params::reference_height)));
+	static constexpr int HOUGH_MIN_LENGTH = lane_geometry::maxOf(1, lane_geometry::roundEven(
+		Params::hough_min_length * (static_cast<double>(Height) / Params::reference_height)));
+	static constexpr int HOUGH_MAX_GAP = lane_geometry::maxOf(0, lane_geometry::roundEven(
+		Params::hough_max_gap * (static_cast<double>(Height) / Params::reference_height)));
+
+	// First and one past the last mask column of box row r, in box coordinates
+	static constexpr int left(int r) { return lane_geometry::edgeCeil(X1, Y1, X0, Y0, BOX_Y + r); }
+	static constexpr int right(int r) { return lane_geometry::edgeFloor(X2, Y2, X3, Y3, BOX_Y + r) + 1; }
+	static constexpr int runBegin(int r)
+	{
+		return lane_geometry::clampTo(left(r), 0, Width) - BOX_X;
+	}
+	static constexpr int runEnd(int r)
+	{
+		return lane_geometry::clampTo(right(r), 0, Width) - BOX_X;
+	}
+	static constexpr lane_geometry::MaskRun maskRun(int r)
+	{
+		return runBegin(r) < runEnd(r) ? lane_geometry::MaskRun{ runBegin(r), runEnd(r) } : lane_geometry::MaskRun{ 0, 0 };
+	}
+
+	template <int... I>
+	static constexpr lane_geometry::MaskTable<sizeof...(I)> table(lane_geometry::IndexList<I...>)
+	{
+		return lane_geometry::MaskTable<sizeof...(I)>{ { maskRun(I)... } };
+	}
+};
+
+template <int Width, int Height, class Params = LaneParams>
+class LanePipeline
+{
+public:
+	typedef LaneGeometry<Width, Height, Params> Geometry;
+
+	static_assert(Geometry::Y1 == Geometry::Y2 && Geometry::Y0 == Geometry::Y3,
+	              "the lane trapezoid needs horizontal top and bottom edges");
+	static_assert(Geometry::Y0 > Geometry::Y1, "the bottom of the lane trapezoid must lie below its top");
+	static_assert(Geometry::BOX_W >= 3 && Geometry::BOX_H >= 1 && Geometry::BOX_Y < Height,
+	              "the lane trapezoid must overlap the frame");
+	static_assert(Width >= 3 && Height >= 2, "frames need interior pixels");
+
+	LanePipeline();
+
+	static cv::Size size() { return cv::Size(Width, Height); }
+	static cv::Rect bounds() { return cv::Rect(Geometry::BOX_X, Geometry::BOX_Y, Geometry::BOX_W, Geometry::BOX_H); }
+
+	// The same tuning as a runtime configuration, for LaneDetector
+	static LaneDetectorConfig config();
+
+	// Hough segments in frame coordinates of a Width x Height BGR or luma frame
+	void detect(const cv::Mat& frame, std::vector<cv::Vec4i>& lines);
+
+	// The same, also keeping the masked edges of the lane bounding box
+	void detect(const cv::Mat& frame, cv::Mat& masked, std::vector<cv::Vec4i>& lines);
+
+	// Mask run of every bounding box row
+	static constexpr lane_geometry::MaskTable<Geometry::BOX_H> mask_table =
+		Geometry::table(typename lane_geometry::MakeIndexList<Geometry::BOX_H>::type());
+
+private:
+	static const int GUARD = 16;    // Elements before column 0 of the row buffers (reflected taps)
+
+	HoughEngine engine;
+	ushort vsum[3 * Width + 2 * GUARD];     // Vertical [1 2 1] sums of the interleaved row
+	uchar blur[3 * Width + 2 * GUARD];      // Blurred interleaved row
+	uchar bin[Width + 2 * GUARD];           // Thresholded gray row (0 / 255)
+	uchar edge_row[Geometry::BOX_W];        // Masked edges of one box row when they are not kept
+
+	template <int CN>
+	void run(const cv::Mat& frame, cv::Mat* masked, std::vector<cv::Vec4i>& lines);
+
+	template <int CN>
+	void edgeRow(const cv::Mat& frame, int y, int x0, int x1, uchar* dst);
+};
+
+// The configurations built into the detector
+typedef LanePipeline<1280, 720> LanePipeline720p;
+typedef LanePipeline<640, 360> LanePipeline360p;
+extern template class LanePipeline<1280, 720>;
+extern template class LanePipeline<640, 360>;
+
+#endif // LANE_PIPELINE_H
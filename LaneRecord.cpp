@@ -0,0 +1,184 @@
+/**
+*@file LaneRecord.cpp
+*@brief Lane record construction and the CSV / NDJSON / binary writers.
+*/
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include "LaneRecord.h"
+
+namespace {
+
+// Line segments on one side for that side to count as fully confident
+const int confident_segments = 4;
+
+// Binary file header: magic, record size, format version
+const char binary_magic[8] = { 'L', 'A', 'N', 'E', 'R', 'E', 'C', '1' };
+const uint32_t binary_version = 1;
+
+float sideConfidence(bool measured, size_t segments)
+{
+    if (!measured)
+        return 0.0f;
+    return 0.5f * std::min(1.0f, static_cast<float>(segments) / confident_segments);
+}
+
+} // namespace
+
+/**
+*@brief The confidence is 0.5 per side measured in this frame, scaled down when the side
+*@brief is supported by fewer than confident_segments Hough segments. A side that only
+*@brief reuses the previous fit (or coasts on the tracker) adds nothing.
+*/
+void makeLaneRecord(LaneDetector& detector, long frame, double fps, bool detected,
+                    const std::string& turn, LaneRecord& record)
+{
+    std::memset(&record, 0, sizeof(record));
+    record.frame = frame;
+    record.timestamp_ms = fps > 0 ? frame * 1000.0 / fps : 0.0;
+    record.right_slope = std::numeric_limits<float>::quiet_NaN();
+    record.left_slope = std::numeric_limits<float>::quiet_NaN();
+    record.turn = TURN_NONE;
+    if (!detected)
+        return;
+
+    const FrameWorkspace& work = detector.workspace();
+    for (int i = 0; i < 4; i++) {
+        record.points[2 * i] = work.lane[i].x;
+        record.points[2 * i + 1] = work.lane[i].y;
+    }
+    if (detector.rightDetected())
+        record.right_slope = static_cast<float>(detector.rightSlope());
+    if (detector.leftDetected())
+        record.left_slope = static_cast<float>(detector.leftSlope());
+    record.confidence = sideConfidence(detector.rightDetected(), work.left_right_lines[0].size()) +
+                        sideConfidence(detector.leftDetected(), work.left_right_lines[1].size());
+    record.detected = 1;
+    record.turn = turnLabel(turn);
+}
+
+TurnLabel turnLabel(const std::string& turn)
+{
+    if (turn == "Turn left")
+        return TURN_LEFT;
+    if (turn == "Turn right")
+        return TURN_RIGHT;
+    if (turn == "Straight")
+        return TURN_STRAIGHT;
+    return TURN_NONE;
+}
+
+const char* turnLabelName(TurnLabel label)
+{
+    switch (label) {
+    case TURN_LEFT: return "left";
+    case TURN_RIGHT: return "right";
+    case TURN_STRAIGHT: return "straight";
+    default: return "none";
+    }
+}
+
+RecordWriter::RecordWriter()
+    : file(nullptr), format(FORMAT_CSV), count(0), buffer(1 << 16)
+{
+}
+
+RecordWriter::~RecordWriter()
+{
+    close();
+}
+
+bool RecordWriter::open(const std::string& path, Format format)
+{
+    close();
+    file = std::fopen(path.c_str(), format == FORMAT_BINARY ? "wb" : "w");
+    if (file == nullptr)
+        return false;
+    std::setvbuf(file, buffer.data(), _IOFBF, buffer.size());
+    this->format = format;
+    count = 0;
+
+    if (format == FORMAT_CSV) {
+        std::fputs("frame,timestamp_ms,detected,"
+                   "right_bottom_x,right_bottom_y,right_top_x,right_top_y,"
+                   "left_bottom_x,left_bottom_y,left_top_x,left_top_y,"
+                   "right_slope,left_slope,turn,confidence\n", file);
+    } else if (format == FORMAT_BINARY) {
+        uint32_t header[2] = { static_cast<uint32_t>(sizeof(LaneRecord)), binary_version };
+        std::fwrite(binary_magic, sizeof(binary_magic), 1, file);
+        std::fwrite(header, sizeof(header), 1, file);
+    }
+    return true;
+}
+
+void RecordWriter::close()
+{
+    if (file != nullptr) {
+        std::fclose(file);
+        file = nullptr;
+    }
+}
+
+/**
+*@brief Append one record; text formats leave the slope empty (CSV) or null (NDJSON) when it is NaN
+*/
+void RecordWriter::write(const LaneRecord& r)
+{
+    if (file == nullptr)
+        return;
+    count++;
+
+    if (format == FORMAT_BINARY) {
+        std::fwrite(&r, sizeof(r), 1, file);
+        return;
+    }
+
+    const int* p = r.points;
+    const char* turn = turnLabelName(static_cast<TurnLabel>(r.turn));
+    char right_slope[32] = "";
+    char left_slope[32] = "";
+    if (!std::isnan(r.right_slope))
+        std::snprintf(right_slope, sizeof(right_slope), "%.5f", r.right_slope);
+    if (!std::isnan(r.left_slope))
+        std::snprintf(left_slope, sizeof(left_slope), "%.5f", r.left_slope);
+
+    if (format == FORMAT_CSV) {
+        std::fprintf(file, "%lld,%.3f,%d,%d,%d,%d,%d,%d,%d,%d,%d,%s,%s,%s,%.3f\n",
+                     static_cast<long long>(r.frame), r.timestamp_ms, r.detected,
+                     p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7],
+                     right_slope, left_slope, turn, r.confidence);
+    } else {
+        std::fprintf(file, "{\"frame\":%lld,\"timestamp_ms\":%.3f,\"detected\":%s,"
+                     "\"right\":[%d,%d,%d,%d],\"left\":[%d,%d,%d,%d],"
+                     "\"right_slope\":%s,\"left_slope\":%s,\"turn\":\"%s\",\"confidence\":%.3f}\n",
+                     static_cast<long long>(r.frame), r.timestamp_ms, r.detected ? "true" : "false",
+                     p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7],
+                     right_slope[0] ? right_slope : "null", left_slope[0] ? left_slope : "null",
+                     turn, r.confidence);
+    }
+}
+
+bool RecordWriter::formatFromPath(const std::string& path, Format& format)
+{
+    size_t dot = path.find_last_of('.');
+    std::string ext = dot == std::string::npos ? "" : path.substr(dot);
+    if (ext == ".csv")
+        format = FORMAT_CSV;
+    else if (ext == ".ndjson" || ext == ".jsonl")
+        format = FORMAT_NDJSON;
+    else if (ext == ".bin")
+        format = FORMAT_BINARY;
+    else
+        return false;
+    return true;
+}
+
+const char* RecordWriter::extension(Format format)
+{
+    switch (format) {
+    case FORMAT_NDJSON: return ".ndjson";
+    case FORMAT_BINARY: return ".bin";
+    default: return ".csv";
+    }
+}
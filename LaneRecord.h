@@ -0,0 +1,84 @@
+/**
+*@file LaneRecord.h
+*@brief Compact per-frame lane result for headless runs.
+*@brief A LaneRecord holds the lane geometry and turn decision of one frame; RecordWriter
+*@brief streams records as CSV, NDJSON or fixed-size binary without rendering or encoding.
+*/
+#ifndef LANE_RECORD_H
+#define LANE_RECORD_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "LaneDetector.h"
+
+enum TurnLabel
+{
+	TURN_NONE = 0,      // No lane in this frame
+	TURN_LEFT,
+	TURN_RIGHT,
+	TURN_STRAIGHT
+};
+
+// Fixed layout, written as-is (host byte order) by the binary format
+struct LaneRecord
+{
+	int64_t frame;          // Frame index from 0
+	double timestamp_ms;    // Stream time: frame / fps
+	int32_t points[8];      // Right bottom x,y, right top x,y, left bottom x,y, left top x,y
+	float right_slope;      // dy/dx of the fitted line, NaN when the side had no lines this frame
+	float left_slope;       //
+	float confidence;       // 0..1, see makeLaneRecord
+	uint8_t detected;       // 1 if a lane was found
+	uint8_t turn;           // TurnLabel
+	uint8_t reserved[2];
+};
+
+/**
+*@brief Fill a record from the detector state after detectFrame
+*@param detector is the detector that processed the frame
+*@param frame is the frame index
+*@param fps is the stream frame rate used for the timestamp
+*@param detected tells if detectFrame found a lane
+*@param turn is the turn prediction of the frame
+*@param record receives the result
+*/
+void makeLaneRecord(LaneDetector& detector, long frame, double fps, bool detected,
+                    const std::string& turn, LaneRecord& record);
+
+// Map the predictTurn string to a label and back
+TurnLabel turnLabel(const std::string& turn);
+const char* turnLabelName(TurnLabel label);
+
+class RecordWriter
+{
+public:
+	enum Format { FORMAT_CSV = 0, FORMAT_NDJSON, FORMAT_BINARY };
+
+	RecordWriter();
+	~RecordWriter();
+
+	RecordWriter(const RecordWriter&) = delete;
+	RecordWriter& operator=(const RecordWriter&) = delete;
+
+	// Create the file and write the CSV header / binary file header
+	bool open(const std::string& path, Format format);
+	bool isOpened() const { return file != nullptr; }
+	void close();
+
+	void write(const LaneRecord& record);
+	long records() const { return count; }
+
+	// .csv, .ndjson/.jsonl or .bin; false for any other extension
+	static bool formatFromPath(const std::string& path, Format& format);
+	static const char* extension(Format format);
+
+private:
+	FILE* file;
+	Format format;
+	long count;
+	std::vector<char> buffer;   // stdio buffer, large enough to batch many records per write
+};
+
+#endif // LANE_RECORD_H
@@ -0,0 +1,154 @@
+/**
+*@file LaneService.cpp
+*@brief Serving loop of the shared-memory detection service.
+*@brief A frame slot stays owned by the service until its result is published, since detection
+*@brief reads the pixels in place; the producer therefore sees at most slots frames in flight.
+*/
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include "LaneService.h"
+#include "Tracer.h"
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double msSince(Clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+extern "C" void onStopSignal(int)
+{
+    LaneService::stop();
+}
+
+} // namespace
+
+std::atomic<bool> LaneService::stopping(false);
+
+LaneService::LaneService(LaneDetector& detector, const DetectOptions& options, const std::string& name,
+                         int slots, cv::Size max_size)
+    : detector(detector), name(name), slot_count(std::max(slots, 1)), max_size(max_size), options(options),
+      processed(0), rejected(0), streams(0), idle_ms(0.0), blocked_ms(0.0)
+{
+    this->options.plot = false;
+    this->options.edge_image = false;
+}
+
+void LaneService::installSignalHandlers()
+{
+    std::signal(SIGINT, onStopSignal);
+    std::signal(SIGTERM, onStopSignal);
+}
+
+bool LaneService::open()
+{
+    size_t frame_bytes = FRAME_DATA_OFFSET + static_cast<size_t>(max_size.width) * max_size.height * 3;
+    // Every frame slot can have its result waiting, so the producer is never the one to stall both rings
+    return frames.create(frameRingName(name), slot_count, frame_bytes) &&
+           results.create(resultRingName(name), slot_count, sizeof(ResultMessage));
+}
+
+/**
+*@brief Yield, then sleep 50 us at a time while there is nothing to do, until stop()
+*/
+long LaneService::run()
+{
+    std::string turn;
+    cv::Mat edge_frame;
+    cv::Mat edge_bgr;
+    stopping.store(false, std::memory_order_relaxed);
+    Tracer::setThreadName("service");
+
+    while (!stopping.load(std::memory_order_relaxed)) {
+        FrameMessage* in = static_cast<FrameMessage*>(frames.tryAcquireRead());
+        if (in == nullptr) {
+            Clock::time_point t0 = Clock::now();
+            for (int spins = 0; (in = static_cast<FrameMessage*>(frames.tryAcquireRead())) == nullptr &&
+                                !stopping.load(std::memory_order_relaxed); spins++) {
+                if (spins < 1024)
+                    std::this_thread::yield();
+                else
+                    std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+            idle_ms += msSince(t0);
+            if (in == nullptr)
+                break;
+        }
+
+        ResultMessage* out = static_cast<ResultMessage*>(results.tryAcquireWrite());
+        if (out == nullptr) {
+            TraceScope trace("wait result ring");
+            Clock::time_point t0 = Clock::now();
+            while ((out = static_cast<ResultMessage*>(results.tryAcquireWrite())) == nullptr &&
+                   !stopping.load(std::memory_order_relaxed))
+                std::this_thread::yield();
+            blocked_ms += msSince(t0);
+            if (out == nullptr)
+                break;
+        }
+
+        handle(*in, *out, turn, edge_frame, edge_bgr);
+        frames.releaseRead();
+        results.commitWrite();
+    }
+    return processed;
+}
+
+void LaneService::handle(const FrameMessage& in, ResultMessage& out, std::string& turn, cv::Mat& edge_frame, cv::Mat& edge_bgr)
+{
+    std::memset(&out, 0, sizeof(out));
+    out.sent_ns = in.sent_ns;
+    out.record.frame = in.frame;
+
+    // 一路输入结束：下一路从头开始跟踪
+    if (in.flags & MESSAGE_END_OF_STREAM) {
+        out.flags = MESSAGE_END_OF_STREAM;
+        detector.resetStream();
+        streams++;
+        return;
+    }
+
+    size_t bytes = static_cast<size_t>(in.width) * in.height * in.channels;
+    if ((in.channels != 1 && in.channels != 3) || in.width < 3 || in.height < 2 ||
+        FRAME_DATA_OFFSET + bytes > frames.slotBytes()) {
+        out.flags = MESSAGE_REJECTED;
+        rejected++;
+        return;
+    }
+
+    // 直接在共享内存中的帧上检测，不复制
+    cv::Mat frame(in.height, in.width, in.channels == 1 ? CV_8UC1 : CV_8UC3,
+                  reinterpret_cast<uchar*>(const_cast<FrameMessage*>(&in)) + FRAME_DATA_OFFSET);
+    Tracer::setFrame(in.frame);
+    Clock::time_point t0 = Clock::now();
+    int flag_plot;
+    {
+        TraceScope trace("detect");
+        flag_plot = detectFrame(detector, frame, options, edge_frame, edge_bgr, turn);
+    }
+    int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count();
+
+    makeLaneRecord(detector, in.frame, in.fps, flag_plot == 0, turn, out.record);
+    out.detect_ns = ns;
+    detect_latency.record(static_cast<uint64_t>(ns));
+    processed++;
+}
+
+void LaneService::printReport() const
+{
+    std::cout << "\n检测服务统计 (" << frameRingName(name) << ", " << slot_count << " 槽)" << std::endl;
+    std::cout << "├── 处理帧数: " << processed << ", 拒绝帧数: " << rejected << ", 输入流: " << streams << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "├── 检测耗时(ms): 平均 " << detect_latency.meanMs() << ", p50 " << detect_latency.percentileMs(50)
+              << ", p95 " << detect_latency.percentileMs(95) << ", p99 " << detect_latency.percentileMs(99)
+              << ", 最大 " << detect_latency.maxMs() << std::endl;
+    std::cout << "└── 等待帧: " << idle_ms << " ms, 等待结果读取: " << blocked_ms << " ms" << std::endl;
+    std::cout.unsetf(std::ios::fixed);
+}
@@ -0,0 +1,98 @@
+/**
+*@file LaneService.h
+*@brief Long-running detection service fed through shared memory.
+*@brief The service creates two ShmRings named after the service: producers write raw frames
+*@brief (BGR or a Y plane, rows packed) into the frame ring, the service runs detectFrame on each
+*@brief slot in place, without copying it, and answers with a LaneRecord in the result ring.
+*@brief One producer at a time; a producer ends its stream with an end-of-stream message, which
+*@brief resets the tracked lane and is echoed once all earlier results are in the result ring.
+*@brief Startup (OpenCV, tables, buffers) is paid once; an idle service polls with backoff.
+*/
+#ifndef LANE_SERVICE_H
+#define LANE_SERVICE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <opencv2/opencv.hpp>
+#include "FramePipeline.h"
+#include "LaneRecord.h"
+#include "PerfStats.h"
+#include "ShmRing.h"
+
+enum MessageFlags
+{
+	MESSAGE_END_OF_STREAM = 1,  // No frame; the producer's stream ends here
+	MESSAGE_REJECTED = 2        // Result only: the frame did not fit the slot or had a bad format
+};
+
+// Start of a frame ring slot; the pixels follow at LaneService::FRAME_DATA_OFFSET
+struct FrameMessage
+{
+	int64_t frame;              // Frame index in the producer's stream
+	int64_t sent_ns;            // steady_clock time the producer published the slot
+	double fps;                 // Stream frame rate, for the record timestamps
+	int32_t width;
+	int32_t height;
+	int32_t channels;           // 1 (Y plane) or 3 (BGR), rows of width * channels bytes
+	uint32_t flags;             // MessageFlags
+};
+
+// One result ring slot
+struct ResultMessage
+{
+	int64_t sent_ns;            // Copied from the frame, for the round-trip latency
+	int64_t detect_ns;          // Time spent in detectFrame
+	uint32_t flags;             // MessageFlags
+	uint32_t reserved;
+	LaneRecord record;
+};
+
+class LaneService
+{
+public:
+	static const size_t FRAME_DATA_OFFSET = 64;
+
+	// slots frames of up to max_size BGR pixels can be queued; options selects the edge path
+	// (plotting and the edge image are always off)
+	LaneService(LaneDetector& detector, const DetectOptions& options, const std::string& name, int slots, cv::Size max_size);
+
+	// Create both rings; false if shared memory is unavailable
+	bool open();
+
+	// Serve until stop() is called; returns the number of frames processed
+	long run();
+
+	// Ask run() to return, e.g. from a signal handler
+	static void stop() { stopping.store(true, std::memory_order_relaxed); }
+
+	// SIGINT and SIGTERM call stop()
+	static void installSignalHandlers();
+
+	void printReport() const;
+
+	// Names of the two rings of a service
+	static std::string frameRingName(const std::string& name) { return "/lane-" + name + "-frames"; }
+	static std::string resultRingName(const std::string& name) { return "/lane-" + name + "-results"; }
+
+private:
+	LaneDetector& detector;
+	std::string name;
+	int slot_count;
+	cv::Size max_size;
+	ShmRing frames;
+	ShmRing results;
+	DetectOptions options;      // Records only: nothing is drawn into the producer's frames
+	long processed;
+	long rejected;
+	long streams;
+	double idle_ms;             // Waiting for frames
+	double blocked_ms;          // Waiting for the producer to read results
+	LatencyHistogram detect_latency;
+
+	static std::atomic<bool> stopping;
+
+	void handle(const FrameMessage& in, ResultMessage& out, std::string& turn, cv::Mat& edge_frame, cv::Mat& edge_bgr);
+};
+
+#endif // LANE_SERVICE_H
@@ -0,0 +1,163 @@
+/**
+*@file LaneTracker.cpp
+*@brief Alpha-beta filter and lock logic of the lane tracker.
+*/
+#include <cmath>
+#include "LaneTracker.h"
+
+namespace {
+
+// Filter gains: position and velocity correction per frame
+const double ALPHA = 0.4;
+const double BETA = 0.05;
+
+// A measurement further than this from the prediction is rejected (bottom / top row, px at 720 rows)
+const double GATE_BOTTOM = 60.0;
+const double GATE_TOP = 30.0;
+
+// Consistent frames needed to lock, coasting frames tolerated before the lock is dropped
+const int LOCK_HITS = 5;
+const int MAX_MISSES = 3;
+
+// Search band half width at the bottom / top row, widened per coasting frame (px at 720 rows)
+const double BAND_BOTTOM = 50.0;
+const double BAND_TOP = 20.0;
+const double BAND_GROWTH = 10.0;
+
+} // namespace
+
+LaneTracker::LaneTracker()
+    : y_bottom(0.0), y_top(0.0), pixel_scale(1.0), is_locked(false), locked_frames(0), search_frames(0), lock_losses(0)
+{
+    reset();
+}
+
+void LaneTracker::reset()
+{
+    for (int i = 0; i < 2; i++) {
+        sides[i].initialized = false;
+        sides[i].xb = sides[i].xt = 0.0;
+        sides[i].vb = sides[i].vt = 0.0;
+        sides[i].hits = 0;
+        sides[i].misses = 0;
+    }
+    is_locked = false;
+}
+
+void LaneTracker::predict(SideState& s)
+{
+    s.xb += s.vb;
+    s.xt += s.vt;
+}
+
+void LaneTracker::correct(SideState& s, double xb, double xt)
+{
+    double rb = xb - s.xb;
+    double rt = xt - s.xt;
+    s.xb += ALPHA * rb;
+    s.xt += ALPHA * rt;
+    s.vb += BETA * rb;
+    s.vt += BETA * rt;
+}
+
+/**
+*@brief Advance both sides by one frame and fold in the measured lines
+*@param valid tells for each side (RIGHT, LEFT) whether a line was fitted this frame
+*@param x_bottom is the fitted x at y_bottom for each side
+*@param x_top is the fitted x at y_top for each side
+*/
+void LaneTracker::update(const bool valid[2], const double x_bottom[2], const double x_top[2],
+                         double y_bottom_, double y_top_)
+{
+    if (is_locked)
+        locked_frames++;
+    else
+        search_frames++;
+
+    y_bottom = y_bottom_;
+    y_top = y_top_;
+
+    for (int i = 0; i < 2; i++) {
+        SideState& s = sides[i];
+        bool measured = valid[i] && std::isfinite(x_bottom[i]) && std::isfinite(x_top[i]);
+
+        if (!s.initialized) {
+            // First measurement of this side starts the track at rest
+            if (measured) {
+                s.initialized = true;
+                s.xb = x_bottom[i];
+                s.xt = x_top[i];
+                s.vb = s.vt = 0.0;
+                s.hits = 1;
+                s.misses = 0;
+            }
+            continue;
+        }
+
+        predict(s);
+        double growth = s.misses * BAND_GROWTH;
+        bool accepted = measured && std::fabs(x_bottom[i] - s.xb) <= (GATE_BOTTOM + growth) * pixel_scale &&
+                        std::fabs(x_top[i] - s.xt) <= (GATE_TOP + growth) * pixel_scale;
+
+        if (accepted) {
+            correct(s, x_bottom[i], x_top[i]);
+            s.hits++;
+            s.misses = 0;
+        } else if (measured && !is_locked) {
+            // While searching a disagreeing measurement restarts the side instead of coasting
+            s.xb = x_bottom[i];
+            s.xt = x_top[i];
+            s.vb = s.vt = 0.0;
+            s.hits = 1;
+            s.misses = 0;
+        } else {
+            s.hits = 0;
+            s.misses++;
+        }
+    }
+
+    updateLock();
+}
+
+void LaneTracker::miss()
+{
+    bool valid[2] = { false, false };
+    double none[2] = { 0.0, 0.0 };
+    update(valid, none, none, y_bottom, y_top);
+}
+
+void LaneTracker::updateLock()
+{
+    if (is_locked) {
+        if (sides[RIGHT].misses > MAX_MISSES || sides[LEFT].misses > MAX_MISSES) {
+            // Confidence is gone: search the full ROI again from the last estimate
+            is_locked = false;
+            lock_losses++;
+            sides[RIGHT].hits = sides[LEFT].hits = 0;
+        }
+    } else if (hasModel() && sides[RIGHT].hits >= LOCK_HITS && sides[LEFT].hits >= LOCK_HITS) {
+        is_locked = true;
+    }
+}
+
+double LaneTracker::x(Side side, double y) const
+{
+    const SideState& s = sides[side];
+    if (y_bottom == y_top)
+        return s.xb;
+    return s.xb + (s.xt - s.xb) * (y - y_bottom) / (y_top - y_bottom);
+}
+
+double LaneTracker::predictedX(Side side, double y) const
+{
+    const SideState& s = sides[side];
+    double t = y_bottom == y_top ? 0.0 : (y - y_bottom) / (y_top - y_bottom);
+    return x(side, y) + s.vb + (s.vt - s.vb) * t;
+}
+
+double LaneTracker::bandHalfWidth(Side side, double y) const
+{
+    double t = y_bottom == y_top ? 0.0 : (y - y_bottom) / (y_top - y_bottom);
+    t = t < 0.0 ? 0.0 : (t > 1.0 ? 1.0 : t);
+    return (BAND_BOTTOM + (BAND_TOP - BAND_BOTTOM) * t + sides[side].misses * BAND_GROWTH) * pixel_scale;
+}
@@ -0,0 +1,77 @@
+/**
+*@file LaneTracker.h
+*@brief Temporal smoothing of the two lane boundary lines with an alpha-beta filter.
+*@brief Each line is tracked by its x position at the bottom row and at the top row of the lane
+*@brief (the two rows regression draws between), each with a velocity. After a few consistent
+*@brief frames the tracker locks, and LaneDetector then only processes a narrow band around the
+*@brief predicted lines; when a side keeps missing or jumps out of the gate the lock is dropped
+*@brief and detection goes back to the full ROI.
+*/
+#ifndef LANE_TRACKER_H
+#define LANE_TRACKER_H
+
+class LaneTracker
+{
+public:
+	enum Side { RIGHT = 0, LEFT = 1 };
+
+	LaneTracker();
+
+	// Forget both lines and the lock
+	void reset();
+
+	// Feed one frame: for each side whether it was measured and its x at y_bottom / y_top
+	void update(const bool valid[2], const double x_bottom[2], const double x_top[2],
+	            double y_bottom, double y_top);
+
+	// Frame without any line measurement
+	void miss();
+
+	// Scale of the pixel gates and bands, tuned for 720-row frames (frame height / 720)
+	void setPixelScale(double scale) { pixel_scale = scale; }
+
+	// Both sides have an estimate (possibly coasting)
+	bool hasModel() const { return sides[RIGHT].initialized && sides[LEFT].initialized; }
+
+	// Both sides matched the prediction long enough to restrict the search
+	bool locked() const { return is_locked; }
+
+	// Smoothed x of a side at frame row y
+	double x(Side side, double y) const;
+
+	// Where the side is expected in the next frame (smoothed x plus one frame of velocity)
+	double predictedX(Side side, double y) const;
+
+	// Half width of the search band at frame row y, grows while a side is coasting
+	double bandHalfWidth(Side side, double y) const;
+
+	// Statistics since construction
+	long lockedFrames() const { return locked_frames; }
+	long searchFrames() const { return search_frames; }
+	long lockLosses() const { return lock_losses; }
+
+private:
+	struct SideState
+	{
+		bool initialized;
+		double xb, xt;      // x at the bottom / top row
+		double vb, vt;      // Per-frame velocity of both
+		int hits;           // Consecutive frames that matched the prediction
+		int misses;         // Consecutive frames without an accepted measurement
+	};
+
+	SideState sides[2];
+	double y_bottom;
+	double y_top;
+	double pixel_scale;
+	bool is_locked;
+	long locked_frames;
+	long search_frames;
+	long lock_losses;
+
+	void predict(SideState& s);
+	void correct(SideState& s, double xb, double xt);
+	void updateLock();
+};
+
+#endif // LANE_TRACKER_H
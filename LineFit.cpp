@@ -0,0 +1,112 @@
+/**
+*@file LineFit.cpp
+*@brief Moments, orthogonal solve and Huber reweighting of the streaming line fit.
+*/
+#include <algorithm>
+#include <cmath>
+#include "LineFit.h"
+
+namespace {
+
+// Segments shorter than this still count as this long, so a degenerate segment is not lost
+const double MIN_LENGTH = 1.0;
+
+// Huber iterations stop once the line moves less than this (px over the segment extent)
+const double CONVERGED_PX = 0.01;
+
+} // namespace
+
+void LineFit::reset()
+{
+    segments = 0;
+    sw = sx = sy = sxx = syy = sxy = 0.0;
+}
+
+/**
+*@brief A uniformly weighted segment from p0 to p1 has mean (p0 + p1) / 2 and second central
+*@brief moment d*d^T / 12 with d = p1 - p0; both are added scaled by length * weight
+*/
+void LineFit::add(const cv::Vec4i& s, double weight)
+{
+    double dx = s[2] - s[0];
+    double dy = s[3] - s[1];
+    double mx = 0.5 * (s[0] + s[2]);
+    double my = 0.5 * (s[1] + s[3]);
+    double w = std::max(std::sqrt(dx * dx + dy * dy), MIN_LENGTH) * weight;
+
+    segments++;
+    sw += w;
+    sx += w * mx;
+    sy += w * my;
+    sxx += w * (mx * mx + dx * dx / 12.0);
+    syy += w * (my * my + dy * dy / 12.0);
+    sxy += w * (mx * my + dx * dy / 12.0);
+}
+
+/**
+*@brief The direction is the principal axis of the covariance: angle 0.5 * atan2(2 cxy, cxx - cyy)
+*/
+bool LineFit::solve(double& vx, double& vy, double& x0, double& y0) const
+{
+    if (segments == 0 || !(sw > 0.0))
+        return false;
+
+    double cx = sx / sw;
+    double cy = sy / sw;
+    double cxx = sxx / sw - cx * cx;
+    double cyy = syy / sw - cy * cy;
+    double cxy = sxy / sw - cx * cy;
+    if (!(cxx + cyy > 0.0))
+        return false;
+
+    double angle = 0.5 * std::atan2(2.0 * cxy, cxx - cyy);
+    vx = std::cos(angle);
+    vy = std::sin(angle);
+    x0 = cx;
+    y0 = cy;
+    return std::isfinite(vx) && std::isfinite(vy) && std::isfinite(x0) && std::isfinite(y0);
+}
+
+/**
+*@brief The distance to the line changes linearly along a segment, so the mean squared distance
+*@brief over it is (d0^2 + d0*d1 + d1^2) / 3 for end distances d0 and d1
+*/
+bool LineFit::solveHuber(const std::vector<cv::Vec4i>& lines, double k, int max_iterations,
+                         double& vx, double& vy, double& x0, double& y0)
+{
+    if (!solve(vx, vy, x0, y0))
+        return false;
+
+    for (int it = 0; it < max_iterations; it++) {
+        // Normal of the current line
+        double nx = -vy;
+        double ny = vx;
+        double span = 0.0;
+
+        reset();
+        for (const auto& s : lines) {
+            double d0 = (s[0] - x0) * nx + (s[1] - y0) * ny;
+            double d1 = (s[2] - x0) * nx + (s[3] - y0) * ny;
+            double r = std::sqrt((d0 * d0 + d0 * d1 + d1 * d1) / 3.0);
+            add(s, r <= k ? 1.0 : k / r);
+            span = std::max(span, std::max(std::fabs((s[0] - x0) * vx + (s[1] - y0) * vy),
+                                           std::fabs((s[2] - x0) * vx + (s[3] - y0) * vy)));
+        }
+
+        double px = vx, py = vy, qx = x0, qy = y0;
+        if (!solve(vx, vy, x0, y0))
+            return false;
+
+        // Largest displacement of the line over the extent of the segments
+        double dir = vx * px + vy * py;
+        if (dir < 0.0) {
+            vx = -vx;
+            vy = -vy;
+        }
+        double shift = std::fabs((x0 - qx) * -py + (y0 - qy) * px);
+        double turn = std::fabs(vx * py - vy * px) * span;
+        if (shift + turn < CONVERGED_PX)
+            break;
+    }
+    return true;
+}
@@ -0,0 +1,46 @@
+/**
+*@file LineFit.h
+*@brief Streaming length-weighted line fit of Hough segments.
+*@brief Each segment is integrated along its length into running moments (sum of weights, x, y,
+*@brief xx, yy, xy), so segments are fitted while they are classified and no point list is built.
+*@brief The line is the orthogonal least-squares fit of the moments (the DIST_L2 line of
+*@brief cv::fitLine, with every segment counted by its length). An optional Huber reweighting
+*@brief runs a fixed number of passes over the segments to suppress outliers.
+*/
+#ifndef LINE_FIT_H
+#define LINE_FIT_H
+
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+class LineFit
+{
+public:
+	LineFit() { reset(); }
+
+	void reset();
+
+	// Add a segment (x0, y0, x1, y1); its length times weight is its share of the fit
+	void add(const cv::Vec4i& segment, double weight = 1.0);
+
+	int count() const { return segments; }
+
+	// Orthogonal least-squares line: unit direction (vx, vy) through (x0, y0).
+	// False without segments or when the moments are degenerate.
+	bool solve(double& vx, double& vy, double& x0, double& y0) const;
+
+	// Huber IRLS starting from the current moments: up to max_iterations passes over the
+	// segments, each reweighting a segment by min(1, k / rms distance to the line) and
+	// refitting. Stops early once the line moves less than a hundredth of a pixel.
+	// The moments are left holding the last weighting.
+	bool solveHuber(const std::vector<cv::Vec4i>& lines, double k, int max_iterations,
+	                double& vx, double& vy, double& x0, double& y0);
+
+private:
+	int segments;
+	double sw;                  // Sum of weights
+	double sx, sy;              // Weighted sums of x, y
+	double sxx, syy, sxy;       // Weighted sums of x*x, y*y, x*y
+};
+
+#endif // LINE_FIT_H
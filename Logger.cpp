@@ -0,0 +1,251 @@
+/**
+*@file Logger.cpp
+*@brief Bounded MPSC ring (per-slot sequence numbers) and the background writer of Logger.
+*@brief A slot whose sequence equals the enqueue position is free; a producer claims it by
+*@brief advancing the position with a CAS, fills it and publishes it as position + 1. The writer
+*@brief reads slots in order and frees each one for the next lap as position + capacity.
+*/
+#include <algorithm>
+#include <cstdarg>
+#include <cstring>
+#include "Logger.h"
+
+namespace {
+
+// Writer sleep while the ring is empty
+const int IDLE_SLEEP_US = 1000;
+
+} // namespace
+
+Logger::Logger(size_t capacity)
+    : enqueue_pos(0), dequeue_pos(0), min_level(LOG_INFO), rate_limit(0), rate_window(-1), rate_count(0),
+      written_count(0), dropped_count(0), suppressed_count(0), stopping(false), out(nullptr), owns_file(false),
+      epoch(std::chrono::steady_clock::now())
+{
+    size_t size = 2;
+    while (size < capacity)
+        size *= 2;
+    std::vector<Entry> slots(size);
+    ring.swap(slots);
+    mask = size - 1;
+    for (size_t i = 0; i < size; i++)
+        ring[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+Logger::~Logger()
+{
+    stop();
+}
+
+bool Logger::start(const std::string& path)
+{
+    stop();
+    if (path.empty() || path == "-") {
+        out = stdout;
+        owns_file = false;
+    } else {
+        out = std::fopen(path.c_str(), "w");
+        if (out == nullptr)
+            return false;
+        owns_file = true;
+    }
+    stopping.store(false, std::memory_order_relaxed);
+    writer = std::thread(&Logger::writeLoop, this);
+    return true;
+}
+
+void Logger::stop()
+{
+    if (!writer.joinable())
+        return;
+    stopping.store(true, std::memory_order_release);
+    writer.join();
+    if (owns_file)
+        std::fclose(out);
+    else
+        std::fflush(out);
+    out = nullptr;
+}
+
+int64_t Logger::nowUs() const
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+/**
+*@brief Level filter and the per-second budget; errors are never rate limited
+*/
+bool Logger::admit(LogLevel level, int64_t now_us)
+{
+    if (!enabled(level))
+        return false;
+    int limit = rate_limit.load(std::memory_order_relaxed);
+    if (limit <= 0 || level >= LOG_ERROR)
+        return true;
+
+    int64_t second = now_us / 1000000;
+    int64_t window = rate_window.load(std::memory_order_relaxed);
+    if (window != second && rate_window.compare_exchange_strong(window, second, std::memory_order_relaxed))
+        rate_count.store(0, std::memory_order_relaxed);
+    if (rate_count.fetch_add(1, std::memory_order_relaxed) >= limit) {
+        suppressed_count.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+/**
+*@brief Claim the next free slot, or nullptr (counted as dropped) when the writer is a lap behind
+*/
+Logger::Entry* Logger::claim(size_t& position)
+{
+    size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+    while (true) {
+        Entry* e = &ring[pos & mask];
+        size_t seq = e->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                position = pos;
+                return e;
+            }
+        } else if (diff < 0) {
+            dropped_count.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        } else {
+            pos = enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void Logger::publish(Entry* entry, size_t position)
+{
+    entry->sequence.store(position + 1, std::memory_order_release);
+}
+
+void Logger::frame(long index, bool detected, const std::string& turn, double detect_ms)
+{
+    int64_t now = nowUs();
+    if (!admit(LOG_INFO, now))
+        return;
+    size_t pos;
+    Entry* e = claim(pos);
+    if (e == nullptr)
+        return;
+
+    e->kind = KIND_FRAME;
+    e->level = LOG_INFO;
+    e->time_us = now;
+    e->frame = index;
+    e->detected = detected;
+    e->detect_ms = static_cast<float>(detect_ms);
+    size_t n = std::min(turn.size(), sizeof(e->text) - 1);
+    std::memcpy(e->text, turn.data(), n);
+    e->text[n] = '\0';
+    publish(e, pos);
+}
+
+void Logger::log(LogLevel level, const char* format, ...)
+{
+    int64_t now = nowUs();
+    if (!admit(level, now))
+        return;
+    size_t pos;
+    Entry* e = claim(pos);
+    if (e == nullptr)
+        return;
+
+    e->kind = KIND_TEXT;
+    e->level = level;
+    e->time_us = now;
+    va_list args;
+    va_start(args, format);
+    std::vsnprintf(e->text, sizeof(e->text), format, args);
+    va_end(args);
+    // Keep the message a single quoted value
+    for (char* c = e->text; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\n')
+            *c = *c == '"' ? '\'' : ' ';
+    }
+    publish(e, pos);
+}
+
+/**
+*@brief One line per entry: [FRAME] frame=N t_ms=T lane=0|1 turn="..." detect_ms=D
+*@brief or [LEVEL] t_ms=T msg="..."
+*/
+size_t Logger::format(const Entry& e, char* line, size_t size) const
+{
+    double t_ms = e.time_us / 1000.0;
+    int n;
+    if (e.kind == KIND_FRAME) {
+        n = std::snprintf(line, size, "[FRAME] frame=%ld t_ms=%.3f lane=%d turn=\"%s\" detect_ms=%.3f\n",
+                          e.frame, t_ms, e.detected ? 1 : 0, e.text, e.detect_ms);
+    } else {
+        n = std::snprintf(line, size, "[%s] t_ms=%.3f msg=\"%s\"\n", levelName(e.level), t_ms, e.text);
+    }
+    if (n < 0)
+        return 0;
+    if (static_cast<size_t>(n) >= size) {
+        // Keep the line terminated when it was truncated
+        line[size - 2] = '\n';
+        return size - 1;
+    }
+    return static_cast<size_t>(n);
+}
+
+/**
+*@brief Write every published entry, flush once per batch, sleep while the ring is empty
+*@brief The stop flag is read before draining, so entries published before stop() are written
+*/
+void Logger::writeLoop()
+{
+    char line[256];
+    size_t capacity = ring.size();
+
+    while (true) {
+        bool last = stopping.load(std::memory_order_acquire);
+        long batch = 0;
+        while (true) {
+            Entry& e = ring[dequeue_pos & mask];
+            if (e.sequence.load(std::memory_order_acquire) != dequeue_pos + 1)
+                break;
+            size_t len = format(e, line, sizeof(line));
+            std::fwrite(line, 1, len, out);
+            e.sequence.store(dequeue_pos + capacity, std::memory_order_release);
+            dequeue_pos++;
+            batch++;
+        }
+        if (batch > 0) {
+            std::fflush(out);
+            written_count.fetch_add(batch, std::memory_order_relaxed);
+        }
+        if (last)
+            break;
+        if (batch == 0)
+            std::this_thread::sleep_for(std::chrono::microseconds(IDLE_SLEEP_US));
+    }
+}
+
+const char* Logger::levelName(LogLevel level)
+{
+    switch (level) {
+    case LOG_DEBUG: return "DEBUG";
+    case LOG_INFO: return "INFO";
+    case LOG_WARN: return "WARN";
+    case LOG_ERROR: return "ERROR";
+    default: return "OFF";
+    }
+}
+
+bool Logger::parseLevel(const std::string& name, LogLevel& level)
+{
+    static const char* names[] = { "debug", "info", "warn", "error", "off" };
+    for (int i = 0; i <= LOG_OFF; i++) {
+        if (name == names[i]) {
+            level = static_cast<LogLevel>(i);
+            return true;
+        }
+    }
+    return false;
+}
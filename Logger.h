@@ -0,0 +1,103 @@
+/**
+*@file Logger.h
+*@brief Asynchronous structured logger: producers never wait for I/O.
+*@brief Entries are fixed-size slots of a bounded lock-free multi-producer ring; a background
+*@brief thread formats and writes them. A full ring drops the entry (and counts it) instead of
+*@brief blocking, and an optional rate limit caps the entries per second below the error level.
+*@brief Per-frame results are stored as fields and formatted by the writer into one line,
+*@brief [FRAME] key=value ..., which add/process_logs.py parses.
+*/
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum LogLevel { LOG_DEBUG = 0, LOG_INFO, LOG_WARN, LOG_ERROR, LOG_OFF };
+
+class Logger
+{
+public:
+	// capacity is rounded up to a power of two
+	explicit Logger(size_t capacity = 1024);
+	~Logger();
+
+	// Write to path ("" or "-" is stdout) on a background thread; false if the file cannot be opened
+	bool start(const std::string& path);
+
+	// Write everything still queued, then stop the writer and close the file
+	void stop();
+
+	// Entries below the level are discarded by the caller's thread
+	void setLevel(LogLevel level) { min_level.store(level, std::memory_order_relaxed); }
+	LogLevel level() const { return min_level.load(std::memory_order_relaxed); }
+	bool enabled(LogLevel level) const { return level >= this->level() && level < LOG_OFF; }
+
+	// At most per_second entries per second below LOG_ERROR, 0 is unlimited
+	void setRateLimit(int per_second) { rate_limit.store(per_second, std::memory_order_relaxed); }
+
+	// Per-frame result at LOG_INFO: frame index, whether a lane was found, turn and detection time
+	void frame(long index, bool detected, const std::string& turn, double detect_ms);
+
+	// printf-style message; formatted into the slot (truncated to the slot size), written later
+	void log(LogLevel level, const char* format, ...)
+#if defined(__GNUC__)
+		__attribute__((format(printf, 3, 4)))
+#endif
+		;
+
+	long written() const { return written_count.load(std::memory_order_relaxed); }
+	long dropped() const { return dropped_count.load(std::memory_order_relaxed); }
+	long suppressed() const { return suppressed_count.load(std::memory_order_relaxed); }
+
+	static const char* levelName(LogLevel level);
+
+	// debug, info, warn, error or off; false on an unknown name
+	static bool parseLevel(const std::string& name, LogLevel& level);
+
+private:
+	enum Kind { KIND_TEXT, KIND_FRAME };
+
+	struct Entry
+	{
+		std::atomic<size_t> sequence;   // Slot state of the ring (see claim / writeLoop)
+		Kind kind;
+		LogLevel level;
+		int64_t time_us;                // Since the logger was created
+		long frame;
+		bool detected;
+		float detect_ms;
+		char text[160];                 // Message, or the turn of a frame entry
+	};
+
+	std::vector<Entry> ring;
+	size_t mask;
+	alignas(64) std::atomic<size_t> enqueue_pos;
+	alignas(64) size_t dequeue_pos;             // Writer thread only
+	std::atomic<LogLevel> min_level;
+	std::atomic<int> rate_limit;
+	std::atomic<int64_t> rate_window;           // Second the count below belongs to
+	std::atomic<int> rate_count;
+	std::atomic<long> written_count;
+	std::atomic<long> dropped_count;
+	std::atomic<long> suppressed_count;
+	std::atomic<bool> stopping;
+	std::thread writer;
+	FILE* out;
+	bool owns_file;
+	std::chrono::steady_clock::time_point epoch;
+
+	bool admit(LogLevel level, int64_t now_us);
+	Entry* claim(size_t& position);
+	void publish(Entry* entry, size_t position);
+	int64_t nowUs() const;
+	void writeLoop();
+	size_t format(const Entry& e, char* line, size_t size) const;
+};
+
+#endif // LOGGER_H
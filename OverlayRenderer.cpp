@@ -0,0 +1,279 @@
+/**
+*@file OverlayRenderer.cpp
+*@brief Span rasterization and fixed-point blending of the lane overlay.
+*@brief A pixel is blended as (pixel * (256 - a) + color * a + 128) >> 8; the lane polygon uses
+*@brief a = 77 (0.3 of 256), the boundary lines and labels full opacity scaled by their coverage.
+*@brief The coverage of a span's end pixels is the covered share of the pixel along the row.
+*/
+#include <algorithm>
+#include <cmath>
+#include "OverlayRenderer.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define OVERLAY_RENDERER_SSE2 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define OVERLAY_RENDERER_NEON 1
+#endif
+
+namespace {
+
+// Same colors, sizes and positions as the OpenCV plotLane
+const cv::Scalar LANE_COLOR(0, 0, 255);
+const int LANE_ALPHA = 77;
+const cv::Scalar LINE_COLOR(0, 255, 255);
+const double LINE_WIDTH = 5.0;
+const cv::Scalar LABEL_COLOR(0, 255, 0);
+const int LABEL_FONT = cv::FONT_HERSHEY_COMPLEX_SMALL;
+const double LABEL_SCALE = 3.0;
+const int LABEL_THICKNESS = 1;
+const cv::Point LABEL_ORIGIN(50, 90);
+
+// The messages predictTurn produces
+const char* const TURN_LABELS[] = { "Turn left", "Turn right", "Straight" };
+
+// 16 BGR pixels, the block of the SIMD blend
+const int BLOCK_BYTES = 48;
+
+// Weights of one color and opacity, repeated over a block so every byte has its channel's term
+struct BlendWeights
+{
+    int inv;                        // Weight of the frame pixel, 256 - alpha
+    ushort term[BLOCK_BYTES];       // color * alpha + 128
+};
+
+void makeWeights(const cv::Scalar& color, int alpha, BlendWeights& w)
+{
+    w.inv = 256 - alpha;
+    for (int i = 0; i < BLOCK_BYTES; i++)
+        w.term[i] = static_cast<ushort>(cv::saturate_cast<uchar>(color[i % 3]) * alpha + 128);
+}
+
+// Blend pixels full BGR pixels starting at p
+void blendRun(uchar* p, int pixels, const BlendWeights& w)
+{
+    int n = pixels * 3;
+    int i = 0;
+
+#if defined(OVERLAY_RENDERER_SSE2)
+    __m128i inv = _mm_set1_epi16(static_cast<short>(w.inv));
+    __m128i zero = _mm_setzero_si128();
+    for (; i + BLOCK_BYTES <= n; i += BLOCK_BYTES) {
+        for (int v = 0; v < BLOCK_BYTES; v += 16) {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i + v));
+            __m128i lo = _mm_unpacklo_epi8(x, zero);
+            __m128i hi = _mm_unpackhi_epi8(x, zero);
+            lo = _mm_add_epi16(_mm_mullo_epi16(lo, inv), _mm_loadu_si128(reinterpret_cast<const __m128i*>(w.term + v)));
+            hi = _mm_add_epi16(_mm_mullo_epi16(hi, inv), _mm_loadu_si128(reinterpret_cast<const __m128i*>(w.term + v + 8)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(p + i + v),
+                             _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)));
+        }
+    }
+#elif defined(OVERLAY_RENDERER_NEON)
+    // alpha >= 1, so the frame weight fits in 8 bits
+    uint8x8_t inv = vdup_n_u8(static_cast<uint8_t>(w.inv));
+    for (; i + BLOCK_BYTES <= n; i += BLOCK_BYTES) {
+        for (int v = 0; v < BLOCK_BYTES; v += 16) {
+            uint8x16_t x = vld1q_u8(p + i + v);
+            uint16x8_t lo = vmlal_u8(vld1q_u16(w.term + v), vget_low_u8(x), inv);
+            uint16x8_t hi = vmlal_u8(vld1q_u16(w.term + v + 8), vget_high_u8(x), inv);
+            vst1q_u8(p + i + v, vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8)));
+        }
+    }
+#endif
+
+    for (; i < n; i++)
+        p[i] = static_cast<uchar>((p[i] * w.inv + w.term[i % 3]) >> 8);
+}
+
+// Blend one BGR pixel with opacity a / 256
+void blendPixel(uchar* p, const cv::Scalar& color, int a)
+{
+    for (int k = 0; k < 3; k++)
+        p[k] = static_cast<uchar>((p[k] * (256 - a) + cv::saturate_cast<uchar>(color[k]) * a + 128) >> 8);
+}
+
+} // namespace
+
+OverlayRenderer::OverlayRenderer()
+{
+    spans.reserve(2048);
+    for (const char* label : TURN_LABELS)
+        addSprite(label);
+}
+
+/**
+*@brief Render text once with OpenCV's anti-aliased putText into a coverage mask
+*/
+void OverlayRenderer::addSprite(const std::string& text)
+{
+    int baseline = 0;
+    cv::Size size = cv::getTextSize(text, LABEL_FONT, LABEL_SCALE, LABEL_THICKNESS, &baseline);
+    int pad = LABEL_THICKNESS + 2;
+
+    Sprite sprite;
+    sprite.text = text;
+    sprite.coverage = cv::Mat::zeros(size.height + baseline + 2 * pad, size.width + 2 * pad, CV_8UC1);
+    cv::putText(sprite.coverage, text, cv::Point(pad, pad + size.height), LABEL_FONT, LABEL_SCALE,
+                cv::Scalar(255), LABEL_THICKNESS, cv::LINE_AA);
+    sprite.offset = cv::Point(-pad, -pad - size.height);
+    sprites.push_back(sprite);
+}
+
+void OverlayRenderer::render(cv::Mat& frame, const std::vector<cv::Point>& lane, const std::string& turn)
+{
+    CV_Assert(frame.type() == CV_8UC3 && lane.size() >= 4);
+
+    // Same vertex order as the OpenCV polygon: left bottom, right bottom, right top, left top
+    cv::Point2d poly[4] = { cv::Point2d(lane[2].x, lane[2].y), cv::Point2d(lane[0].x, lane[0].y),
+                            cv::Point2d(lane[1].x, lane[1].y), cv::Point2d(lane[3].x, lane[3].y) };
+    fillConvex(frame, poly, 4, LANE_COLOR, LANE_ALPHA);
+
+    drawLine(frame, poly[1], poly[2], LINE_WIDTH, LINE_COLOR);
+    drawLine(frame, poly[0], poly[3], LINE_WIDTH, LINE_COLOR);
+
+    // Messages without a sprite are drawn directly
+    if (!turn.empty() && !drawLabel(frame, turn, LABEL_ORIGIN))
+        cv::putText(frame, turn, LABEL_ORIGIN, LABEL_FONT, LABEL_SCALE, LABEL_COLOR, LABEL_THICKNESS, cv::LINE_AA);
+}
+
+/**
+*@brief The rows whose center lies inside the polygon, each with the polygon's extent on it
+*/
+void OverlayRenderer::buildSpans(const cv::Point2d* pts, int count, int rows)
+{
+    spans.clear();
+    double ymin = pts[0].y;
+    double ymax = pts[0].y;
+    for (int i = 1; i < count; i++) {
+        ymin = std::min(ymin, pts[i].y);
+        ymax = std::max(ymax, pts[i].y);
+    }
+    int y0 = static_cast<int>(std::ceil(std::max(ymin, 0.0)));
+    int y1 = static_cast<int>(std::floor(std::min(ymax, rows - 1.0)));
+
+    for (int y = y0; y <= y1; y++) {
+        double lo = HUGE_VAL;
+        double hi = -HUGE_VAL;
+        for (int i = 0; i < count; i++) {
+            const cv::Point2d& a = pts[i];
+            const cv::Point2d& b = pts[(i + 1) % count];
+            if (a.y == b.y) {
+                if (a.y == y) {
+                    lo = std::min(lo, std::min(a.x, b.x));
+                    hi = std::max(hi, std::max(a.x, b.x));
+                }
+                continue;
+            }
+            if (y < std::min(a.y, b.y) || y > std::max(a.y, b.y))
+                continue;
+            double x = a.x + (y - a.y) * (b.x - a.x) / (b.y - a.y);
+            lo = std::min(lo, x);
+            hi = std::max(hi, x);
+        }
+        if (lo <= hi) {
+            Span span = { y, lo, hi };
+            spans.push_back(span);
+        }
+    }
+}
+
+/**
+*@brief Pixels completely inside a span are blended with SIMD, the pixels at its ends by coverage
+*@param frame is the 8-bit BGR image drawn into
+*@param pts are the vertices of the convex polygon, in order
+*@param alpha is the opacity in 1/256, 256 paints the color
+*/
+void OverlayRenderer::fillConvex(cv::Mat& frame, const cv::Point2d* pts, int count, const cv::Scalar& color, int alpha)
+{
+    if (count < 3 || alpha <= 0)
+        return;
+    alpha = std::min(alpha, 256);
+    buildSpans(pts, count, frame.rows);
+
+    BlendWeights weights;
+    makeWeights(color, alpha, weights);
+    int width = frame.cols;
+
+    for (const Span& span : spans) {
+        uchar* row = frame.ptr<uchar>(span.y);
+        // Far outside the frame only the clipped part matters (and stays in int range)
+        double l = std::max(span.x0, -1.0);
+        double h = std::min(span.x1, static_cast<double>(width));
+
+        // Pixel x covers [x - 0.5, x + 0.5)
+        int first = cvFloor(l + 0.5);
+        int last = cvFloor(h + 0.5);
+        int full0 = cvCeil(l + 0.5);
+        int full1 = cvFloor(h - 0.5);
+
+        auto partial = [&](int x) {
+            if (x < 0 || x >= width)
+                return;
+            double c = std::min(x + 0.5, h) - std::max(x - 0.5, l);
+            int a = std::min(cvRound(alpha * c), 256);
+            if (a > 0)
+                blendPixel(row + 3 * x, color, a);
+        };
+
+        if (full0 > full1) {
+            for (int x = first; x <= last; x++)
+                partial(x);
+            continue;
+        }
+        for (int x = first; x < full0; x++)
+            partial(x);
+        int a0 = std::max(full0, 0);
+        int a1 = std::min(full1, width - 1);
+        if (a0 <= a1)
+            blendRun(row + 3 * a0, a1 - a0 + 1, weights);
+        for (int x = full1 + 1; x <= last; x++)
+            partial(x);
+    }
+}
+
+void OverlayRenderer::drawLine(cv::Mat& frame, cv::Point2d p0, cv::Point2d p1, double width, const cv::Scalar& color)
+{
+    double dx = p1.x - p0.x;
+    double dy = p1.y - p0.y;
+    double length = std::sqrt(dx * dx + dy * dy);
+    if (!(length > 0.0) || !std::isfinite(length))
+        return;
+
+    // Offset of the long sides: half the width along the normal
+    double nx = -dy / length * width * 0.5;
+    double ny = dx / length * width * 0.5;
+    cv::Point2d quad[4] = { cv::Point2d(p0.x + nx, p0.y + ny), cv::Point2d(p1.x + nx, p1.y + ny),
+                            cv::Point2d(p1.x - nx, p1.y - ny), cv::Point2d(p0.x - nx, p0.y - ny) };
+    fillConvex(frame, quad, 4, color, 256);
+}
+
+bool OverlayRenderer::drawLabel(cv::Mat& frame, const std::string& text, cv::Point origin)
+{
+    const Sprite* sprite = nullptr;
+    for (const Sprite& s : sprites) {
+        if (s.text == text) {
+            sprite = &s;
+            break;
+        }
+    }
+    if (sprite == nullptr)
+        return false;
+
+    cv::Point tl = origin + sprite->offset;
+    int y0 = std::max(0, -tl.y);
+    int y1 = std::min(sprite->coverage.rows, frame.rows - tl.y);
+    int x0 = std::max(0, -tl.x);
+    int x1 = std::min(sprite->coverage.cols, frame.cols - tl.x);
+    for (int y = y0; y < y1; y++) {
+        const uchar* cov = sprite->coverage.ptr<uchar>(y);
+        uchar* row = frame.ptr<uchar>(tl.y + y) + 3 * tl.x;
+        for (int x = x0; x < x1; x++) {
+            // 0..255 coverage to 0..256 opacity
+            if (cov[x])
+                blendPixel(row + 3 * x, LABEL_COLOR, cov[x] + (cov[x] >> 7));
+        }
+    }
+    return true;
+}
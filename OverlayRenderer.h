@@ -0,0 +1,60 @@
+/**
+*@file OverlayRenderer.h
+*@brief Lane overlay drawn in place, touching only the pixels it covers.
+*@brief plotLane with OpenCV copies the frame, fills the lane polygon into the copy and blends
+*@brief the whole frame back at 30%. Here the polygon (and the two boundary lines, which are thin
+*@brief quads) are turned into one span per row, anti-aliased across the row at both ends, and
+*@brief only those spans are blended into the frame with 8-bit fixed point weights (SSE2/NEON).
+*@brief The turn labels are rendered once into coverage sprites and blended the same way.
+*/
+#ifndef OVERLAY_RENDERER_H
+#define OVERLAY_RENDERER_H
+
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+class OverlayRenderer
+{
+public:
+	OverlayRenderer();
+
+	// Same picture as the OpenCV plotLane: lane polygon at 30% red, yellow boundary lines 5 px
+	// wide and the green turn label. lane holds right bottom/top, left bottom/top as regression
+	// outputs them; frame is 8-bit BGR.
+	void render(cv::Mat& frame, const std::vector<cv::Point>& lane, const std::string& turn);
+
+	// Blend a convex polygon with opacity alpha / 256 (1..256)
+	void fillConvex(cv::Mat& frame, const cv::Point2d* pts, int count, const cv::Scalar& color, int alpha);
+
+	// Blend a line of the given width as a quad without caps
+	void drawLine(cv::Mat& frame, cv::Point2d p0, cv::Point2d p1, double width, const cv::Scalar& color);
+
+	// Blend the sprite of text with its baseline starting at origin; false if the text has none
+	bool drawLabel(cv::Mat& frame, const std::string& text, cv::Point origin);
+
+private:
+	// Horizontal extent [x0, x1] of the polygon through the center of row y
+	struct Span
+	{
+		int y;
+		double x0;
+		double x1;
+	};
+
+	// Anti-aliased coverage (0..255) of a pre-rendered label, placed at origin + offset
+	struct Sprite
+	{
+		std::string text;
+		cv::Mat coverage;
+		cv::Point offset;
+	};
+
+	std::vector<Span> spans;        // Spans of the polygon being filled
+	std::vector<Sprite> sprites;    // One per turn message
+
+	void addSprite(const std::string& text);
+	void buildSpans(const cv::Point2d* pts, int count, int rows);
+};
+
+#endif // OVERLAY_RENDERER_H
@@ -0,0 +1,154 @@
+/**
+*@file PerfStats.cpp
+*@brief Latency histograms and JSON/CSV dumps of the per-stage timings.
+*/
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include "PerfStats.h"
+
+void LatencyHistogram::reset()
+{
+    for (int i = 0; i < BUCKETS; i++)
+        buckets[i].store(0, std::memory_order_relaxed);
+    samples.store(0, std::memory_order_relaxed);
+    total_ns.store(0, std::memory_order_relaxed);
+    max_ns.store(0, std::memory_order_relaxed);
+}
+
+int LatencyHistogram::bucketOf(uint64_t ns)
+{
+    if (ns < static_cast<uint64_t>(LINEAR_BUCKETS))
+        return static_cast<int>(ns);
+
+    int msb = 63 - __builtin_clzll(ns);
+    int shift = msb - SUB_BITS;
+    if (shift > MAX_SHIFT)
+        return BUCKETS - 1;
+    int sub = static_cast<int>(ns >> shift) - (1 << SUB_BITS);
+    return LINEAR_BUCKETS + (shift - 1) * (1 << SUB_BITS) + sub;
+}
+
+uint64_t LatencyHistogram::bucketUpper(int index)
+{
+    if (index < LINEAR_BUCKETS)
+        return static_cast<uint64_t>(index);
+
+    int k = index - LINEAR_BUCKETS;
+    int shift = k / (1 << SUB_BITS) + 1;
+    uint64_t sub = static_cast<uint64_t>(k % (1 << SUB_BITS) + (1 << SUB_BITS));
+    return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t ns)
+{
+    buckets[bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+    samples.fetch_add(1, std::memory_order_relaxed);
+    total_ns.fetch_add(ns, std::memory_order_relaxed);
+
+    uint64_t prev = max_ns.load(std::memory_order_relaxed);
+    while (ns > prev && !max_ns.compare_exchange_weak(prev, ns, std::memory_order_relaxed)) {
+    }
+}
+
+double LatencyHistogram::meanMs() const
+{
+    uint64_t n = count();
+    return n > 0 ? totalMs() / n : 0.0;
+}
+
+double LatencyHistogram::percentileMs(double p) const
+{
+    uint64_t n = count();
+    if (n == 0)
+        return 0.0;
+
+    uint64_t target = static_cast<uint64_t>(std::ceil(std::min(std::max(p, 0.0), 100.0) / 100.0 * n));
+    target = std::max<uint64_t>(target, 1);
+
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen >= target && i == BUCKETS - 1)
+            return maxMs();
+        if (seen >= target)
+            return std::min(bucketUpper(i), max_ns.load(std::memory_order_relaxed)) / 1e6;
+    }
+    return maxMs();
+}
+
+double PerfStats::averagePerFrameMs(PerfStage s) const
+{
+    int n = frames();
+    return n > 0 ? histograms[s].totalMs() / n : 0.0;
+}
+
+void PerfStats::reset()
+{
+    for (int i = 0; i < STAGE_COUNT; i++)
+        histograms[i].reset();
+    frame_count.store(0, std::memory_order_relaxed);
+}
+
+const char* PerfStats::stageName(PerfStage s)
+{
+    static const char* names[STAGE_COUNT] = {
+        "denoise", "edge", "mask", "hough", "separation", "regression", "predict", "plot"
+    };
+    return s < STAGE_COUNT ? names[s] : "unknown";
+}
+
+/**
+*@brief Dump every stage as a JSON object: count, per-frame average, mean, p50/p95/p99 and max in ms
+*@param path is the output file
+*@param wall_ms is the end-to-end time measured by the caller
+*@return false if the file could not be written
+*/
+bool PerfStats::writeJson(const std::string& path, double wall_ms) const
+{
+    std::ofstream out(path.c_str());
+    if (!out)
+        return false;
+
+    int n = frames();
+    out << "{\n  \"frames\": " << n << ",\n  \"wall_ms\": " << wall_ms
+        << ",\n  \"avg_frame_ms\": " << (n > 0 ? wall_ms / n : 0.0) << ",\n  \"stages\": [\n";
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        PerfStage s = static_cast<PerfStage>(i);
+        const LatencyHistogram& h = histograms[i];
+        out << "    {\"name\": \"" << stageName(s) << "\", \"count\": " << h.count()
+            << ", \"total_ms\": " << h.totalMs() << ", \"avg_per_frame_ms\": " << averagePerFrameMs(s)
+            << ", \"mean_ms\": " << h.meanMs() << ", \"p50_ms\": " << h.percentileMs(50)
+            << ", \"p95_ms\": " << h.percentileMs(95) << ", \"p99_ms\": " << h.percentileMs(99)
+            << ", \"max_ms\": " << h.maxMs() << "}" << (i + 1 < STAGE_COUNT ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    return static_cast<bool>(out);
+}
+
+/**
+*@brief Dump one CSV row per stage plus a final "wall" row with the caller's end-to-end time
+*@param path is the output file
+*@param wall_ms is the end-to-end time measured by the caller
+*@return false if the file could not be written
+*/
+bool PerfStats::writeCsv(const std::string& path, double wall_ms) const
+{
+    std::ofstream out(path.c_str());
+    if (!out)
+        return false;
+
+    int n = frames();
+    out << "stage,count,frames,total_ms,avg_per_frame_ms,mean_ms,p50_ms,p95_ms,p99_ms,max_ms\n";
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        PerfStage s = static_cast<PerfStage>(i);
+        const LatencyHistogram& h = histograms[i];
+        out << stageName(s) << "," << h.count() << "," << n << "," << h.totalMs() << ","
+            << averagePerFrameMs(s) << "," << h.meanMs() << "," << h.percentileMs(50) << ","
+            << h.percentileMs(95) << "," << h.percentileMs(99) << "," << h.maxMs() << "\n";
+    }
+    double per_frame = n > 0 ? wall_ms / n : 0.0;
+    out << "wall," << n << "," << n << "," << wall_ms << "," << per_frame << "," << per_frame
+        << ",,,,\n";
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,131 @@
+/**
+*@file PerfStats.h
+*@brief Per-instance, lock-free stage timing with latency histograms.
+*@brief Each LaneDetector owns one PerfStats; stages record through ScopedStageTimer, which
+*@brief also emits a trace event per stage while the Tracer is on.
+*@brief Building with -DLANE_NO_PERF removes the instrumentation entirely.
+*/
+#ifndef PERF_STATS_H
+#define PERF_STATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include "Tracer.h"
+
+// Stages of LaneDetector in pipeline order
+enum PerfStage
+{
+	STAGE_DENOISE = 0,
+	STAGE_EDGE,
+	STAGE_MASK,
+	STAGE_HOUGH,
+	STAGE_SEPARATION,
+	STAGE_REGRESSION,
+	STAGE_PREDICT,
+	STAGE_PLOT,
+	STAGE_COUNT
+};
+
+// Log-linear latency histogram in nanoseconds (about 3% resolution up to ~18 minutes)
+class LatencyHistogram
+{
+public:
+	static const int SUB_BITS = 5;
+	static const int LINEAR_BUCKETS = 2 << SUB_BITS;            // Exact buckets for 0..63 ns
+	static const int MAX_SHIFT = 35;
+	static const int BUCKETS = LINEAR_BUCKETS + MAX_SHIFT * (1 << SUB_BITS);
+
+	LatencyHistogram() { reset(); }
+
+	void record(uint64_t ns);
+	void reset();
+
+	uint64_t count() const { return samples.load(std::memory_order_relaxed); }
+	double totalMs() const { return total_ns.load(std::memory_order_relaxed) / 1e6; }
+	double meanMs() const;
+	double maxMs() const { return max_ns.load(std::memory_order_relaxed) / 1e6; }
+	// Upper bound of the bucket holding the p-th percentile (p in [0, 100])
+	double percentileMs(double p) const;
+
+private:
+	std::atomic<uint32_t> buckets[BUCKETS];
+	std::atomic<uint64_t> samples;
+	std::atomic<uint64_t> total_ns;
+	std::atomic<uint64_t> max_ns;
+
+	static int bucketOf(uint64_t ns);
+	static uint64_t bucketUpper(int index);
+};
+
+class PerfStats
+{
+public:
+	PerfStats() : frame_count(0) {}
+
+	void record(PerfStage stage, uint64_t ns)
+	{
+#ifndef LANE_NO_PERF
+		histograms[stage].record(ns);
+#else
+		(void)stage;
+		(void)ns;
+#endif
+	}
+
+	// Count a processed frame, whatever stages it went through
+	void countFrame()
+	{
+#ifndef LANE_NO_PERF
+		frame_count.fetch_add(1, std::memory_order_relaxed);
+#endif
+	}
+
+	int frames() const { return static_cast<int>(frame_count.load(std::memory_order_relaxed)); }
+	const LatencyHistogram& stage(PerfStage s) const { return histograms[s]; }
+
+	// Stage time averaged over all processed frames (frames that skip a stage count as 0)
+	double averagePerFrameMs(PerfStage s) const;
+
+	void reset();
+
+	// Machine-readable dumps; wall_ms is the caller's end-to-end time for the same frames
+	bool writeJson(const std::string& path, double wall_ms) const;
+	bool writeCsv(const std::string& path, double wall_ms) const;
+
+	static const char* stageName(PerfStage s);
+
+private:
+	LatencyHistogram histograms[STAGE_COUNT];
+	std::atomic<uint64_t> frame_count;
+};
+
+// Records the lifetime of the object into one stage of a PerfStats
+class ScopedStageTimer
+{
+public:
+#ifndef LANE_NO_PERF
+	ScopedStageTimer(PerfStats& stats, PerfStage stage)
+		: stats(stats), stage(stage), start(std::chrono::steady_clock::now())
+	{
+	}
+
+	~ScopedStageTimer()
+	{
+		std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+		stats.record(stage, std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+		if (Tracer::enabled())
+			Tracer::record(PerfStats::stageName(stage), start, end);
+	}
+
+private:
+	PerfStats& stats;
+	PerfStage stage;
+	std::chrono::steady_clock::time_point start;
+#else
+	ScopedStageTimer(PerfStats&, PerfStage) {}
+#endif
+};
+
+#endif // PERF_STATS_H
@@ -0,0 +1,268 @@
+/**
+*@file RealtimeRunner.cpp
+*@brief Latest-frame grabber and the deadline-driven live detection loop.
+*/
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include "RealtimeRunner.h"
+#include "Tracer.h"
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// Weight of the newest frame in the smoothed latency
+const double EWMA_ALPHA = 0.2;
+
+// Degrade when the smoothed latency exceeds this share of the budget, recover below the other
+const double DEGRADE_SHARE = 0.9;
+const double RECOVER_SHARE = 0.5;
+
+// Frames to wait after a level change before degrading further / recovering
+const int DEGRADE_HOLD = 5;
+const int RECOVER_HOLD = 30;
+
+double msBetween(Clock::time_point t0, Clock::time_point t1)
+{
+    return std::chrono::duration<double, std::milli>(t1 - t0).count();
+}
+
+} // namespace
+
+LatestFrameGrabber::LatestFrameGrabber()
+    : fresh(false), ended(true), stopping(false), captured_frames(0), dropped_frames(0)
+{
+}
+
+LatestFrameGrabber::~LatestFrameGrabber()
+{
+    stop();
+}
+
+void LatestFrameGrabber::start(cv::VideoCapture& cap, double pace_fps)
+{
+    stop();
+    fresh = false;
+    ended = false;
+    stopping = false;
+    captured_frames = 0;
+    dropped_frames = 0;
+    // 摄像头只保留最新一帧，避免驱动缓冲造成额外延迟
+    cap.set(cv::CAP_PROP_BUFFERSIZE, 1);
+    reader = std::thread(&LatestFrameGrabber::readLoop, this, std::ref(cap), pace_fps);
+}
+
+void LatestFrameGrabber::stop()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    if (reader.joinable())
+        reader.join();
+    std::lock_guard<std::mutex> guard(lock);
+    ended = true;
+}
+
+/**
+*@brief Read into a private buffer, then swap it with the published one; a frame still
+*@brief unread at that point is dropped. A paced replay waits for each frame's due time.
+*/
+void LatestFrameGrabber::readLoop(cv::VideoCapture& cap, double pace_fps)
+{
+    cv::Mat buffer;
+    Clock::time_point start = Clock::now();
+    long sequence = 0;
+
+    Tracer::setThreadName("capture");
+    while (true) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (stopping)
+                break;
+        }
+        Tracer::setFrame(sequence);
+        bool ok;
+        {
+            TraceScope trace("decode");
+            ok = cap.read(buffer);
+        }
+        if (!ok)
+            break;
+        if (pace_fps > 0) {
+            Clock::time_point due = start + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(sequence / pace_fps));
+            std::this_thread::sleep_until(due);
+        }
+
+        std::lock_guard<std::mutex> guard(lock);
+        cv::swap(buffer, latest);
+        latest_stamp.sequence = sequence++;
+        latest_stamp.captured = Clock::now();
+        if (fresh)
+            dropped_frames++;
+        fresh = true;
+        captured_frames++;
+        ready.notify_one();
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+    ended = true;
+    ready.notify_one();
+}
+
+bool LatestFrameGrabber::take(cv::Mat& frame, FrameStamp& stamp)
+{
+    std::unique_lock<std::mutex> guard(lock);
+    ready.wait(guard, [this] { return fresh || ended; });
+    if (!fresh)
+        return false;
+    cv::swap(frame, latest);
+    stamp = latest_stamp;
+    fresh = false;
+    return true;
+}
+
+RealtimeRunner::RealtimeRunner(LaneDetector& detector, const DetectOptions& options, double budget_ms)
+    : detector(detector), options(options), budget_ms(budget_ms), level(LEVEL_FULL), latency_ewma_ms(0.0),
+      frames_since_change(0), base_roi(false), base_scale(1), processed(0), deadline_misses(0),
+      captured(0), dropped(0), level_changes(0), wall_ms(0.0)
+{
+    std::fill(level_frames, level_frames + LEVEL_COUNT, 0L);
+}
+
+const char* RealtimeRunner::levelName(Level level)
+{
+    switch (level) {
+    case LEVEL_FULL: return "full";
+    case LEVEL_NO_PLOT: return "no-plot";
+    case LEVEL_ROI: return "roi";
+    case LEVEL_COARSE: return "scale-2";
+    case LEVEL_COARSEST: return "scale-4";
+    default: return "?";
+    }
+}
+
+/**
+*@brief Apply the detector settings of a level; plotting is decided per frame in run()
+*/
+void RealtimeRunner::setLevel(Level next)
+{
+    if (next == level)
+        return;
+    level = next;
+    level_changes++;
+    frames_since_change = 0;
+
+    detector.setRoiMode(base_roi || level >= LEVEL_ROI);
+    int scale = base_scale;
+    if (level >= LEVEL_COARSEST)
+        scale = std::max(scale, 4);
+    else if (level >= LEVEL_COARSE)
+        scale = std::max(scale, 2);
+    if (scale != detector.scale())
+        detector.setScale(scale);
+}
+
+/**
+*@brief One level down as soon as the smoothed latency nears the budget, one level up only
+*@brief after it has stayed well below for a while, so the level does not oscillate
+*/
+void RealtimeRunner::adapt(double latency_ms)
+{
+    latency_ewma_ms = processed == 0 ? latency_ms : latency_ewma_ms + EWMA_ALPHA * (latency_ms - latency_ewma_ms);
+    frames_since_change++;
+
+    if (latency_ewma_ms > budget_ms * DEGRADE_SHARE && level + 1 < LEVEL_COUNT && frames_since_change >= DEGRADE_HOLD)
+        setLevel(static_cast<Level>(level + 1));
+    else if (latency_ewma_ms < budget_ms * RECOVER_SHARE && level > LEVEL_FULL && frames_since_change >= RECOVER_HOLD)
+        setLevel(static_cast<Level>(level - 1));
+}
+
+int RealtimeRunner::run(cv::VideoCapture& cap, double pace_fps, int max_frames,
+                        cv::VideoWriter& color_writer, cv::VideoWriter& bw_writer, int& flag_plot)
+{
+    cv::Mat frame;
+    cv::Mat edge_frame;
+    cv::Mat edge_bgr;
+    std::string turn;
+    LaneRecord record;
+    FrameStamp stamp;
+    LatestFrameGrabber grabber;
+
+    base_roi = detector.roiMode();
+    base_scale = detector.scale();
+    level = LEVEL_FULL;
+    Clock::time_point start = Clock::now();
+    grabber.start(cap, pace_fps);
+
+    while ((max_frames <= 0 || processed < max_frames) && grabber.take(frame, stamp)) {
+        DetectOptions frame_options = options;
+        if (level >= LEVEL_NO_PLOT) {
+            frame_options.plot = false;
+            frame_options.edge_image = false;
+        }
+        level_frames[level]++;
+
+        Tracer::setFrame(stamp.sequence);
+        Clock::time_point t0 = Clock::now();
+        {
+            TraceScope trace("detect");
+            flag_plot = detectFrame(detector, frame, frame_options, edge_frame, edge_bgr, turn);
+        }
+        Clock::time_point decided = Clock::now();
+
+        double latency_ms = msBetween(stamp.captured, decided);
+        latency.record(static_cast<uint64_t>(latency_ms * 1e6));
+        detect_latency.record(static_cast<uint64_t>(msBetween(t0, decided) * 1e6));
+        if (latency_ms > budget_ms)
+            deadline_misses++;
+
+        // 输出在决策之后进行，不计入决策延迟；降级时不生成边缘图，也不写边缘视频
+        if (bw_writer.isOpened() && frame_options.edge_image) {
+            TraceScope trace("encode edge");
+            bw_writer.write(edge_bgr);
+        }
+        if (color_writer.isOpened()) {
+            TraceScope trace("encode color");
+            color_writer.write(frame);
+        }
+        if (records != nullptr) {
+            makeLaneRecord(detector, stamp.sequence, record_fps, flag_plot == 0, turn, record);
+            records->write(record);
+        }
+
+        adapt(latency_ms);
+        processed++;
+    }
+
+    grabber.stop();
+    wall_ms = msBetween(start, Clock::now());
+    captured = grabber.captured();
+    dropped = grabber.dropped();
+    setLevel(LEVEL_FULL);
+    return static_cast<int>(processed);
+}
+
+void RealtimeRunner::printReport() const
+{
+    std::cout << "\n实时模式统计 (每帧预算: " << budget_ms << " ms)" << std::endl;
+    std::cout << "├── 采集帧数: " << captured << ", 处理帧数: " << processed
+              << ", 丢弃帧数: " << dropped << " (" << (captured > 0 ? 100.0 * dropped / captured : 0.0) << "%)" << std::endl;
+    std::cout << "├── 处理帧率: " << (wall_ms > 0 ? processed * 1000.0 / wall_ms : 0.0) << " FPS" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "├── 采集到决策延迟(ms): 平均 " << latency.meanMs() << ", p50 " << latency.percentileMs(50)
+              << ", p95 " << latency.percentileMs(95) << ", p99 " << latency.percentileMs(99)
+              << ", 最大 " << latency.maxMs() << std::endl;
+    std::cout << "├── 检测耗时(ms): 平均 " << detect_latency.meanMs() << ", p50 " << detect_latency.percentileMs(50)
+              << ", p95 " << detect_latency.percentileMs(95) << ", p99 " << detect_latency.percentileMs(99)
+              << ", 最大 " << detect_latency.maxMs() << std::endl;
+    std::cout.unsetf(std::ios::fixed);
+    std::cout << "├── 超出预算: " << deadline_misses << " 帧" << std::endl;
+    std::cout << "└── 降级: " << level_changes << " 次切换, 各级帧数";
+    for (int i = 0; i < LEVEL_COUNT; i++)
+        std::cout << " " << levelName(static_cast<Level>(i)) << "=" << level_frames[i];
+    std::cout << std::endl;
+}
@@ -0,0 +1,119 @@
+/**
+*@file RealtimeRunner.h
+*@brief Low-latency live mode: always detect on the newest frame, never queue behind the source.
+*@brief A grabber thread reads the camera (or replays a file at its frame rate as a stand-in
+*@brief for a camera) and keeps only the latest frame; frames the detector did not get to in
+*@brief time are dropped. A per-frame deadline drives graceful degradation: when detection
+*@brief runs over budget the runner stops plotting, then crops to the ROI, then detects on a
+*@brief coarser scale, and steps back once there is headroom again.
+*/
+#ifndef REALTIME_RUNNER_H
+#define REALTIME_RUNNER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <opencv2/opencv.hpp>
+#include "FramePipeline.h"
+#include "PerfStats.h"
+
+// Sequence number and capture time of a grabbed frame
+struct FrameStamp
+{
+	long sequence = -1;                               // Index of the frame in the source
+	std::chrono::steady_clock::time_point captured;   // When the frame became available
+};
+
+// Background reader that holds only the most recent frame
+class LatestFrameGrabber
+{
+public:
+	LatestFrameGrabber();
+	~LatestFrameGrabber();
+
+	// Start reading cap on a background thread. pace_fps > 0 releases the frames of a file at
+	// that rate, as a camera would; 0 reads as fast as the source delivers (live devices).
+	void start(cv::VideoCapture& cap, double pace_fps);
+	void stop();
+
+	// Wait for a frame newer than the last one taken and swap it into frame (the previous
+	// buffer of frame is recycled); false once the source has ended
+	bool take(cv::Mat& frame, FrameStamp& stamp);
+
+	long captured() const { return captured_frames; }
+	long dropped() const { return dropped_frames; }
+
+private:
+	std::thread reader;
+	std::mutex lock;
+	std::condition_variable ready;
+	cv::Mat latest;             // Newest frame not yet taken
+	FrameStamp latest_stamp;    //
+	bool fresh;                 // latest holds a frame that was not taken yet
+	bool ended;                 // Source ended or stop() was called
+	bool stopping;
+	long captured_frames;
+	long dropped_frames;        // Frames overwritten before they were taken
+
+	void readLoop(cv::VideoCapture& cap, double pace_fps);
+};
+
+class RealtimeRunner
+{
+public:
+	// Degradation levels, each adding to the previous one
+	enum Level
+	{
+		LEVEL_FULL = 0,         // Every selected output
+		LEVEL_NO_PLOT,          // No lane plotting and no edge image
+		LEVEL_ROI,              // Process the ROI bounding box only
+		LEVEL_COARSE,           // Coarse-to-fine detection at 1/2 scale
+		LEVEL_COARSEST,         // Coarse-to-fine detection at 1/4 scale
+		LEVEL_COUNT
+	};
+
+	// budget_ms is the deadline from capture to turn decision of each frame
+	RealtimeRunner(LaneDetector& detector, const DetectOptions& options, double budget_ms);
+
+	// Write one LaneRecord per processed frame, stamped with its source frame index
+	void setRecordWriter(RecordWriter* writer, double fps) { records = writer; record_fps = fps; }
+
+	// Detect on the newest frames of cap until it ends or max_frames frames were processed
+	// (0: no limit); pace_fps > 0 replays a file at that rate. Returns the processed frames.
+	int run(cv::VideoCapture& cap, double pace_fps, int max_frames,
+	        cv::VideoWriter& color_writer, cv::VideoWriter& bw_writer, int& flag_plot);
+
+	// Latency percentiles, drops, deadline misses and time spent at each level
+	void printReport() const;
+
+	static const char* levelName(Level level);
+
+private:
+	LaneDetector& detector;
+	DetectOptions options;
+	double budget_ms;
+	RecordWriter* records = nullptr;
+	double record_fps = 0.0;
+
+	Level level;
+	double latency_ewma_ms;     // Smoothed capture-to-decision latency that drives the level changes
+	int frames_since_change;
+	bool base_roi;              // Detector settings restored at LEVEL_FULL / LEVEL_NO_PLOT
+	int base_scale;
+
+	LatencyHistogram latency;           // Capture to turn decision
+	LatencyHistogram detect_latency;    // detectFrame only
+	long processed;
+	long deadline_misses;
+	long captured;
+	long dropped;
+	long level_frames[LEVEL_COUNT];
+	long level_changes;
+	double wall_ms;
+
+	void setLevel(Level next);
+	void adapt(double latency_ms);
+};
+
+#endif // REALTIME_RUNNER_H
@@ -0,0 +1,159 @@
+/**
+*@file ShmRing.cpp
+*@brief shm_open / mmap setup of the shared-memory ring.
+*@brief The counters must be address-free to work across processes, which holds for lock-free
+*@brief std::atomic on the targets (aarch64 and x86-64 Linux); create() refuses otherwise.
+*/
+#include <cstring>
+#include <new>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "ShmRing.h"
+
+namespace {
+
+const char RING_MAGIC[8] = { 'L', 'A', 'N', 'E', 'S', 'H', 'M', '1' };
+const uint32_t RING_VERSION = 1;
+const uint64_t PAGE = 4096;
+
+uint64_t alignUp(uint64_t n, uint64_t a)
+{
+    return (n + a - 1) / a * a;
+}
+
+} // namespace
+
+ShmRing::ShmRing()
+    : control(nullptr), slots(nullptr), map_size(0), owner(false)
+{
+}
+
+ShmRing::~ShmRing()
+{
+    close();
+}
+
+bool ShmRing::map(int fd, size_t size)
+{
+    void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED)
+        return false;
+    control = static_cast<Control*>(p);
+    map_size = size;
+    return true;
+}
+
+bool ShmRing::create(const std::string& name, int slot_count, size_t slot_bytes)
+{
+    close();
+    std::atomic<uint64_t> probe(0);
+    if (slot_count <= 0 || slot_bytes == 0 || !probe.is_lock_free())
+        return false;
+
+    // A ring left behind by a crashed process is replaced, not reused
+    ::shm_unlink(name.c_str());
+    int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0)
+        return false;
+
+    uint64_t bytes = alignUp(slot_bytes, 64);
+    uint64_t data_offset = alignUp(sizeof(Control), PAGE);
+    size_t size = static_cast<size_t>(data_offset + bytes * slot_count);
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0 || !map(fd, size)) {
+        ::shm_unlink(name.c_str());
+        return false;
+    }
+
+    new (control) Control();
+    control->version = RING_VERSION;
+    control->slot_count = static_cast<uint32_t>(slot_count);
+    control->slot_bytes = bytes;
+    control->data_offset = data_offset;
+    control->head.store(0, std::memory_order_relaxed);
+    control->tail.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(control->magic, RING_MAGIC, sizeof(RING_MAGIC));
+
+    slots = reinterpret_cast<unsigned char*>(control) + data_offset;
+    shm_name = name;
+    owner = true;
+    return true;
+}
+
+bool ShmRing::attach(const std::string& name)
+{
+    close();
+    int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Control)) {
+        ::close(fd);
+        return false;
+    }
+    if (!map(fd, static_cast<size_t>(st.st_size)))
+        return false;
+
+    const Control& c = *control;
+    bool valid = std::memcmp(c.magic, RING_MAGIC, sizeof(RING_MAGIC)) == 0 && c.version == RING_VERSION &&
+                 c.slot_count > 0 && c.slot_bytes > 0 && c.data_offset >= sizeof(Control) &&
+                 c.data_offset + c.slot_bytes * c.slot_count <= map_size;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (!valid) {
+        close();
+        return false;
+    }
+    slots = reinterpret_cast<unsigned char*>(control) + c.data_offset;
+    shm_name = name;
+    owner = false;
+    return true;
+}
+
+void ShmRing::close()
+{
+    if (control != nullptr)
+        ::munmap(control, map_size);
+    if (owner)
+        ::shm_unlink(shm_name.c_str());
+    control = nullptr;
+    slots = nullptr;
+    map_size = 0;
+    shm_name.clear();
+    owner = false;
+}
+
+void* ShmRing::tryAcquireWrite()
+{
+    uint64_t h = control->head.load(std::memory_order_relaxed);
+    if (h - control->tail.load(std::memory_order_acquire) >= control->slot_count)
+        return nullptr;
+    return slot(h);
+}
+
+void ShmRing::commitWrite()
+{
+    control->head.store(control->head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void* ShmRing::tryAcquireRead()
+{
+    uint64_t t = control->tail.load(std::memory_order_relaxed);
+    if (t == control->head.load(std::memory_order_acquire))
+        return nullptr;
+    return slot(t);
+}
+
+void ShmRing::releaseRead()
+{
+    control->tail.store(control->tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+size_t ShmRing::size() const
+{
+    if (control == nullptr)
+        return 0;
+    return static_cast<size_t>(control->head.load(std::memory_order_acquire) - control->tail.load(std::memory_order_acquire));
+}
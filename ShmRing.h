@@ -0,0 +1,78 @@
+/**
+*@file ShmRing.h
+*@brief Single-producer/single-consumer ring of fixed-size slots in POSIX shared memory.
+*@brief The same protocol as SpscRing, across processes: the producer fills the slot at head and
+*@brief publishes it by advancing head, the consumer reads the slot at tail in place and hands
+*@brief it back by advancing tail. Both counters are lock-free 64-bit atomics in the mapping, so
+*@brief a transfer costs two cache-line handoffs and no system call.
+*@brief One process creates (and finally unlinks) the ring, the other attaches to it by name.
+*/
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class ShmRing
+{
+public:
+	ShmRing();
+	~ShmRing();
+
+	ShmRing(const ShmRing&) = delete;
+	ShmRing& operator=(const ShmRing&) = delete;
+
+	// Create the ring (a stale ring of the same name is replaced); name is a POSIX shm name
+	// such as "/lane-front-frames". Slots are rounded up to 64 bytes.
+	bool create(const std::string& name, int slot_count, size_t slot_bytes);
+
+	// Map a ring another process created
+	bool attach(const std::string& name);
+
+	bool isOpened() const { return control != nullptr; }
+
+	// Unmap; the creator also removes the name
+	void close();
+
+	// Producer: next free slot, or nullptr if the ring is full
+	void* tryAcquireWrite();
+
+	// Producer: publish the slot returned by tryAcquireWrite
+	void commitWrite();
+
+	// Consumer: oldest filled slot, or nullptr if the ring is empty
+	void* tryAcquireRead();
+
+	// Consumer: hand the slot returned by tryAcquireRead back to the producer
+	void releaseRead();
+
+	size_t size() const;
+	int capacity() const { return control != nullptr ? static_cast<int>(control->slot_count) : 0; }
+	size_t slotBytes() const { return control != nullptr ? static_cast<size_t>(control->slot_bytes) : 0; }
+
+private:
+	// Start of the mapping; the slots follow at data_offset
+	struct Control
+	{
+		char magic[8];                          // "LANESHM1", written last by create()
+		uint32_t version;
+		uint32_t slot_count;
+		uint64_t slot_bytes;
+		uint64_t data_offset;
+		alignas(64) std::atomic<uint64_t> head; // Slots ever published, written by the producer only
+		alignas(64) std::atomic<uint64_t> tail; // Slots ever released, written by the consumer only
+	};
+
+	Control* control;
+	unsigned char* slots;
+	size_t map_size;
+	std::string shm_name;
+	bool owner;                 // Created the ring, unlinks it on close()
+
+	bool map(int fd, size_t size);
+	unsigned char* slot(uint64_t n) const { return slots + (n % control->slot_count) * control->slot_bytes; }
+};
+
+#endif // SHM_RING_H
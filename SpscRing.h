@@ -0,0 +1,77 @@
+/**
+*@file SpscRing.h
+*@brief Bounded lock-free single-producer/single-consumer ring of reusable slots.
+*@brief Slots are allocated once and handed out in place, so a producer can fill a slot's
+*@brief buffers (e.g. cv::Mat frames) without allocating, and the consumer reads them in order.
+*/
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+template <typename T>
+class SpscRing
+{
+public:
+	explicit SpscRing(size_t capacity)
+		: slots(capacity > 0 ? capacity : 1), head(0), tail(0), closed_flag(false)
+	{
+	}
+
+	// Producer: next free slot, or nullptr if the ring is full
+	T* tryAcquireWrite()
+	{
+		size_t h = head.load(std::memory_order_relaxed);
+		if (h - tail.load(std::memory_order_acquire) >= slots.size())
+			return nullptr;
+		return &slots[h % slots.size()];
+	}
+
+	// Producer: publish the slot returned by tryAcquireWrite
+	void commitWrite()
+	{
+		head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	// Consumer: oldest filled slot, or nullptr if the ring is empty
+	T* tryAcquireRead()
+	{
+		size_t t = tail.load(std::memory_order_relaxed);
+		if (t == head.load(std::memory_order_acquire))
+			return nullptr;
+		return &slots[t % slots.size()];
+	}
+
+	// Consumer: hand the slot returned by tryAcquireRead back to the producer
+	void releaseRead()
+	{
+		tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	// Producer: no more slots will be written
+	void close() { closed_flag.store(true, std::memory_order_release); }
+
+	// Consumer: true once the producer closed the ring and every slot was read
+	bool finished() const
+	{
+		return closed_flag.load(std::memory_order_acquire) &&
+		       tail.load(std::memory_order_relaxed) == head.load(std::memory_order_acquire);
+	}
+
+	size_t size() const
+	{
+		return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+	}
+
+	size_t capacity() const { return slots.size(); }
+
+private:
+	std::vector<T> slots;
+	alignas(64) std::atomic<size_t> head;   // Written by the producer only
+	alignas(64) std::atomic<size_t> tail;   // Written by the consumer only
+	alignas(64) std::atomic<bool> closed_flag;
+};
+
+#endif // SPSC_RING_H
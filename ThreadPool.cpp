@@ -0,0 +1,115 @@
+/**
+*@file ThreadPool.cpp
+*@brief Work-stealing thread pool implementation.
+*/
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(int threads)
+    : queued(0), unfinished(0), stopping(false), next_queue(0), steal_count(0)
+{
+    if (threads <= 0)
+        threads = static_cast<int>(std::thread::hardware_concurrency());
+    if (threads <= 0)
+        threads = 1;
+
+    for (int i = 0; i < threads; i++)
+        queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue));
+    for (int i = 0; i < threads; i++)
+        workers.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(state_lock);
+        stopping = true;
+    }
+    work_ready.notify_all();
+    for (auto& t : workers)
+        t.join();
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    // Count first, so a worker can never finish the task before it is counted
+    {
+        std::lock_guard<std::mutex> guard(state_lock);
+        queued++;
+        unfinished++;
+    }
+    unsigned index = next_queue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+    {
+        std::lock_guard<std::mutex> guard(queues[index]->lock);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    work_ready.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> guard(state_lock);
+    all_done.wait(guard, [this] { return unfinished == 0; });
+}
+
+/**
+*@brief Take the newest task of the worker's own deque, or steal the oldest one of another
+*/
+bool ThreadPool::takeTask(int worker, std::function<void()>& task)
+{
+    WorkQueue& own = *queues[worker];
+    {
+        std::lock_guard<std::mutex> guard(own.lock);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    int n = static_cast<int>(queues.size());
+    for (int k = 1; k < n; k++) {
+        WorkQueue& victim = *queues[(worker + k) % n];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            steal_count.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(int worker)
+{
+    std::function<void()> task;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> guard(state_lock);
+            work_ready.wait(guard, [this] { return queued > 0 || stopping; });
+            if (queued == 0 && stopping)
+                return;
+        }
+
+        // The task may not be pushed yet, or another worker may have taken it
+        if (!takeTask(worker, task)) {
+            std::this_thread::yield();
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> guard(state_lock);
+            queued--;
+        }
+
+        task();
+        task = nullptr;
+
+        bool done;
+        {
+            std::lock_guard<std::mutex> guard(state_lock);
+            done = --unfinished == 0;
+        }
+        if (done)
+            all_done.notify_all();
+    }
+}
@@ -0,0 +1,63 @@
+/**
+*@file ThreadPool.h
+*@brief Fixed-size work-stealing thread pool.
+*@brief Every worker owns a task deque: it pops its own tasks from the back and, when it runs
+*@brief dry, steals from the front of the other workers' deques, so long and short tasks
+*@brief spread over all cores without a single shared queue.
+*/
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+public:
+	// threads <= 0 uses one worker per hardware thread
+	explicit ThreadPool(int threads = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// Queue a task; tasks are spread round-robin over the worker deques
+	void submit(std::function<void()> task);
+
+	// Block until every submitted task has finished
+	void wait();
+
+	int size() const { return static_cast<int>(workers.size()); }
+
+	// Tasks taken from another worker's deque since construction
+	long steals() const { return steal_count.load(std::memory_order_relaxed); }
+
+private:
+	struct WorkQueue
+	{
+		std::mutex lock;
+		std::deque<std::function<void()> > tasks;
+	};
+
+	std::vector<std::unique_ptr<WorkQueue> > queues;
+	std::vector<std::thread> workers;
+	std::mutex state_lock;
+	std::condition_variable work_ready;
+	std::condition_variable all_done;
+	long queued;                        // Tasks in the deques, guarded by state_lock
+	long unfinished;                    // Tasks submitted but not finished, guarded by state_lock
+	bool stopping;
+	std::atomic<unsigned> next_queue;
+	std::atomic<long> steal_count;
+
+	bool takeTask(int worker, std::function<void()>& task);
+	void workerLoop(int worker);
+};
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,152 @@
+/**
+*@file Tracer.cpp
+*@brief Thread buffer registry and the Chrome trace writer.
+*@brief A thread registers its buffer in attach() after start(); buffers of an earlier start()
+*@brief are retired but kept alive, since their threads may still hold them.
+*/
+#include <cstdio>
+#include "Tracer.h"
+
+std::atomic<bool> Tracer::active(false);
+std::atomic<int> Tracer::generation(0);
+std::mutex Tracer::registry_lock;
+std::vector<std::unique_ptr<Tracer::ThreadBuffer> > Tracer::buffers;
+size_t Tracer::capacity = 1 << 16;
+std::chrono::steady_clock::time_point Tracer::epoch;
+std::atomic<long> Tracer::dropped_events(0);
+
+namespace {
+
+thread_local void* local_buffer = nullptr;
+thread_local int local_generation = -1;
+
+// Names are literals of this code base; escape anyway so the JSON stays valid
+void writeJsonString(FILE* out, const char* s)
+{
+    std::fputc('"', out);
+    for (; *s != '\0'; s++) {
+        if (*s == '"' || *s == '\\')
+            std::fputc('\\', out);
+        if (static_cast<unsigned char>(*s) >= 0x20)
+            std::fputc(*s, out);
+    }
+    std::fputc('"', out);
+}
+
+} // namespace
+
+void Tracer::start(size_t events_per_thread)
+{
+    std::lock_guard<std::mutex> guard(registry_lock);
+    capacity = events_per_thread > 0 ? events_per_thread : 1;
+    epoch = std::chrono::steady_clock::now();
+    dropped_events.store(0, std::memory_order_relaxed);
+    generation.fetch_add(1, std::memory_order_release);
+    active.store(true, std::memory_order_release);
+}
+
+Tracer::ThreadBuffer* Tracer::local()
+{
+    if (local_generation != generation.load(std::memory_order_acquire))
+        return nullptr;
+    return static_cast<ThreadBuffer*>(local_buffer);
+}
+
+void Tracer::attach()
+{
+    if (!enabled() || local() != nullptr)
+        return;
+    std::lock_guard<std::mutex> guard(registry_lock);
+    int current = generation.load(std::memory_order_relaxed);
+    int tid = 1;
+    for (const auto& b : buffers)
+        tid += b->generation == current ? 1 : 0;
+    buffers.emplace_back(new ThreadBuffer(capacity, tid, current));
+    local_buffer = buffers.back().get();
+    local_generation = current;
+}
+
+void Tracer::setThreadName(const char* name)
+{
+    attach();
+    ThreadBuffer* b = local();
+    if (b != nullptr)
+        b->name = name;
+}
+
+void Tracer::setFrame(long frame)
+{
+    ThreadBuffer* b = enabled() ? local() : nullptr;
+    if (b != nullptr)
+        b->frame = frame;
+}
+
+void Tracer::record(const char* name, std::chrono::steady_clock::time_point begin,
+                    std::chrono::steady_clock::time_point end)
+{
+    ThreadBuffer* b = local();
+    if (b == nullptr) {
+        dropped_events.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    uint64_t n = b->head.load(std::memory_order_relaxed);
+    Event& e = b->ring[n % b->ring.size()];
+    e.name = name;
+    e.begin_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(begin - epoch).count();
+    e.duration_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+    e.frame = b->frame;
+    b->head.store(n + 1, std::memory_order_release);
+}
+
+long Tracer::overwritten()
+{
+    std::lock_guard<std::mutex> guard(registry_lock);
+    int current = generation.load(std::memory_order_relaxed);
+    long lost = 0;
+    for (const auto& b : buffers) {
+        uint64_t n = b->head.load(std::memory_order_acquire);
+        if (b->generation == current && n > b->ring.size())
+            lost += static_cast<long>(n - b->ring.size());
+    }
+    return lost;
+}
+
+/**
+*@brief Complete ("X") events in microseconds, one tid per traced thread, thread names as metadata
+*/
+bool Tracer::writeChromeTrace(const std::string& path)
+{
+    FILE* out = std::fopen(path.c_str(), "w");
+    if (out == nullptr)
+        return false;
+
+    std::lock_guard<std::mutex> guard(registry_lock);
+    int current = generation.load(std::memory_order_relaxed);
+    bool first = true;
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", out);
+    for (const auto& b : buffers) {
+        if (b->generation != current)
+            continue;
+        if (b->name != nullptr) {
+            std::fprintf(out, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":",
+                         first ? "" : ",\n", b->tid);
+            writeJsonString(out, b->name);
+            std::fputs("}}", out);
+            first = false;
+        }
+        uint64_t n = b->head.load(std::memory_order_acquire);
+        uint64_t size = b->ring.size();
+        for (uint64_t i = n > size ? n - size : 0; i < n; i++) {
+            const Event& e = b->ring[i % size];
+            std::fprintf(out, "%s{\"ph\":\"X\",\"name\":", first ? "" : ",\n");
+            writeJsonString(out, e.name);
+            std::fprintf(out, ",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f", b->tid, e.begin_ns / 1000.0, e.duration_ns / 1000.0);
+            if (e.frame >= 0)
+                std::fprintf(out, ",\"args\":{\"frame\":%ld}", e.frame);
+            std::fputc('}', out);
+            first = false;
+        }
+    }
+    std::fputs("\n]}\n", out);
+    return std::fclose(out) == 0;
+}
@@ -0,0 +1,113 @@
+/**
+*@file Tracer.h
+*@brief Opt-in per-frame event tracing, dumped as Chrome trace JSON (opens in Perfetto).
+*@brief Every thread records into its own fixed-size ring of complete (begin + end) events.
+*@brief The ring is allocated and registered by attach() (or setThreadName()) before the traced
+*@brief loop, so recording takes no lock and never allocates; events of a thread that did not
+*@brief attach are dropped and counted, and a full ring overwrites its oldest events. Events carry
+*@brief the frame index the thread set last. While tracing is off a TraceScope costs one relaxed
+*@brief load; -DLANE_NO_PERF removes it entirely.
+*@brief Names must be string literals (or otherwise outlive the dump): only the pointer is stored.
+*/
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class Tracer
+{
+public:
+	// Start recording; every thread's ring holds events_per_thread events
+	static void start(size_t events_per_thread = 1 << 16);
+	static void stop() { active.store(false, std::memory_order_relaxed); }
+	static bool enabled() { return active.load(std::memory_order_relaxed); }
+
+	// Allocate and register the calling thread's ring for the current start(); takes the registry
+	// lock, so call it before the traced loop. Does nothing while tracing is off or if attached.
+	static void attach();
+
+	// Name of the calling thread in the trace, e.g. "decode"; attaches the thread
+	static void setThreadName(const char* name);
+
+	// Frame index attached to the calling thread's following events, -1 for none
+	static void setFrame(long frame);
+
+	// One event of the calling thread from begin to end
+	static void record(const char* name, std::chrono::steady_clock::time_point begin,
+	                   std::chrono::steady_clock::time_point end);
+
+	// Write every thread's events as Chrome trace JSON; call once the traced threads are idle
+	static bool writeChromeTrace(const std::string& path);
+
+	// Events overwritten because a ring was full
+	static long overwritten();
+
+	// Events dropped because their thread had not attached
+	static long dropped() { return dropped_events.load(std::memory_order_relaxed); }
+
+private:
+	struct Event
+	{
+		const char* name;
+		int64_t begin_ns;           // Since the tracer started
+		int64_t duration_ns;
+		long frame;
+	};
+
+	struct ThreadBuffer
+	{
+		std::vector<Event> ring;
+		std::atomic<uint64_t> head;     // Events ever recorded, owner thread writes
+		const char* name;
+		int tid;
+		int generation;
+		long frame;
+		ThreadBuffer(size_t capacity, int tid, int generation)
+			: ring(capacity), head(0), name(nullptr), tid(tid), generation(generation), frame(-1) {}
+	};
+
+	static std::atomic<bool> active;
+	static std::atomic<int> generation;             // Bumped by start(), retires the thread buffers
+	static std::mutex registry_lock;
+	static std::vector<std::unique_ptr<ThreadBuffer> > buffers;    // Retired ones are kept, never freed
+	static size_t capacity;
+	static std::chrono::steady_clock::time_point epoch;
+	static std::atomic<long> dropped_events;
+
+	// Ring of the calling thread for the current start(), nullptr if it has not attached
+	static ThreadBuffer* local();
+};
+
+// Records its own lifetime as one event when tracing is on
+class TraceScope
+{
+public:
+#ifndef LANE_NO_PERF
+	explicit TraceScope(const char* name)
+		: name(Tracer::enabled() ? name : nullptr)
+	{
+		if (this->name != nullptr)
+			begin = std::chrono::steady_clock::now();
+	}
+
+	~TraceScope()
+	{
+		if (name != nullptr)
+			Tracer::record(name, begin, std::chrono::steady_clock::now());
+	}
+
+private:
+	const char* name;
+	std::chrono::steady_clock::time_point begin;
+#else
+	explicit TraceScope(const char*) {}
+#endif
+};
+
+#endif // TRACER_H
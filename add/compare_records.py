@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+"""比较两个车道线数据文件(CSV, main --record 输出)，超出容差时返回非零
+
+用法: compare_records.py 基准.csv 待测.csv [--max-mismatch 比例] [--max-turn-mismatch 比例] [--max-offset 像素]
+待测文件中的每一帧都必须出现在基准文件中；基准文件可以更长（例如只转换了前N帧的输入）。
+"""
+
+import argparse
+import csv
+import math
+import sys
+
+def read_records(path):
+    """按帧号读取记录: (是否检测到, 4个端点, 转向)"""
+    records = {}
+    with open(path, newline='') as f:
+        reader = csv.reader(f)
+        next(reader, None)
+        for row in reader:
+            if len(row) < 15:
+                continue
+            values = [int(v) for v in row[3:11]]
+            points = [(values[2 * i], values[2 * i + 1]) for i in range(4)]
+            records[int(row[0])] = (row[2] == '1', points, row[13])
+    return records
+
+def compare(ref, test):
+    """统计检测结果不一致、转向不一致的帧数，以及两者都检测到时的端点偏差"""
+    stats = {'frames': 0, 'missing': 0, 'found_mismatch': 0, 'compared': 0,
+             'turn_mismatch': 0, 'offset_sum': 0.0, 'offset_max': 0.0, 'identical': 0}
+    for frame, (detected, points, turn) in sorted(test.items()):
+        stats['frames'] += 1
+        if frame not in ref:
+            stats['missing'] += 1
+            continue
+        ref_detected, ref_points, ref_turn = ref[frame]
+        if (detected, points, turn) == (ref_detected, ref_points, ref_turn):
+            stats['identical'] += 1
+        if detected != ref_detected:
+            stats['found_mismatch'] += 1
+            continue
+        if not detected:
+            continue
+        offset = max(math.hypot(a[0] - b[0], a[1] - b[1]) for a, b in zip(points, ref_points))
+        stats['offset_sum'] += offset
+        stats['offset_max'] = max(stats['offset_max'], offset)
+        stats['turn_mismatch'] += 1 if turn != ref_turn else 0
+        stats['compared'] += 1
+    return stats
+
+def main():
+    parser = argparse.ArgumentParser(description='比较两个车道线数据文件')
+    parser.add_argument('ref')
+    parser.add_argument('test')
+    parser.add_argument('--max-mismatch', type=float, default=0.0, help='仅一方检测到车道线的帧比例上限')
+    parser.add_argument('--max-turn-mismatch', type=float, default=0.0, help='两者都检测到时转向不一致的帧比例上限')
+    parser.add_argument('--max-offset', type=float, default=0.0, help='两者都检测到时平均端点偏差上限(像素)')
+    args = parser.parse_args()
+
+    stats = compare(read_records(args.ref), read_records(args.test))
+    frames = stats['frames']
+    compared = stats['compared']
+    mean_offset = stats['offset_sum'] / compared if compared else 0.0
+    print(f"记录比较: {frames} 帧, 完全一致 {stats['identical']} 帧, 基准中缺失 {stats['missing']} 帧")
+    print(f"├── 仅一方检测到车道线: {stats['found_mismatch']} 帧 (容差 {args.max_mismatch * 100:.1f}%)")
+    print(f"├── 转向不一致: {stats['turn_mismatch']}/{compared} (容差 {args.max_turn_mismatch * 100:.1f}%)")
+    print(f"└── 端点偏差: 平均 {mean_offset:.2f} px, 最大 {stats['offset_max']:.2f} px (容差 平均 {args.max_offset:.2f} px)")
+
+    ok = (frames > 0 and stats['missing'] == 0 and
+          stats['found_mismatch'] <= args.max_mismatch * frames and
+          stats['turn_mismatch'] <= args.max_turn_mismatch * compared and
+          mean_offset <= args.max_offset)
+    return 0 if ok else 1
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -7,6 +7,31 @@ import csv
 import glob
 from collections import defaultdict
 
+# 逐帧结构化日志: [FRAME] frame=12 t_ms=421.300 lane=1 turn="Straight" detect_ms=3.214
+FRAME_PATTERN = re.compile(r'^\[FRAME\]\s+(.*)$', re.MULTILINE)
+FIELD_PATTERN = re.compile(r'(\w+)=("[^"]*"|\S+)')
+
+def parse_frame_records(content):
+    """解析日志中的 [FRAME] 记录，每条返回一个字段字典"""
+    records = []
+    for match in FRAME_PATTERN.finditer(content):
+        fields = {}
+        for key, value in FIELD_PATTERN.findall(match.group(1)):
+            fields[key] = value[1:-1] if value.startswith('"') else value
+        records.append(fields)
+    return records
+
+def summarize_frame_records(records):
+    """逐帧记录的帧数、检测到车道线的帧数以及检测耗时的平均值与p95"""
+    times = sorted(float(r['detect_ms']) for r in records if 'detect_ms' in r)
+    summary = {
+        'log_frames': len(records),
+        'lane_frames': sum(1 for r in records if r.get('lane') == '1'),
+        'detect_mean': sum(times) / len(times) if times else 0.0,
+        'detect_p95': times[min(len(times) - 1, int(len(times) * 0.95))] if times else 0.0
+    }
+    return summary
+
 def extract_data_from_log(log_file):
     """从日志文件中提取性能数据"""
     data = {
@@ -19,7 +44,11 @@ def extract_data_from_log(log_file):
         'separation_time': None,
         'regression_time': None,
         'predict_time': None,
-        'plot_time': None
+        'plot_time': None,
+        'log_frames': 0,
+        'lane_frames': 0,
+        'detect_mean': 0.0,
+        'detect_p95': 0.0
     }
     
     try:
@@ -54,6 +83,9 @@ def extract_data_from_log(log_file):
                 data[key] = float(match.group(1))
             else:
                 data[key] = 0.0
+
+        # 提取逐帧记录
+        data.update(summarize_frame_records(parse_frame_records(content)))
                 
     except Exception as e:
         print(f"处理文件 {log_file} 时出错: {e}")
@@ -100,7 +132,8 @@ def process_all_logs():
             "去噪时间(ms)", "边缘检测时间(ms)", "掩码时间(ms)", "Hough时间(ms)",
             "线分离时间(ms)", "回归时间(ms)", "预测时间(ms)", "绘制时间(ms)",
             "去噪百分比", "边缘检测百分比", "掩码百分比", "Hough百分比",
-            "线分离百分比", "回归百分比", "预测百分比", "绘制百分比"
+            "线分离百分比", "回归百分比", "预测百分比", "绘制百分比",
+            "日志帧数", "检测到车道线帧数", "逐帧检测平均(ms)", "逐帧检测p95(ms)"
         ]
         writer.writerow(header)
         
@@ -113,7 +146,8 @@ def process_all_logs():
                 avg_data = {}
                 for key in ['total_time', 'total_frames', 'denoise_time', 'edge_time', 
                            'mask_time', 'hough_time', 'separation_time', 'regression_time', 
-                           'predict_time', 'plot_time']:
+                           'predict_time', 'plot_time', 'log_frames', 'lane_frames',
+                           'detect_mean', 'detect_p95']:
                     values = [d[key] for d in data_list if d[key] is not None]
                     if values:
                         avg_data[key] = sum(values) / len(values)
@@ -163,7 +197,11 @@ def process_all_logs():
                     f"{percentages['separation']:.2f}",
                     f"{percentages['regression']:.2f}",
                     f"{percentages['predict']:.2f}",
-                    f"{percentages['plot']:.2f}"
+                    f"{percentages['plot']:.2f}",
+                    f"{avg_data['log_frames']:.0f}",
+                    f"{avg_data['lane_frames']:.0f}",
+                    f"{avg_data['detect_mean']:.3f}",
+                    f"{avg_data['detect_p95']:.3f}"
                 ]
                 writer.writerow(row)
                 
@@ -235,8 +273,20 @@ def generate_detailed_analysis():
             f.write(f"    结果绘制: {row['绘制时间(ms)']} ms ({row['绘制百分比']}%)\n")
             f.write("\n")
         
+        # 逐帧检测统计
+        f.write("3. 逐帧检测统计\n")
+        f.write("-" * 30 + "\n")
+        for row in data:
+            f.write(f"配置: {row['配置']}\n")
+            if float(row.get('日志帧数') or 0) > 0:
+                f.write(f"  日志帧数: {row['日志帧数']}, 检测到车道线: {row['检测到车道线帧数']}\n")
+                f.write(f"  检测耗时: 平均 {row['逐帧检测平均(ms)']} ms, p95 {row['逐帧检测p95(ms)']} ms\n")
+            else:
+                f.write("  日志中没有 [FRAME] 记录\n")
+            f.write("\n")
+
         # 优化建议
-        f.write("3. 性能优化建议\n")
+        f.write("4. 性能优化建议\n")
         f.write("-" * 30 + "\n")
         for row in data:
             f.write(f"配置 {row['配置']}:\n")
@@ -39,31 +39,10 @@ run_functional_test() {
         return 1
     fi
     
-    # 临时修改程序以使用指定的视频文件
-    cp main main_backup
-    sed -i "s/video_project.mp4/$video_file/g" main.cpp
-    
-    # 重新编译
-    make clean > /dev/null 2>&1
-    make all > /dev/null 2>&1
-    
-    if [ $? -ne 0 ]; then
-        echo "❌ 测试失败: 编译失败"
-        failed_tests=$((failed_tests + 1))
-        # 恢复备份
-        mv main_backup main
-        return 1
-    fi
-    
     # 运行程序（限制运行时间）
-    timeout 30s ./main > "$OUTPUT_DIR/${test_name}_output.log" 2>&1
+    timeout 30s ./main --input "$video_file" > "$OUTPUT_DIR/${test_name}_output.log" 2>&1
     exit_code=$?
     
-    # 恢复备份
-    mv main_backup main
-    make clean > /dev/null 2>&1
-    make all > /dev/null 2>&1
-    
     # 分析测试结果
     if [ $exit_code -eq 0 ]; then
         # 检查输出文件是否生成
@@ -170,6 +149,541 @@ else
 fi
 total_tests=$((total_tests + 1))
 
+# 测试用例7：融合边缘检测一致性
+echo "=========================================="
+echo "测试用例7：融合边缘检测一致性"
+echo "=========================================="
+echo "对比融合边缘检测核与原始去噪+边缘检测链路（前30帧，全部指令集路径）..."
+timeout 120s ./main --verify-edge 30 > "$OUTPUT_DIR/TC007_融合边缘检测一致性_output.log" 2>&1
+edge_verify_code=$?
+if [ $edge_verify_code -eq 0 ]; then
+    echo "✅ 融合边缘检测与原始链路逐像素一致"
+    passed_tests=$((passed_tests + 1))
+else
+    echo "❌ 融合边缘检测与原始链路不一致，详见 $OUTPUT_DIR/TC007_融合边缘检测一致性_output.log"
+    failed_tests=$((failed_tests + 1))
+fi
+total_tests=$((total_tests + 1))
+
+# 测试用例8：稳态零内存分配
+echo "=========================================="
+echo "测试用例8：稳态零内存分配"
+echo "=========================================="
+echo "经detectFrame统计各检测路径首帧之后的堆内存分配次数（车道角度Hough，默认/跟踪/位图模式）..."
+# 计数分配器只在 make ALLOC_CHECK=1 构建的程序中启用；HoughLinesP在OpenCV内部分配，检查使用车道角度Hough引擎
+alloc_check_code=0
+if make ALLOC_CHECK=1 EXE=main_alloc_check > "$OUTPUT_DIR/TC008_稳态零内存分配_output.log" 2>&1; then
+    # 跟踪模式需要更多帧才能锁定并进入窄带路径
+    for alloc_args in "--alloc-check 30" "--alloc-check 90 --track" "--alloc-check 30 --bitmap"; do
+        echo "=== --hough lane $alloc_args ===" >> "$OUTPUT_DIR/TC008_稳态零内存分配_output.log"
+        timeout 120s ./main_alloc_check --hough lane $alloc_args >> "$OUTPUT_DIR/TC008_稳态零内存分配_output.log" 2>&1
+        run_code=$?
+        if [ $run_code -ne 0 ]; then
+            echo "   $alloc_args: 失败 (返回 $run_code)"
+            alloc_check_code=1
+        fi
+    done
+else
+    alloc_check_code=1
+fi
+if [ $alloc_check_code -eq 0 ]; then
+    echo "✅ 首帧之后各阶段无堆内存分配"
+    passed_tests=$((passed_tests + 1))
+else
+    echo "❌ 稳态下仍有堆内存分配，详见 $OUTPUT_DIR/TC008_稳态零内存分配_output.log"
+    failed_tests=$((failed_tests + 1))
+fi
+total_tests=$((total_tests + 1))
+
+# 测试用例9：Hough引擎一致性
+echo "=========================================="
+echo "测试用例9：Hough引擎一致性"
+echo "=========================================="
+echo "全角度Hough引擎与HoughLinesP逐条对比，并统计车道角度引擎的偏差（前30帧）..."
+timeout 120s ./main --hough-bench 30 > "$OUTPUT_DIR/TC009_Hough引擎一致性_output.log" 2>&1
+hough_bench_code=$?
+if [ $hough_bench_code -eq 0 ]; then
+    echo "✅ 全角度Hough引擎与HoughLinesP结果一致"
+    passed_tests=$((passed_tests + 1))
+else
+    echo "❌ Hough引擎与HoughLinesP不一致，详见 $OUTPUT_DIR/TC009_Hough引擎一致性_output.log"
+    failed_tests=$((failed_tests + 1))
+fi
+total_tests=$((total_tests + 1))
+
+# 测试用例10：车道线跟踪模式
+echo "=========================================="
+echo "测试用例10：车道线跟踪模式"
+echo "=========================================="
+echo "以跟踪模式处理视频，锁定后只检测预测车道线附近的窄带..."
+timeout 300s ./main --track > "$OUTPUT_DIR/TC010_车道线跟踪模式_output.log" 2>&1
+track_code=$?
+if [ $track_code -eq 0 ] && grep -q "窄带检测帧" "$OUTPUT_DIR/TC010_车道线跟踪模式_output.log"; then
+    echo "✅ 跟踪模式运行正常"
+    grep -A3 "跟踪统计" "$OUTPUT_DIR/TC010_车道线跟踪模式_output.log"
+    passed_tests=$((passed_tests + 1))
+else
+    echo "❌ 跟踪模式运行失败，详见 $OUTPUT_DIR/TC010_车道线跟踪模式_output.log"
+    failed_tests=$((failed_tests + 1))
+fi
+total_tests=$((total_tests + 1))
+
+# 测试用例11：多路视频批处理
+echo "=========================================="
+echo "测试用例11：多路视频批处理"
+echo "=========================================="
+echo "两路视频共享线程池并发处理..."
+rm -rf "$OUTPUT_DIR/TC011_batch"
+timeout 300s ./main --input video_project.mp4 --input video_challenge.mp4 --threads 2 \
+    --output-dir "$OUTPUT_DIR/TC011_batch" --batch-csv "$OUTPUT_DIR/TC011_batch.csv" \
+    > "$OUTPUT_DIR/TC011_多路视频批处理_output.log" 2>&1
+batch_code=$?
+batch_outputs=$(ls "$OUTPUT_DIR"/TC011_batch/*_lane_detection_color.avi 2>/dev/null | wc -l)
+if [ $batch_code -eq 0 ] && [ "$batch_outputs" -eq 2 ]; then
+    echo "✅ 批处理完成，生成 $batch_outputs 路输出"
+    grep "整体吞吐\|单帧延迟" "$OUTPUT_DIR/TC011_多路视频批处理_output.log"
+    passed_tests=$((passed_tests + 1))
+else
+    echo "❌ 批处理失败，详见 $OUTPUT_DIR/TC011_多路视频批处理_output.log"
+    failed_tests=$((failed_tests + 1))
+fi
+total_tests=$((total_tests + 1))
+
+# 测试用例12：仅输出车道线数据
+echo "=========================================="
+echo "测试用例12：仅输出车道线数据"
+echo "=========================================="
+echo "不绘制、不编码视频，只输出每帧车道线数据..."
+rm -f output_lane_detection_color.avi output_edge_detection_bw.avi
+timeout 300s ./main --input video_project.mp4 --outputs record --record "$OUTPUT_DIR/TC012_lanes.csv" \
+    > "$OUTPUT_DIR/TC012_车道线数据输出_output.log" 2>&1
+record_code=$?
+record_lines=$(tail -n +2 "$OUTPUT_DIR/TC012_lanes.csv" 2>/dev/null | wc -l)
+if [ $record_code -eq 0 ] && [ "$record_lines" -gt 0 ] && [ ! -f output_lane_detection_color.avi ]; then
+    echo "✅ 车道线数据输出正常，共 $record_lines 条记录，未生成视频"
+    passed_tests=$((passed_tests + 1))
+else
+    echo "❌ 车道线数据输出失败，详见 $OUTPUT_DIR/TC012_车道线数据输出_output.log"
+    record_code=1
+    failed_tests=$((failed_tests + 1))
+fi
+total_tests=$((total_tests + 1))
+
+# 测试用例13：配置文件加载
+echo "=========================================="
+echo "测试用例13：配置文件加载"
+echo "=========================================="
+echo "从YAML配置文件加载参数（与内置默认值相同），结果应与默认运行一致..."
+cat > "$OUTPUT_DIR/TC013_lane_config.yml" << 'CONFIG'
+%YAML:1.0
+---
+roi_polygon: [ 0.1640625, 1.0, 0.4296875, 0.625, 0.56015625, 0.625, 1.0, 1.0 ]
+center_x: 0.5
+lane_top_y: 0.6527778
+edge_threshold: 140
+hough_theta_deg: 1.0
+hough_threshold: 20
+hough_min_length: 20
+hough_max_gap: 30
+slope_min: 0.3
+slope_max: 0.85
+reference_height: 720
+CONFIG
+timeout 300s ./main --input video_project.mp4 --outputs record --record "$OUTPUT_DIR/TC013_default.csv" > /dev/null 2>&1
+timeout 300s ./main --input video_project.mp4 --outputs record --record "$OUTPUT_DIR/TC013_config.csv" \
+    --config "$OUTPUT_DIR/TC013_lane_config.yml" > "$OUTPUT_DIR/TC013_配置文件加载_output.log" 2>&1
+config_code=$?
+if [ $config_code -eq 0 ] && cmp -s "$OUTPUT_DIR/TC013_default.csv" "$OUTPUT_DIR/TC013_config.csv"; then
+    echo "✅ 配置文件加载正常，结果与默认参数一致"
+    passed_tests=$((passed_tests + 1))
+else
+    echo "❌ 配置文件加载失败或结果不一致，详见 $OUTPUT_DIR/TC013_配置文件加载_output.log"
+    config_code=1
+    failed_tests=$((failed_tests + 1))
+fi
+total_tests=$((total_tests + 1))
+
+# 测试用例14：多尺度检测
+echo "=========================================="
+echo "测试用例14：多尺度检测"
+echo "=========================================="
+echo "在降采样图像上检测并在全分辨率下精修，对比各尺度的速度与精度..."
+timeout 300s ./main --input video_project.mp4 --scale-bench 100 > "$OUTPUT_DIR/TC014_多尺度检测_output.log" 2>&1
+scale_bench_code=$?
+timeout 300s ./main --input video_project.mp4 --scale 2 --outputs record --record "$OUTPUT_DIR/TC014_scale2.csv" \
+    >> "$OUTPUT_DIR/TC014_多尺度检测_output.log" 2>&1
+scale_code=$?
+if [ $scale_bench_code -eq 0 ] && [ $scale_code -eq 0 ] && [ -s "$OUTPUT_DIR/TC014_scale2.csv" ]; then
+    echo "✅ 多尺度检测正常"
+    grep "尺度" "$OUTPUT_DIR/TC014_多尺度检测_output.log"
+    passed_tests=$((passed_tests + 1))
+else
+    echo "❌ 多尺度检测失败，详见 $OUTPUT_DIR/TC014_多尺度检测_output.log"
+    scale_code=1
+    failed_tests=$((failed_tests + 1))
+fi
+total_tests=$((total_tests + 1))
+
+# 测试用例15：鲁棒直线拟合
+echo "=========================================="
+echo "测试用例15：鲁棒直线拟合"
+echo "=========================================="
+echo "Huber迭代重加权拟合车道线，输出应与最小二乘拟合同样完整..."
+timeout 300s ./main --input video_project.mp4 --fit huber --outputs record --record "$OUTPUT_DIR/TC015_huber.csv" \
+    > "$OUTPUT_DIR/TC015_鲁棒直线拟合_output.log" 2>&1
+fit_code=$?
+lsq_lines=$(tail -n +2 "$OUTPUT_DIR/TC013_default.csv" 2>/dev/null | wc -l)
+huber_lines=$(tail -n +2 "$OUTPUT_DIR/TC015_huber.csv" 2>/dev/null | wc -l)
+if [ $fit_code -eq 0 ] && [ "$huber_lines" -gt 0 ] && [ "$huber_lines" -eq "$lsq_lines" ]; then
+    echo "✅ 鲁棒直线拟合正常 ($huber_lines 帧)"
+    passed_tests=$((passed_tests + 1))
+else
+    echo "❌ 鲁棒直线拟合失败，详见 $OUTPUT_DIR/TC015_鲁棒直线拟合_output.log"
+    fit_code=1
+    failed_tests=$((failed_tests + 1))
+fi
+total_tests=$((total_tests + 1))
+
+# 测试用例16：实时模式
+echo "=========================================="
+echo "测试用例16：实时模式"
+echo "=========================================="
+echo "按源帧率回放视频，始终处理最新帧并统计延迟与丢帧..."
+timeout 300s ./main --input video_project.mp4 --live --live-frames 150 --outputs record \
+    --record "$OUTPUT_DIR/TC016_live.csv" > "$OUTPUT_DIR/TC016_实时模式_output.log" 2>&1
+live_code=$?
+live_records=$(tail -n +2 "$OUTPUT_DIR/TC016_live.csv" 2>/dev/null | wc -l)
+if [ $live_code -eq 0 ] && [ "$live_records" -gt 0 ] && grep -q "采集到决策延迟" "$OUTPUT_DIR/TC016_实时模式_output.log"; then
+    echo "✅ 实时模式正常 ($live_records 帧)"
+    grep -A6 "实时模式统计" "$OUTPUT_DIR/TC016_实时模式_output.log"
+    passed_tests=$((passed_tests + 1))
+else
+    echo "❌ 实时模式失败，详见 $OUTPUT_DIR/TC016_实时模式_output.log"
+    live_code=1
+    failed_tests=$((failed_tests + 1))
+fi
+total_tests=$((total_tests + 1))
+
+# 测试用例17：帧内并行
+echo "=========================================="
+echo "测试用例17：帧内并行"
+echo "=========================================="
+echo "按行分条并行完成边缘检测与掩码（标准Hough同时分条投票），各线程数的线段、车道线与转向应与串行阶段完全一致..."
+# 默认的HoughLinesP在合并后的掩码图上运行；标准Hough由各条带投票后合并
+parallel_code=0
+: > "$OUTPUT_DIR/TC017_帧内并行_output.log"
+for parallel_hough in opencv standard; do
+    timeout 300s ./main --input video_project.mp4 --hough $parallel_hough --parallel-bench 60 >> "$OUTPUT_DIR/TC017_帧内并行_output.log" 2>&1
+    run_code=$?
+    if [ $run_code -ne 0 ]; then
+        echo "   --hough $parallel_hough: 失败 (返回 $run_code)"
+        parallel_code=1
+    fi
+done
+if [ $parallel_code -eq 0 ]; then
+    echo "✅ 帧内并行结果与串行阶段完全一致"
+    grep -A5 "帧内并行扩展性" "$OUTPUT_DIR/TC017_帧内并行_output.log"
+    passed_tests=$((passed_tests + 1))
+else
+    echo "❌ 帧内并行结果与串行阶段不一致，详见 $OUTPUT_DIR/TC017_帧内并行_output.log"
+    failed_tests=$((failed_tests + 1))
+fi
+total_tests=$((total_tests + 1))
+
+# 测试用例18：1位边缘位图
+echo "=========================================="
+echo "测试用例18：1位边缘位图"
+echo "=========================================="
+echo "边缘打包为位图并按行区间掩码，Hough结果应与字节图像完全一致..."
+timeout 300s ./main --input video_project.mp4 --bitmap-bench 60 > "$OUTPUT_DIR/TC018_边缘位图_output.log" 2>&1
+bitmap_code=$?
+if [ $bitmap_code -eq 0 ]; then
+    timeout 300s ./main --input video_project.mp4 --bitmap --outputs record --record "$OUTPUT_DIR/TC018_bitmap.csv" \
+        >> "$OUTPUT_DIR/TC018_边缘位图_output.log" 2>&1
+    bitmap_code=$?
+fi
+if [ $bitmap_code -eq 0 ] && [ -s "$OUTPUT_DIR/TC018_bitmap.csv" ]; then
+    echo "✅ 边缘位图结果一致"
+    grep -A5 "位图边缘表示对比" "$OUTPUT_DIR/TC018_边缘位图_output.log"
+    passed_tests=$((passed_tests + 1))
+else
+    echo "❌ 边缘位图测试失败，详见 $OUTPUT_DIR/TC018_边缘位图_output.log"
+    bitmap_code=1
+    failed_tests=$((failed_tests + 1))
+fi
+total_tests=$((total_tests + 1))
+
+# 测试用例19：车道线绘制
+echo "=========================================="
+echo "测试用例19：车道线绘制"
+echo "=========================================="
+echo "按行区间原地混合绘制车道区域，在绘制区域的外接矩形内与OpenCV绘制结果对比..."
+timeout 300s ./main --input video_project.mp4 --plot-bench 60 > "$OUTPUT_DIR/TC019_车道线绘制_output.log" 2>&1
+plot_code=$?
+if [ $plot_code -eq 0 ]; then
+    echo "✅ 车道线绘制结果一致"
+    grep -A4 "车道线绘制对比" "$OUTPUT_DIR/TC019_车道线绘制_output.log"
+    passed_tests=$((passed_tests + 1))
+else
+    echo "❌ 车道线绘制差异过大，详见 $OUTPUT_DIR/TC019_车道线绘制_output.log"
+    failed_tests=$((failed_tests + 1))
+fi
+total_tests=$((total_tests + 1))
+
+# 测试用例20：异步结构化日志
+echo "=========================================="
+echo "测试用例20：异步结构化日志"
+echo "=========================================="
+echo "逐帧结果写入日志文件，检查 [FRAME] 记录数与处理帧数一致..."
+timeout 300s ./main --input video_project.mp4 --outputs record --record "$OUTPUT_DIR/TC020_lanes.csv" \
+    --log "$OUTPUT_DIR/TC020_frames.log" > "$OUTPUT_DIR/TC020_结构化日志_output.log" 2>&1
+log_code=$?
+log_frames=$(grep -c "^\[FRAME\] frame=" "$OUTPUT_DIR/TC020_frames.log" 2>/dev/null)
+log_expected=$(grep "总处理帧数:" "$OUTPUT_DIR/TC020_结构化日志_output.log" | awk '{print $2}')
+if [ $log_code -eq 0 ] && [ -n "$log_expected" ] && [ "${log_frames:-0}" -eq "$log_expected" ]; then
+    echo "✅ 结构化日志记录完整 ($log_frames 帧)"
+    grep "日志: 写入" "$OUTPUT_DIR/TC020_结构化日志_output.log"
+    passed_tests=$((passed_tests + 1))
+else
+    echo "❌ 结构化日志测试失败，详见 $OUTPUT_DIR/TC020_结构化日志_output.log"
+    log_code=1
+    failed_tests=$((failed_tests + 1))
+fi
+total_tests=$((total_tests + 1))
+
+# 测试用例21：Y4M亮度输入
+echo "=========================================="
+echo "测试用例21：Y4M亮度输入"
+echo "=========================================="
+echo "转换为Y4M后直接在Y平面上检测，车道线数据应与BGR输入（TC012）在容差内一致..."
+# cvtColor输出的Y是有限范围(16..235)，阈值140对应Y平面上的136
+cat > "$OUTPUT_DIR/TC021_luma_config.yml" << 'CONFIG'
+%YAML:1.0
+---
+edge_threshold: 136
+CONFIG
+timeout 300s ./main --input video_project.mp4 --to-y4m "$OUTPUT_DIR/TC021_project.y4m" --y4m-frames 120 \
+    > "$OUTPUT_DIR/TC021_Y4M亮度输入_output.log" 2>&1
+y4m_code=$?
+if [ $y4m_code -eq 0 ]; then
+    timeout 300s ./main --input "$OUTPUT_DIR/TC021_project.y4m" --outputs record --record "$OUTPUT_DIR/TC021_luma.csv" \
+        --config "$OUTPUT_DIR/TC021_luma_config.yml" >> "$OUTPUT_DIR/TC021_Y4M亮度输入_output.log" 2>&1
+    y4m_code=$?
+fi
+if [ $y4m_code -eq 0 ]; then
+    python3 add/compare_records.py "$OUTPUT_DIR/TC012_lanes.csv" "$OUTPUT_DIR/TC021_luma.csv" \
+        --max-mismatch 0.05 --max-turn-mismatch 0.10 --max-offset 10 >> "$OUTPUT_DIR/TC021_Y4M亮度输入_output.log" 2>&1
+    y4m_code=$?
+fi
+rm -f "$OUTPUT_DIR/TC021_project.y4m"
+y4m_records=$(tail -n +2 "$OUTPUT_DIR/TC021_luma.csv" 2>/dev/null | wc -l)
+if [ $y4m_code -eq 0 ] && [ "$y4m_records" -eq 120 ]; then
+    echo "✅ Y4M亮度输入与BGR输入结果一致 ($y4m_records 帧)"
+    grep -A3 "记录比较" "$OUTPUT_DIR/TC021_Y4M亮度输入_output.log"
+    passed_tests=$((passed_tests + 1))
+else
+    echo "❌ Y4M亮度输入测试失败，详见 $OUTPUT_DIR/TC021_Y4M亮度输入_output.log"
+    y4m_code=1
+    failed_tests=$((failed_tests + 1))
+fi
+total_tests=$((total_tests + 1))
+
+# 测试用例22：帧存储回放
+echo "=========================================="
+echo "测试用例22：帧存储回放"
+echo "=========================================="
+echo "前120帧转换为帧存储（Y、BGR、裁剪BGR）后回放，车道线数据应与直接解码运行一致..."
+store_log="$OUTPUT_DIR/TC022_帧存储回放_output.log"
+timeout 300s ./main --input video_project.mp4 --roi --outputs record --record "$OUTPUT_DIR/TC022_roi.csv" > "$store_log" 2>&1
+store_code=$?
+# Y存储: 先模糊再转灰度与先转灰度再模糊的舍入不同，按容差比较
+if [ $store_code -eq 0 ]; then
+    ./main --input video_project.mp4 --to-store "$OUTPUT_DIR/TC022_y.frames" --store-frames 120 >> "$store_log" 2>&1 &&
+    timeout 300s ./main --input "$OUTPUT_DIR/TC022_y.frames" --outputs record --record "$OUTPUT_DIR/TC022_y.csv" >> "$store_log" 2>&1 &&
+    python3 add/compare_records.py "$OUTPUT_DIR/TC012_lanes.csv" "$OUTPUT_DIR/TC022_y.csv" \
+        --max-mismatch 0.05 --max-turn-mismatch 0.10 --max-offset 5 >> "$store_log" 2>&1
+    store_code=$?
+fi
+# BGR存储与直接解码的像素相同，结果应完全一致
+if [ $store_code -eq 0 ]; then
+    ./main --input video_project.mp4 --to-store "$OUTPUT_DIR/TC022_bgr.frames" --store-bgr --store-frames 120 >> "$store_log" 2>&1 &&
+    timeout 300s ./main --input "$OUTPUT_DIR/TC022_bgr.frames" --outputs record --record "$OUTPUT_DIR/TC022_bgr.csv" >> "$store_log" 2>&1 &&
+    python3 add/compare_records.py "$OUTPUT_DIR/TC012_lanes.csv" "$OUTPUT_DIR/TC022_bgr.csv" >> "$store_log" 2>&1
+    store_code=$?
+fi
+# 裁剪存储只含ROI行，回放时自动进入ROI模式，应与直接解码的ROI模式完全一致
+if [ $store_code -eq 0 ]; then
+    ./main --input video_project.mp4 --to-store "$OUTPUT_DIR/TC022_crop.frames" --store-bgr --store-crop --store-frames 120 >> "$store_log" 2>&1 &&
+    timeout 300s ./main --input "$OUTPUT_DIR/TC022_crop.frames" --outputs record --record "$OUTPUT_DIR/TC022_crop.csv" >> "$store_log" 2>&1 &&
+    python3 add/compare_records.py "$OUTPUT_DIR/TC022_roi.csv" "$OUTPUT_DIR/TC022_crop.csv" >> "$store_log" 2>&1
+    store_code=$?
+fi
+rm -f "$OUTPUT_DIR"/TC022_*.frames
+if [ $store_code -eq 0 ]; then
+    echo "✅ 帧存储回放结果与直接解码一致（Y、BGR、裁剪BGR）"
+    grep "记录比较" "$store_log"
+    passed_tests=$((passed_tests + 1))
+else
+    echo "❌ 帧存储回放测试失败，详见 $store_log"
+    store_code=1
+    failed_tests=$((failed_tests + 1))
+fi
+total_tests=$((total_tests + 1))
+
+# 测试用例23：分段并行处理
+echo "=========================================="
+echo "测试用例23：分段并行处理"
+echo "=========================================="
+echo "单个视频按关键帧分段并行检测，拼接后的车道线数据应与顺序运行逐帧一致..."
+timeout 600s ./main --input video_project.mp4 --chunks 0 --chunk-check --outputs record --record "$OUTPUT_DIR/TC023_chunks.csv" \
+    > "$OUTPUT_DIR/TC023_分段并行处理_output.log" 2>&1
+chunk_code=$?
+if [ $chunk_code -eq 0 ]; then
+    python3 add/compare_records.py "$OUTPUT_DIR/TC012_lanes.csv" "$OUTPUT_DIR/TC023_chunks.csv" \
+        >> "$OUTPUT_DIR/TC023_分段并行处理_output.log" 2>&1
+    chunk_code=$?
+fi
+chunk_records=$(tail -n +2 "$OUTPUT_DIR/TC023_chunks.csv" 2>/dev/null | wc -l)
+if [ $chunk_code -eq 0 ] && [ "$chunk_records" -eq "$record_lines" ]; then
+    echo "✅ 分段结果与顺序运行一致 ($chunk_records 帧)"
+    grep "顺序运行对比" "$OUTPUT_DIR/TC023_分段并行处理_output.log"
+    passed_tests=$((passed_tests + 1))
+else
+    echo "❌ 分段结果与顺序运行不一致，详见 $OUTPUT_DIR/TC023_分段并行处理_output.log"
+    chunk_code=1
+    failed_tests=$((failed_tests + 1))
+fi
+total_tests=$((total_tests + 1))
+
+# 测试用例24：变化检测门控
+echo "=========================================="
+echo "测试用例24：变化检测门控"
+echo "=========================================="
+echo "相邻帧变化小于阈值时复用上一帧结果，连续复用不超过 --gate-max 帧；流水线模式下复用帧同样写出边缘图..."
+timeout 300s ./main --input video_project.mp4 --outputs record --record "$OUTPUT_DIR/TC024_gate.csv" --gate 2 --gate-max 3 \
+    > "$OUTPUT_DIR/TC024_变化检测门控_output.log" 2>&1
+gate_code=$?
+gate_records=$(tail -n +2 "$OUTPUT_DIR/TC024_gate.csv" 2>/dev/null | wc -l)
+gate_longest=$(grep "最长连续复用:" "$OUTPUT_DIR/TC024_变化检测门控_output.log" | awk '{print $2}')
+# 流水线模式下复用帧也必须写出边缘图：彩色与黑白视频的帧数应相同（用 --to-y4m 统计帧数）
+timeout 300s ./main --input video_project.mp4 --pipeline --gate 2 --gate-max 3 \
+    >> "$OUTPUT_DIR/TC024_变化检测门控_output.log" 2>&1
+gate_pipeline_code=$?
+gate_color_frames=$(timeout 300s ./main --input output_lane_detection_color.avi --to-y4m "$OUTPUT_DIR/TC024_count.y4m" 2>/dev/null |
+    grep "已转换" | awk '{print $2}')
+gate_edge_frames=$(timeout 300s ./main --input output_edge_detection_bw.avi --to-y4m "$OUTPUT_DIR/TC024_count.y4m" 2>/dev/null |
+    grep "已转换" | awk '{print $2}')
+rm -f "$OUTPUT_DIR/TC024_count.y4m"
+echo "流水线门控: 彩色视频 ${gate_color_frames:-0} 帧, 黑白视频 ${gate_edge_frames:-0} 帧" >> "$OUTPUT_DIR/TC024_变化检测门控_output.log"
+if [ $gate_code -eq 0 ] && [ "$gate_records" -eq "$record_lines" ] && grep -q "复用帧:" "$OUTPUT_DIR/TC024_变化检测门控_output.log" &&
+   [ -n "$gate_longest" ] && [ "$gate_longest" -le 3 ] && [ $gate_pipeline_code -eq 0 ] &&
+   [ -n "$gate_color_frames" ] && [ "$gate_color_frames" -gt 0 ] && [ "$gate_edge_frames" = "$gate_color_frames" ]; then
+    echo "✅ 门控输出 $gate_records 条记录，最长连续复用 $gate_longest 帧；流水线下两个视频各 $gate_color_frames 帧"
+    grep "复用帧:" "$OUTPUT_DIR/TC024_变化检测门控_output.log"
+    passed_tests=$((passed_tests + 1))
+else
+    echo "❌ 变化检测门控测试失败，详见 $OUTPUT_DIR/TC024_变化检测门控_output.log"
+    gate_code=1
+    failed_tests=$((failed_tests + 1))
+fi
+total_tests=$((total_tests + 1))
+
+# 测试用例25：逐帧事件追踪
+echo "=========================================="
+echo "测试用例25：逐帧事件追踪"
+echo "=========================================="
+echo "对60帧短片段导出Chrome追踪文件，应为合法JSON并包含带帧号的解码、检测、编码事件..."
+trace_log="$OUTPUT_DIR/TC025_逐帧事件追踪_output.log"
+timeout 120s ./main --input video_project.mp4 --to-y4m "$OUTPUT_DIR/TC025_clip.y4m" --y4m-frames 60 > "$trace_log" 2>&1 &&
+timeout 300s ./main --input "$OUTPUT_DIR/TC025_clip.y4m" --trace "$OUTPUT_DIR/TC025_trace.json" >> "$trace_log" 2>&1
+trace_code=$?
+rm -f "$OUTPUT_DIR/TC025_clip.y4m"
+if [ $trace_code -eq 0 ]; then
+    python3 - "$OUTPUT_DIR/TC025_trace.json" >> "$trace_log" 2>&1 << 'CHECK'
+import json
+import sys
+
+with open(sys.argv[1]) as f:
+    events = [e for e in json.load(f)['traceEvents'] if e.get('ph') == 'X']
+stages = {'decode': 0, 'detect': 0, 'encode': 0}
+for e in events:
+    stage = 'encode' if e['name'].startswith('encode') else e['name']
+    if stage in stages and 'frame' in e.get('args', {}):
+        stages[stage] += 1
+print('追踪事件: %d, 带帧号的事件: %s' % (len(events), stages))
+sys.exit(0 if all(n > 0 for n in stages.values()) else 1)
+CHECK
+    trace_code=$?
+fi
+if [ $trace_code -eq 0 ]; then
+    echo "✅ 追踪文件为合法JSON，包含带帧号的解码、检测、编码事件"
+    grep "追踪事件:" "$trace_log"
+    passed_tests=$((passed_tests + 1))
+else
+    echo "❌ 逐帧事件追踪测试失败，详见 $trace_log"
+    trace_code=1
+    failed_tests=$((failed_tests + 1))
+fi
+total_tests=$((total_tests + 1))
+
+# 测试用例26：特化前端一致性
+echo "=========================================="
+echo "测试用例26：特化前端一致性"
+echo "=========================================="
+echo "编译期特化的1280x720前端与运行时条带路径对比，直线与掩码差异应在容差内..."
+bench_log="$OUTPUT_DIR/TC026_特化前端一致性_output.log"
+if make bench > "$bench_log" 2>&1; then
+    timeout 300s ./lane_bench --video video_project.mp4 --frames 60 --warmup 0 --reps 1 --stage specializedDetect >> "$bench_log" 2>&1
+    specialized_code=$?
+else
+    specialized_code=1
+fi
+if [ $specialized_code -eq 0 ] && grep -q "特化前端:" "$bench_log"; then
+    echo "✅ 特化前端与运行时路径一致"
+    grep "特化前端:" "$bench_log"
+    passed_tests=$((passed_tests + 1))
+else
+    echo "❌ 特化前端与运行时路径差异超出容差，详见 $bench_log"
+    specialized_code=1
+    failed_tests=$((failed_tests + 1))
+fi
+total_tests=$((total_tests + 1))
+
+# 测试用例27：共享内存检测服务
+echo "=========================================="
+echo "测试用例27：共享内存检测服务"
+echo "=========================================="
+echo "后台启动检测服务，生产者发送60帧并收回60条记录，SIGTERM后共享内存应被删除..."
+serve_log="$OUTPUT_DIR/TC027_共享内存检测服务_output.log"
+serve_code=1
+serve_records=0
+if make producer > "$serve_log" 2>&1; then
+    ./main --serve tc > "$OUTPUT_DIR/TC027_service.log" 2>&1 &
+    serve_pid=$!
+    for i in $(seq 1 50); do
+        [ -e /dev/shm/lane-tc-results ] && break
+        sleep 0.2
+    done
+    timeout 120s ./lane_producer --ring tc --input video_project.mp4 --frames 60 --records "$OUTPUT_DIR/TC027_records.csv" >> "$serve_log" 2>&1
+    serve_code=$?
+    serve_records=$(tail -n +2 "$OUTPUT_DIR/TC027_records.csv" 2>/dev/null | wc -l)
+    kill -TERM $serve_pid 2>/dev/null
+    wait $serve_pid
+    cat "$OUTPUT_DIR/TC027_service.log" >> "$serve_log"
+fi
+serve_leftover=$(ls /dev/shm/lane-tc-* 2>/dev/null | wc -l)
+if [ $serve_code -eq 0 ] && [ "$serve_records" -eq 60 ] && [ "$serve_leftover" -eq 0 ]; then
+    echo "✅ 检测服务返回 $serve_records 条记录并确认输入结束，退出后共享内存已删除"
+    grep "往返延迟" "$serve_log"
+    passed_tests=$((passed_tests + 1))
+else
+    echo "❌ 共享内存检测服务测试失败 (退出码 $serve_code, 记录 $serve_records, 残留 $serve_leftover)，详见 $serve_log"
+    serve_code=1
+    rm -f /dev/shm/lane-tc-*
+    failed_tests=$((failed_tests + 1))
+fi
+total_tests=$((total_tests + 1))
+
 # 生成测试报告
 echo "=========================================="
 echo "功能测试结果汇总"
@@ -196,6 +710,27 @@ cat > "$OUTPUT_DIR/functional_test_report.txt" << EOF
 4. TC004_边缘检测功能: $(if [ -f "$OUTPUT_DIR/TC001_正常车道线检测_bw.avi" ]; then echo "通过"; else echo "失败"; fi)
 5. TC005_车道线检测功能: $(if [ -f "$OUTPUT_DIR/TC001_正常车道线检测_color.avi" ]; then echo "通过"; else echo "失败"; fi)
 6. TC006_系统稳定性测试: $(if [ $stability_passed -eq 5 ]; then echo "通过"; else echo "失败"; fi)
+7. TC007_融合边缘检测一致性: $(if [ $edge_verify_code -eq 0 ]; then echo "通过"; else echo "失败"; fi)
+8. TC008_稳态零内存分配: $(if [ $alloc_check_code -eq 0 ]; then echo "通过"; else echo "失败"; fi)
+9. TC009_Hough引擎一致性: $(if [ $hough_bench_code -eq 0 ]; then echo "通过"; else echo "失败"; fi)
+10. TC010_车道线跟踪模式: $(if [ $track_code -eq 0 ]; then echo "通过"; else echo "失败"; fi)
+11. TC011_多路视频批处理: $(if [ $batch_code -eq 0 ] && [ "$batch_outputs" -eq 2 ]; then echo "通过"; else echo "失败"; fi)
+12. TC012_车道线数据输出: $(if [ $record_code -eq 0 ]; then echo "通过"; else echo "失败"; fi)
+13. TC013_配置文件加载: $(if [ $config_code -eq 0 ]; then echo "通过"; else echo "失败"; fi)
+14. TC014_多尺度检测: $(if [ $scale_bench_code -eq 0 ] && [ $scale_code -eq 0 ]; then echo "通过"; else echo "失败"; fi)
+15. TC015_鲁棒直线拟合: $(if [ $fit_code -eq 0 ]; then echo "通过"; else echo "失败"; fi)
+16. TC016_实时模式: $(if [ $live_code -eq 0 ]; then echo "通过"; else echo "失败"; fi)
+17. TC017_帧内并行: $(if [ $parallel_code -eq 0 ]; then echo "通过"; else echo "失败"; fi)
+18. TC018_边缘位图: $(if [ $bitmap_code -eq 0 ]; then echo "通过"; else echo "失败"; fi)
+19. TC019_车道线绘制: $(if [ $plot_code -eq 0 ]; then echo "通过"; else echo "失败"; fi)
+20. TC020_结构化日志: $(if [ $log_code -eq 0 ]; then echo "通过"; else echo "失败"; fi)
+21. TC021_Y4M亮度输入: $(if [ $y4m_code -eq 0 ]; then echo "通过"; else echo "失败"; fi)
+22. TC022_帧存储回放: $(if [ $store_code -eq 0 ]; then echo "通过"; else echo "失败"; fi)
+23. TC023_分段并行处理: $(if [ $chunk_code -eq 0 ]; then echo "通过"; else echo "失败"; fi)
+24. TC024_变化检测门控: $(if [ $gate_code -eq 0 ]; then echo "通过"; else echo "失败"; fi)
+25. TC025_逐帧事件追踪: $(if [ $trace_code -eq 0 ]; then echo "通过"; else echo "失败"; fi)
+26. TC026_特化前端一致性: $(if [ $specialized_code -eq 0 ]; then echo "通过"; else echo "失败"; fi)
+27. TC027_共享内存检测服务: $(if [ $serve_code -eq 0 ]; then echo "通过"; else echo "失败"; fi)
 
 输出文件位置: $OUTPUT_DIR/
 EOF
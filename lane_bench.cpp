@@ -0,0 +1,443 @@
+/**
+*@file lane_bench.cpp
+*@brief Reproducible per-stage benchmark of LaneDetector.
+*@brief A fixed set of frames is decoded into memory once and the inputs of every stage are
+*@brief precomputed, so each stage is timed on its own without decoding, encoding or console
+*@brief output in the loop. Every stage runs warmup passes and then repeated timed passes over
+*@brief all frames; the report gives median, min, max and spread of the per-frame time over
+*@brief the repetitions. Built by `make bench`, runs on the target and on x86 Linux (NATIVE=1).
+*@brief Frames of a size LanePipeline is instantiated for also time the compile-time specialized
+*@brief front end against the runtime path of the same algorithm (parallelDetect on one thread in
+*@brief ROI mode with the standard Hough).
+*/
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include "LaneDetector.h"
+#include "FramePipeline.h"
+#include "FrameStore.h"
+#include "LanePipeline.h"
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct BenchConfig
+{
+    std::string video = "video_project.mp4";
+    int frames = 60;            // Frames kept in memory
+    int skip = 0;               // Frames skipped at the start of the video
+    int warmup = 2;             // Untimed passes over all frames
+    int reps = 10;              // Timed passes over all frames
+    int cpu = -1;               // Pin the benchmark thread to this CPU
+    int cv_threads = 1;         // OpenCV worker threads, 1 keeps runs comparable
+    bool roi = false;
+    int scale = 1;              // Coarse-to-fine factor of LaneDetector::setScale
+    LaneDetector::FitMode fit = LaneDetector::FIT_LSQ;
+    LaneDetector::PlotMode plot = LaneDetector::PLOT_SPANS;
+    LaneDetector::HoughMode hough = LaneDetector::HOUGH_OPENCV;
+    std::string filter;         // Only run stages whose name contains this
+    std::string json_path;
+    std::string config_path;
+};
+
+struct StageResult
+{
+    std::string name;
+    std::vector<double> per_frame_ms;   // Mean time per frame of each repetition
+};
+
+// Inputs of every stage for one frame, produced once by the untimed reference chain
+struct FrameInputs
+{
+    cv::Mat frame;
+    cv::Mat denoised;
+    cv::Mat edges;
+    cv::Mat masked;
+    EdgeBitmap bitmap;
+    std::vector<cv::Vec4i> lines;
+    std::vector<std::vector<cv::Vec4i> > left_right_lines;
+    std::vector<cv::Point> lane;
+    std::string turn;
+};
+
+// Masked edges and Hough lines of one frame
+typedef std::function<void(const cv::Mat&, cv::Mat&, std::vector<cv::Vec4i>&)> FrontEnd;
+
+template <class Pipeline>
+FrontEnd makeFrontEnd(LaneDetectorConfig& config)
+{
+    std::shared_ptr<Pipeline> pipeline(new Pipeline());
+    config = Pipeline::config();
+    return [pipeline](const cv::Mat& frame, cv::Mat& masked, std::vector<cv::Vec4i>& lines) {
+        pipeline->detect(frame, masked, lines);
+    };
+}
+
+// The specialized front end for frames of this size, empty if there is no instantiation for it;
+// config receives its tuning for the runtime detector it is compared with
+FrontEnd specializedFrontEnd(cv::Size size, LaneDetectorConfig& config)
+{
+    if (size == LanePipeline720p::size())
+        return makeFrontEnd<LanePipeline720p>(config);
+    if (size == LanePipeline360p::size())
+        return makeFrontEnd<LanePipeline360p>(config);
+    return FrontEnd();
+}
+
+double median(std::vector<double> v)
+{
+    std::sort(v.begin(), v.end());
+    size_t n = v.size();
+    return n == 0 ? 0.0 : (n % 2 ? v[n / 2] : 0.5 * (v[n / 2 - 1] + v[n / 2]));
+}
+
+double stddev(const std::vector<double>& v)
+{
+    if (v.size() < 2)
+        return 0.0;
+    double mean = 0.0;
+    for (double x : v)
+        mean += x;
+    mean /= v.size();
+    double sum = 0.0;
+    for (double x : v)
+        sum += (x - mean) * (x - mean);
+    return std::sqrt(sum / (v.size() - 1));
+}
+
+bool pinThread(int cpu)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+/**
+*@brief Run one stage over all frames: warmup passes, then timed passes
+*@param prepare runs untimed before every call (restores state the stage consumes)
+*@param call is the timed stage call for frame i
+*/
+StageResult runStage(const std::string& name, const BenchConfig& config, int frames,
+                     const std::function<void(int)>& prepare, const std::function<void(int)>& call)
+{
+    StageResult result;
+    result.name = name;
+
+    for (int pass = 0; pass < config.warmup + config.reps; pass++) {
+        double total_ms = 0.0;
+        for (int i = 0; i < frames; i++) {
+            prepare(i);
+            Clock::time_point t0 = Clock::now();
+            call(i);
+            total_ms += std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+        }
+        if (pass >= config.warmup)
+            result.per_frame_ms.push_back(total_ms / frames);
+    }
+    return result;
+}
+
+bool writeJson(const std::string& path, const BenchConfig& config, int frames, const cv::Size& size,
+               const std::vector<StageResult>& results)
+{
+    std::ofstream out(path.c_str());
+    if (!out)
+        return false;
+
+    out << "{\n  \"video\": \"" << config.video << "\",\n  \"frames\": " << frames
+        << ",\n  \"width\": " << size.width << ",\n  \"height\": " << size.height
+        << ",\n  \"warmup\": " << config.warmup << ",\n  \"reps\": " << config.reps
+        << ",\n  \"cpu\": " << config.cpu << ",\n  \"cv_threads\": " << config.cv_threads
+        << ",\n  \"roi\": " << (config.roi ? "true" : "false") << ",\n  \"scale\": " << config.scale
+        << ",\n  \"fit\": \"" << LaneDetector::fitModeName(config.fit) << "\""
+        << ",\n  \"plot\": \"" << LaneDetector::plotModeName(config.plot) << "\""
+        << ",\n  \"hough\": \"" << LaneDetector::houghModeName(config.hough) << "\",\n  \"stages\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const StageResult& r = results[i];
+        const std::vector<double>& v = r.per_frame_ms;
+        out << "    {\"name\": \"" << r.name << "\", \"median_ms\": " << median(v)
+            << ", \"min_ms\": " << *std::min_element(v.begin(), v.end())
+            << ", \"max_ms\": " << *std::max_element(v.begin(), v.end())
+            << ", \"stddev_ms\": " << stddev(v) << ", \"reps_ms\": [";
+        for (size_t k = 0; k < v.size(); k++)
+            out << (k ? ", " : "") << v[k];
+        out << "]}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    return static_cast<bool>(out);
+}
+
+} // namespace
+
+/**
+*@brief Benchmark entry point
+*@param argv[] holds the command line options:
+*@param   --video FILE   input video (default video_project.mp4); a *.frames store is used in place,
+*@param                  without decoding or copying (Y stores skip plotLane, cropped stores imply --roi)
+*@param   --frames N     frames loaded into memory (default 60)
+*@param   --skip N       frames skipped before loading (default 0)
+*@param   --warmup N     untimed passes per stage (default 2)
+*@param   --reps N       timed passes per stage (default 10)
+*@param   --cpu K        pin the benchmark thread to CPU K
+*@param   --cv-threads N OpenCV worker threads (default 1)
+*@param   --roi          crop to the lane trapezoid's bounding box
+*@param   --hough NAME   opencv (default), lane or standard
+*@param   --fit NAME     lsq (default) or huber
+*@param   --plot NAME    spans (default) or opencv
+*@param   --scale N      coarse-to-fine detection on a 1/N image in end_to_end (default 1)
+*@param   --stage NAME   only run stages whose name contains NAME
+*@param   --json FILE    write the results as JSON
+*@param   --config FILE  LaneDetectorConfig overrides
+*@return 0 on success, 1 if the specialized front end disagrees with the runtime path beyond its tolerance
+*/
+int main(int argc, char* argv[])
+{
+    BenchConfig config;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--video") == 0 && i + 1 < argc) {
+            config.video = argv[++i];
+        } else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            config.frames = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--skip") == 0 && i + 1 < argc) {
+            config.skip = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+            config.warmup = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            config.reps = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--cpu") == 0 && i + 1 < argc) {
+            config.cpu = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--cv-threads") == 0 && i + 1 < argc) {
+            config.cv_threads = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--roi") == 0) {
+            config.roi = true;
+        } else if (std::strcmp(argv[i], "--hough") == 0 && i + 1 < argc) {
+            const char* name = argv[++i];
+            config.hough = std::strcmp(name, "lane") == 0 ? LaneDetector::HOUGH_LANE
+                         : std::strcmp(name, "standard") == 0 ? LaneDetector::HOUGH_STANDARD : LaneDetector::HOUGH_OPENCV;
+        } else if (std::strcmp(argv[i], "--fit") == 0 && i + 1 < argc) {
+            config.fit = std::strcmp(argv[++i], "huber") == 0 ? LaneDetector::FIT_HUBER : LaneDetector::FIT_LSQ;
+        } else if (std::strcmp(argv[i], "--plot") == 0 && i + 1 < argc) {
+            config.plot = std::strcmp(argv[++i], "opencv") == 0 ? LaneDetector::PLOT_OPENCV : LaneDetector::PLOT_SPANS;
+        } else if (std::strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+            config.scale = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--stage") == 0 && i + 1 < argc) {
+            config.filter = argv[++i];
+        } else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            config.json_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--config") == 0 && i + 1 < argc) {
+            config.config_path = argv[++i];
+        } else {
+            std::cout << "未知参数: " << argv[i] << std::endl;
+            return -1;
+        }
+    }
+
+    if (config.cpu >= 0 && !pinThread(config.cpu))
+        std::cout << "无法绑定到CPU " << config.cpu << std::endl;
+    cv::setNumThreads(config.cv_threads);
+
+    // 一次性把测试帧读入内存；帧存储直接映射，不解码也不复制（裁剪的帧存储只复制ROI行到整帧中）
+    std::vector<FrameInputs> inputs;
+    FrameStore store;
+    if (FrameStore::isStore(config.video)) {
+        if (!store.open(config.video)) {
+            std::cout << "无法打开帧存储: " << config.video << std::endl;
+            return -1;
+        }
+        for (int i = config.skip; i < store.frames() && static_cast<int>(inputs.size()) < config.frames; i++) {
+            inputs.push_back(FrameInputs());
+            if (store.bandTop() > 0)
+                store.frame(i, inputs.back().frame);
+            else
+                inputs.back().frame = store.frame(i);
+        }
+        if (store.bandTop() > 0)
+            config.roi = true;
+    } else {
+        cv::VideoCapture cap(config.video);
+        if (!cap.isOpened()) {
+            std::cout << "无法打开视频: " << config.video << std::endl;
+            return -1;
+        }
+        cv::Mat frame;
+        for (int i = 0; i < config.skip && cap.read(frame); i++) {
+        }
+        while (static_cast<int>(inputs.size()) < config.frames && cap.read(frame)) {
+            inputs.push_back(FrameInputs());
+            inputs.back().frame = frame.clone();
+        }
+        cap.release();
+    }
+    int n = static_cast<int>(inputs.size());
+    if (n == 0) {
+        std::cout << "视频中没有可用帧" << std::endl;
+        return -1;
+    }
+
+    LaneDetector detector;
+    if (!config.config_path.empty()) {
+        LaneDetectorConfig cfg;
+        if (!cfg.load(config.config_path)) {
+            std::cout << "无法读取配置文件: " << config.config_path << std::endl;
+            return -1;
+        }
+        detector.setConfig(cfg);
+    }
+    detector.setRoiMode(config.roi);
+    detector.setHoughMode(config.hough);
+    detector.setScale(config.scale);
+    detector.setFitMode(config.fit);
+    detector.setPlotMode(config.plot);
+    if (store.isOpened() && store.bandTop() > 0 && detector.laneBounds(store.size()).y - 1 < store.bandTop()) {
+        std::cout << "帧存储的裁剪区域不包含当前配置的车道ROI: " << config.video << std::endl;
+        return -1;
+    }
+
+    // 参考链路：生成每个阶段的输入（不计时）
+    for (FrameInputs& in : inputs) {
+        detector.deNoise(in.frame, in.denoised);
+        detector.edgeDetector(in.denoised, in.edges);
+        detector.mask(in.edges, in.masked);
+        detector.houghLines(in.masked, in.lines);
+        detector.bitmapEdgeDetector(in.frame, in.bitmap);
+        detector.lineSeparation(in.lines, in.left_right_lines);
+        detector.regression(in.left_right_lines, in.frame, in.lane);
+        detector.predictTurn(in.turn);
+    }
+
+    cv::Mat out_mat;
+    cv::Mat scratch;
+    EdgeBitmap out_bitmap;
+    std::vector<cv::Vec4i> out_lines;
+    std::vector<std::vector<cv::Vec4i> > out_lr;
+    std::vector<cv::Point> out_lane;
+    std::string out_turn;
+    cv::Mat edge_frame;
+    cv::Mat edge_bgr;
+    DetectOptions options;
+    // Y帧没有颜色可绘制
+    bool color = inputs[0].frame.channels() == 3;
+    options.plot = color;
+    auto nothing = [](int) {};
+    // 绘制与端到端会改写输入帧，每次调用前先恢复（不计时）
+    auto restore = [&](int i) { inputs[i].frame.copyTo(scratch); };
+    // predictTurn读取回归的结果，先恢复该帧的回归状态（不计时）
+    auto refit = [&](int i) { detector.regression(inputs[i].left_right_lines, inputs[i].frame, out_lane); };
+
+    struct StageSpec
+    {
+        const char* name;
+        std::function<void(int)> prepare;
+        std::function<void(int)> call;
+    };
+    std::vector<StageSpec> stages = {
+        { "deNoise", nothing, [&](int i) { detector.deNoise(inputs[i].frame, out_mat); } },
+        { "edgeDetector", nothing, [&](int i) { detector.edgeDetector(inputs[i].denoised, out_mat); } },
+        { "fusedEdgeDetector", nothing, [&](int i) { detector.fusedEdgeDetector(inputs[i].frame, out_mat); } },
+        { "mask", nothing, [&](int i) { detector.mask(inputs[i].edges, out_mat); } },
+        { "houghLines", nothing, [&](int i) { detector.houghLines(inputs[i].masked, out_lines); } },
+        { "bitmapEdgeDetector", nothing, [&](int i) { detector.bitmapEdgeDetector(inputs[i].frame, out_bitmap); } },
+        { "houghBitmap", nothing, [&](int i) { detector.houghLines(inputs[i].bitmap, out_lines); } },
+        { "lineSeparation", nothing, [&](int i) { detector.lineSeparation(inputs[i].lines, out_lr); } },
+        { "regression", nothing, [&](int i) { detector.regression(inputs[i].left_right_lines, inputs[i].frame, out_lane); } },
+        { "predictTurn", refit, [&](int i) { detector.predictTurn(out_turn); } },
+        { "plotLane", restore, [&](int i) { detector.plotLane(scratch, inputs[i].lane, inputs[i].turn); } },
+        { "end_to_end", restore, [&](int i) { detectFrame(detector, scratch, options, edge_frame, edge_bgr, out_turn); } },
+    };
+
+    // 编译期特化的前端，与同一算法的运行时路径（ROI模式、标准Hough、单线程条带）对比
+    LaneDetectorConfig specialized_config;
+    FrontEnd specialized = specializedFrontEnd(inputs[0].frame.size(), specialized_config);
+    LaneDetector generic;
+    if (specialized) {
+        generic.setConfig(specialized_config);
+        generic.setRoiMode(true);
+        generic.setHoughMode(LaneDetector::HOUGH_STANDARD);
+        generic.setFrameThreads(1);
+        stages.push_back({ "parallelDetect", nothing, [&](int i) { generic.parallelDetect(inputs[i].frame, out_mat, out_lines); } });
+        stages.push_back({ "specializedDetect", nothing, [&](int i) { specialized(inputs[i].frame, out_mat, out_lines); } });
+    }
+
+    std::vector<StageResult> results;
+    for (const StageSpec& s : stages) {
+        if (!config.filter.empty() && std::string(s.name).find(config.filter) == std::string::npos)
+            continue;
+        if (!color && std::strcmp(s.name, "plotLane") == 0)
+            continue;
+        results.push_back(runStage(s.name, config, n, s.prepare, s.call));
+    }
+
+    cv::Size size = inputs[0].frame.size();
+    std::cout << "基准测试: " << config.video << " (" << size.width << "x" << size.height << ", " << n << " 帧)"
+              << ", 预热 " << config.warmup << " 轮, 计时 " << config.reps << " 轮"
+              << ", CPU " << (config.cpu >= 0 ? std::to_string(config.cpu) : std::string("未绑定"))
+              << ", OpenCV线程 " << config.cv_threads << ", Hough " << LaneDetector::houghModeName(config.hough)
+              << (config.roi ? ", ROI" : "") << ", 尺度 1/" << config.scale
+              << ", 拟合 " << LaneDetector::fitModeName(config.fit)
+              << ", 绘制 " << LaneDetector::plotModeName(config.plot) << std::endl;
+    std::cout << std::left << std::setw(20) << "阶段" << std::right << std::setw(12) << "中位数(ms)"
+              << std::setw(12) << "最小(ms)" << std::setw(12) << "最大(ms)" << std::setw(12) << "标准差(ms)" << std::endl;
+    std::cout << std::fixed << std::setprecision(4);
+    for (const StageResult& r : results) {
+        const std::vector<double>& v = r.per_frame_ms;
+        std::cout << std::left << std::setw(20) << r.name << std::right << std::setw(12) << median(v)
+                  << std::setw(12) << *std::min_element(v.begin(), v.end())
+                  << std::setw(12) << *std::max_element(v.begin(), v.end())
+                  << std::setw(12) << stddev(v) << std::endl;
+    }
+
+    // 两条路径的掩码仅在梯形边界上可能相差一个像素：每行最多两端各一个边缘像素不同，
+    // 个别帧的Hough直线可能因此不同，至少90%的帧必须完全相同
+    int status = 0;
+    if (specialized && (config.filter.empty() || std::string("specializedDetect").find(config.filter) != std::string::npos)) {
+        const double min_same = 0.90;
+        cv::Mat generic_mat;
+        std::vector<cv::Vec4i> generic_lines;
+        int same = 0;
+        long differing = 0;
+        long max_differing = 0;
+        for (int i = 0; i < n; i++) {
+            generic.parallelDetect(inputs[i].frame, generic_mat, generic_lines);
+            specialized(inputs[i].frame, out_mat, out_lines);
+            if (generic_mat.size() != out_mat.size()) {
+                differing = -1;
+                break;
+            }
+            differing += cv::countNonZero(generic_mat != out_mat);
+            max_differing += 2L * out_mat.rows;
+            same += generic_lines == out_lines ? 1 : 0;
+        }
+        bool agree = differing >= 0 && differing <= max_differing && same >= min_same * n;
+        std::cout << "特化前端: " << same << "/" << n << " 帧的Hough直线与运行时路径相同 (容差 " << min_same * 100
+                  << "%), 掩码边缘相差 " << differing << " 像素 (容差 " << max_differing << ")"
+                  << (agree ? "" : " -- 超出容差") << std::endl;
+        status = agree ? 0 : 1;
+    }
+
+    if (!config.json_path.empty() && !writeJson(config.json_path, config, n, size, results)) {
+        std::cout << "无法写入结果: " << config.json_path << std::endl;
+        return -1;
+    }
+    return status;
+}
@@ -0,0 +1,223 @@
+/**
+*@file lane_producer.cpp
+*@brief Local producer for the shared-memory detection service (main --serve NAME).
+*@brief Replays a video into the service's frame ring and collects the LaneRecords from its
+*@brief result ring, then reports the round-trip latency (publish to result read) and throughput.
+*@brief Results are drained while the frame ring is full, so the producer never stalls the service.
+*@brief Built by `make producer`, runs on the target and on x86 Linux (NATIVE=1).
+*/
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <opencv2/opencv.hpp>
+#include "FrameSource.h"
+#include "LaneRecord.h"
+#include "LaneService.h"
+#include "PerfStats.h"
+#include "ShmRing.h"
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct ProducerConfig
+{
+    std::string ring = "lane";
+    std::string input = "video_challenge.mp4";
+    std::string records_path;
+    int frames = 0;             // Frames sent, 0 is the whole input
+    bool gray = false;          // Send the Y plane instead of BGR
+    bool pace = false;          // Send at the input frame rate instead of as fast as possible
+};
+
+struct ResultStats
+{
+    long received = 0;
+    long detected = 0;
+    long rejected = 0;
+    bool ended = false;         // The service echoed the end-of-stream message
+    LatencyHistogram round_trip;
+};
+
+int64_t nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+/**
+*@brief Read every result the service has published
+*/
+void drainResults(ShmRing& results, ResultStats& stats, RecordWriter& writer)
+{
+    const ResultMessage* r;
+    while ((r = static_cast<const ResultMessage*>(results.tryAcquireRead())) != nullptr) {
+        if (r->flags & MESSAGE_END_OF_STREAM) {
+            stats.ended = true;
+        } else if (r->flags & MESSAGE_REJECTED) {
+            stats.rejected++;
+        } else {
+            stats.received++;
+            stats.detected += r->record.detected ? 1 : 0;
+            stats.round_trip.record(static_cast<uint64_t>(std::max<int64_t>(0, nowNs() - r->sent_ns)));
+            if (writer.isOpened())
+                writer.write(r->record);
+        }
+        results.releaseRead();
+    }
+}
+
+/**
+*@brief Wait for a free frame slot, reading results meanwhile; nullptr after timeout_ms
+*/
+FrameMessage* acquireFrameSlot(ShmRing& frames, ShmRing& results, ResultStats& stats, RecordWriter& writer,
+                               double timeout_ms, double& blocked_ms)
+{
+    void* slot = frames.tryAcquireWrite();
+    if (slot != nullptr)
+        return static_cast<FrameMessage*>(slot);
+    Clock::time_point t0 = Clock::now();
+    while ((slot = frames.tryAcquireWrite()) == nullptr) {
+        drainResults(results, stats, writer);
+        if (std::chrono::duration<double, std::milli>(Clock::now() - t0).count() > timeout_ms)
+            break;
+        std::this_thread::yield();
+    }
+    blocked_ms += std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    return static_cast<FrameMessage*>(slot);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    ProducerConfig config;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--ring") == 0 && i + 1 < argc) {
+            config.ring = argv[++i];
+        } else if (std::strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
+            config.input = argv[++i];
+        } else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            config.frames = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--gray") == 0) {
+            config.gray = true;
+        } else if (std::strcmp(argv[i], "--pace") == 0) {
+            config.pace = true;
+        } else if (std::strcmp(argv[i], "--records") == 0 && i + 1 < argc) {
+            config.records_path = argv[++i];
+        } else {
+            std::cout << "未知参数: " << argv[i] << std::endl;
+            return -1;
+        }
+    }
+
+    FrameSource source;
+    if (!source.open(config.input)) {
+        std::cout << "无法打开视频文件: " << config.input << std::endl;
+        return -1;
+    }
+    // 服务端按整帧检测，裁剪过的帧存储没有ROI以外的行
+    if (source.bandTop() > 0) {
+        std::cout << "裁剪的帧存储不能发送给检测服务: " << config.input << std::endl;
+        return -1;
+    }
+
+    ShmRing frames;
+    ShmRing results;
+    if (!frames.attach(LaneService::frameRingName(config.ring)) || !results.attach(LaneService::resultRingName(config.ring))) {
+        std::cout << "检测服务未启动: " << LaneService::frameRingName(config.ring) << std::endl;
+        return -1;
+    }
+
+    RecordWriter writer;
+    if (!config.records_path.empty()) {
+        RecordWriter::Format format;
+        if (!RecordWriter::formatFromPath(config.records_path, format) || !writer.open(config.records_path, format)) {
+            std::cout << "无法创建车道线数据文件: " << config.records_path << std::endl;
+            return -1;
+        }
+    }
+
+    // 上一个生产者留下的结果不属于本次输入
+    ResultStats stale;
+    RecordWriter no_writer;
+    drainResults(results, stale, no_writer);
+
+    ResultStats stats;
+    double blocked_ms = 0.0;
+    long sent = 0;
+    long too_large = 0;
+    const double interval_ms = source.fps() > 0 ? 1000.0 / source.fps() : 0.0;
+    Clock::time_point start = Clock::now();
+
+    while ((config.frames == 0 || sent < config.frames) && source.read()) {
+        const cv::Mat& image = config.gray ? source.luma() : source.image();
+
+        size_t row_bytes = image.cols * image.elemSize();
+        if (LaneService::FRAME_DATA_OFFSET + row_bytes * image.rows > frames.slotBytes()) {
+            too_large++;
+            continue;
+        }
+
+        if (config.pace) {
+            Clock::time_point due = start + std::chrono::microseconds(static_cast<long>(sent * interval_ms * 1000.0));
+            std::this_thread::sleep_until(due);
+        }
+
+        FrameMessage* msg = acquireFrameSlot(frames, results, stats, writer, 5000.0, blocked_ms);
+        if (msg == nullptr) {
+            std::cout << "检测服务无响应" << std::endl;
+            break;
+        }
+        uchar* pixels = reinterpret_cast<uchar*>(msg) + LaneService::FRAME_DATA_OFFSET;
+        for (int y = 0; y < image.rows; y++)
+            std::memcpy(pixels + y * row_bytes, image.ptr<uchar>(y), row_bytes);
+        msg->frame = sent;
+        msg->fps = source.fps();
+        msg->width = image.cols;
+        msg->height = image.rows;
+        msg->channels = image.channels();
+        msg->flags = 0;
+        msg->sent_ns = nowNs();
+        frames.commitWrite();
+        sent++;
+
+        drainResults(results, stats, writer);
+    }
+
+    // 结束本路输入，等待服务处理完所有帧
+    FrameMessage* end = acquireFrameSlot(frames, results, stats, writer, 5000.0, blocked_ms);
+    if (end != nullptr) {
+        std::memset(end, 0, sizeof(FrameMessage));
+        end->frame = sent;
+        end->flags = MESSAGE_END_OF_STREAM;
+        end->sent_ns = nowNs();
+        frames.commitWrite();
+        Clock::time_point t0 = Clock::now();
+        while (!stats.ended && std::chrono::duration<double>(Clock::now() - t0).count() < 5.0) {
+            drainResults(results, stats, writer);
+            std::this_thread::yield();
+        }
+    }
+    double elapsed_s = std::chrono::duration<double>(Clock::now() - start).count();
+    writer.close();
+
+    std::cout << "\n生产者统计 (" << LaneService::frameRingName(config.ring) << ", "
+              << frames.capacity() << " 槽, " << (config.gray ? "Y平面" : "原始格式") << ")" << std::endl;
+    std::cout << "├── 发送帧数: " << sent << ", 收到结果: " << stats.received << ", 检测到车道: " << stats.detected
+              << ", 被拒绝: " << stats.rejected << ", 超出槽大小未发送: " << too_large << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "├── 往返延迟(ms): 平均 " << stats.round_trip.meanMs() << ", p50 " << stats.round_trip.percentileMs(50)
+              << ", p95 " << stats.round_trip.percentileMs(95) << ", p99 " << stats.round_trip.percentileMs(99)
+              << ", 最大 " << stats.round_trip.maxMs() << std::endl;
+    std::cout << "├── 吞吐: " << (elapsed_s > 0 ? stats.received / elapsed_s : 0.0) << " 帧/秒, 等待空槽: "
+              << blocked_ms << " ms" << std::endl;
+    std::cout << "└── 结束确认: " << (stats.ended ? "已收到" : "超时") << std::endl;
+    if (writer.records() > 0)
+        std::cout << "车道线数据文件: " << config.records_path << " (" << writer.records() << " 条记录)" << std::endl;
+    return stats.ended ? 0 : 1;
+}
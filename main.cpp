@@ -1,27 +1,669 @@
+#include <cmath>
 #include <iostream>
 #include <string>
 #include <vector>
 #include <opencv2/opencv.hpp>
 #include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
 #include "LaneDetector.h"
+#include "FramePipeline.h"
+#include "FrameSource.h"
+#include "AllocCounter.h"
+#include "BatchRunner.h"
+#include "ChunkRunner.h"
+#include "RealtimeRunner.h"
+#include "LaneService.h"
+#include "Logger.h"
+#include "Tracer.h"
+
+/**
+*@brief Compare the fused edge kernel against the legacy deNoise/edgeDetector chain
+*@param cap is the opened input video
+*@param max_frames is the number of frames to check
+*@return 0 if every instruction set path is bit-exact with the legacy chain, 1 otherwise
+*/
+static int verifyEdgeKernel(cv::VideoCapture& cap, int max_frames)
+{
+    LaneDetector lanedetector;
+    cv::Mat frame;
+    cv::Mat reference;
+    cv::Mat fused;
+    cv::Mat diff;
+    long total_mismatch = 0;
+    int frames = 0;
+
+    while (frames < max_frames && cap.read(frame)) {
+        reference = lanedetector.edgeDetector(lanedetector.deNoise(frame));
+
+        for (int isa = FusedEdgeKernel::ISA_SCALAR; isa <= FusedEdgeKernel::ISA_NEON; isa++) {
+            FusedEdgeKernel::Isa id = static_cast<FusedEdgeKernel::Isa>(isa);
+            if (!FusedEdgeKernel::isaSupported(id))
+                continue;
+            lanedetector.edgeKernel().setIsa(id);
+            fused = lanedetector.fusedEdgeDetector(frame);
+            cv::compare(reference, fused, diff, cv::CMP_NE);
+            int mismatch = cv::countNonZero(diff);
+            if (mismatch > 0)
+                std::cout << "帧 " << frames << " [" << FusedEdgeKernel::isaName(id) << "] 不一致像素: " << mismatch << std::endl;
+            total_mismatch += mismatch;
+        }
+        frames++;
+    }
+
+    std::cout << "融合边缘检测校验: " << frames << " 帧, 不一致像素总数: " << total_mismatch << std::endl;
+    return (frames > 0 && total_mismatch == 0) ? 0 : 1;
+}
+
+/**
+*@brief Count heap allocations of detectFrame on every frame after the first one of its path
+*@brief Frames go through detectFrame with the detector's own workspace, so the path that runs is
+*@brief the one a real stream would take: full detection (fused, bitmap, pyramid or strip kernels),
+*@brief the tracking band once the tracker has locked, and gate hits that reuse the last result.
+*@brief The first frame of each path sizes its buffers and is not counted; every later frame must
+*@brief not allocate. Settings that allocate inside OpenCV or the thread pool (legacy edge path,
+*@brief HoughLinesP, the OpenCV renderer, more than one strip thread) are refused, since a whole-frame
+*@brief count cannot tell those allocations apart. Only a make ALLOC_CHECK=1 build counts operator new;
+*@brief other builds refuse the check.
+*@param cap is the opened input video
+*@param lanedetector is the detector under test, already configured from the command line
+*@param options selects the edge path and the outputs
+*@param max_frames is the number of frames to check, including the warm-up frames
+*@return 0 if no frame allocated in steady state, 1 otherwise, -1 if the check cannot run
+*/
+static int checkAllocations(cv::VideoCapture& cap, LaneDetector& lanedetector, const DetectOptions& options, int max_frames)
+{
+    enum { FULL, BAND, REUSED, PATHS };
+    static const char* names[PATHS] = { "完整检测", "跟踪窄带", "门控复用" };
+    ChangeGate& gate = lanedetector.changeGate();
+    bool enabled[PATHS] = { true, lanedetector.trackingMode(), gate.enabled() };
+    uint64_t counts[PATHS] = { 0 };
+    int path_frames[PATHS] = { 0 };
+    cv::Mat frame;
+    cv::Mat edge_frame;
+    cv::Mat edge_bgr;
+    std::string turn;
+    int frames = 0;
+
+    // 只有 make ALLOC_CHECK=1 构建的程序统计operator new，否则无法断言
+    if (!AllocCounter::countsOperatorNew()) {
+        std::cout << "内存分配检查需要用 make ALLOC_CHECK=1 构建" << std::endl;
+        return -1;
+    }
+
+    // 以下设置在OpenCV或线程池内部分配内存，按整帧统计无法区分
+    const char* unsupported = nullptr;
+    if (options.legacy_edge)
+        unsupported = "--legacy-edge";
+    else if (lanedetector.houghMode() == LaneDetector::HOUGH_OPENCV)
+        unsupported = "--hough opencv";
+    else if (options.plot && lanedetector.plotMode() != LaneDetector::PLOT_SPANS)
+        unsupported = "--plot opencv";
+    else if (lanedetector.frameThreads() > 1)
+        unsupported = "--frame-threads (多于1个线程)";
+    if (unsupported) {
+        std::cout << "内存分配检查不支持 " << unsupported << ": 该设置在OpenCV或线程池内部分配内存" << std::endl;
+        return -1;
+    }
+    AllocCounter::installMatAllocator();
+
+    while (frames < max_frames && cap.read(frame)) {
+        bool band = lanedetector.trackingLocked();
+        uint64_t count;
+        {
+            AllocScope scope;
+            detectFrame(lanedetector, frame, options, edge_frame, edge_bgr, turn);
+            count = scope.count();
+        }
+        int path = gate.enabled() && gate.lastHit() ? REUSED : (band ? BAND : FULL);
+
+        // 每条路径的首帧用于建立该路径的缓冲，不计入
+        if (path_frames[path] > 0)
+            counts[path] += count;
+        path_frames[path]++;
+        frames++;
+    }
+
+    bool ok = true;
+    std::cout << "稳态内存分配检查: " << frames << " 帧 (每条路径首帧预热不计)" << std::endl;
+    for (int i = 0; i < PATHS; i++) {
+        if (!enabled[i])
+            continue;
+        // 已启用但没有稳态帧的路径未被检查到，按失败处理
+        bool covered = path_frames[i] > 1;
+        std::cout << "├── " << names[i] << ": " << path_frames[i] << " 帧, 分配 " << counts[i] << " 次"
+                  << (covered ? "" : " (未覆盖)") << std::endl;
+        if (!covered || counts[i] > 0)
+            ok = false;
+    }
+    std::cout << "结果: " << (ok ? "通过" : "失败") << std::endl;
+    return ok ? 0 : 1;
+}
+
+/**
+*@brief Compare HoughLinesP with the restricted-angle Hough engine on the same masked edge images
+*@brief Two detectors run the same frames, one per Hough implementation, so the regression and
+*@brief turn prediction history of each stays independent. The engine is also run over all
+*@brief angles, where it must return exactly the HoughLinesP segments.
+*@param cap is the opened input video
+*@param options selects the edge path
+*@param roi_mode crops both detectors to the ROI bounding box
+*@param max_frames is the number of frames to compare
+*@return 0 if the full-range engine matched HoughLinesP on every frame, 1 otherwise
+*/
+static int benchHough(cv::VideoCapture& cap, const DetectOptions& options, bool roi_mode, int max_frames)
+{
+    LaneDetector detectors[2];
+    const char* names[2] = { "OpenCV HoughLinesP", "车道角度Hough引擎" };
+    double hough_ms[2] = { 0.0, 0.0 };
+    long line_count[2] = { 0, 0 };
+    long kept_count[2] = { 0, 0 };
+    std::vector<cv::Vec4i> lines[2];
+    std::vector<cv::Vec4i> full_lines;
+    HoughEngine full_engine;
+    std::vector<std::vector<cv::Vec4i> > left_right[2];
+    std::vector<cv::Point> lane[2];
+    std::string turn[2];
+    cv::Mat frame;
+    cv::Mat edges;
+    cv::Mat masked;
+    int frames = 0;
+    int compared = 0;
+    int found_mismatch = 0;
+    int turn_agree = 0;
+    int full_mismatch = 0;
+    double offset_sum = 0.0;
+    double offset_max = 0.0;
+
+    detectors[0].setHoughMode(LaneDetector::HOUGH_OPENCV);
+    detectors[1].setHoughMode(LaneDetector::HOUGH_LANE);
+    for (int d = 0; d < 2; d++)
+        detectors[d].setRoiMode(roi_mode);
+    full_engine.setFullRange();
+
+    while (frames < max_frames && cap.read(frame)) {
+        if (options.legacy_edge)
+            detectors[0].edgeDetector(detectors[0].deNoise(frame), edges);
+        else
+            detectors[0].fusedEdgeDetector(frame, edges);
+        detectors[0].mask(edges, masked);
+        detectors[1].roi(frame.size());
+
+        for (int d = 0; d < 2; d++) {
+            std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+            detectors[d].houghLines(masked, lines[d]);
+            hough_ms[d] += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            line_count[d] += lines[d].size();
+
+            if (!lines[d].empty()) {
+                detectors[d].lineSeparation(lines[d], left_right[d]);
+                kept_count[d] += left_right[d][0].size() + left_right[d][1].size();
+                detectors[d].regression(left_right[d], frame, lane[d]);
+                detectors[d].predictTurn(turn[d]);
+            }
+        }
+
+        // 全角度模式应与HoughLinesP逐条一致（ROI模式下HoughLinesP的结果已平移回整帧坐标）
+        full_engine.detect(masked, full_lines);
+        cv::Point shift = roi_mode ? detectors[0].roi(frame.size()).tl() : cv::Point();
+        bool same = full_lines.size() == lines[0].size();
+        for (size_t k = 0; same && k < full_lines.size(); k++) {
+            same = full_lines[k][0] + shift.x == lines[0][k][0] && full_lines[k][1] + shift.y == lines[0][k][1] &&
+                   full_lines[k][2] + shift.x == lines[0][k][2] && full_lines[k][3] + shift.y == lines[0][k][3];
+        }
+        if (!same)
+            full_mismatch++;
+
+        // 车道端点偏差只在两者都检测到车道线时统计
+        if (lines[0].empty() != lines[1].empty()) {
+            found_mismatch++;
+        } else if (!lines[0].empty()) {
+            double offset = 0.0;
+            for (int k = 0; k < 4; k++)
+                offset = std::max(offset, std::hypot(lane[0][k].x - lane[1][k].x, lane[0][k].y - lane[1][k].y));
+            offset_sum += offset;
+            offset_max = std::max(offset_max, offset);
+            if (turn[0] == turn[1])
+                turn_agree++;
+            compared++;
+        }
+        frames++;
+    }
+
+    std::cout << "Hough实现对比: " << frames << " 帧" << (roi_mode ? " (ROI模式)" : "") << std::endl;
+    for (int d = 0; d < 2; d++) {
+        std::cout << "├── " << names[d] << ": " << (frames > 0 ? hough_ms[d] / frames : 0.0) << " ms/帧, 平均线段 "
+                  << (frames > 0 ? static_cast<double>(line_count[d]) / frames : 0.0) << ", 线分离后保留 "
+                  << (frames > 0 ? static_cast<double>(kept_count[d]) / frames : 0.0) << std::endl;
+    }
+    std::cout << "├── 加速比: " << (hough_ms[1] > 0 ? hough_ms[0] / hough_ms[1] : 0.0) << "x" << std::endl;
+    std::cout << "├── 投票角度: " << detectors[1].houghEngine().angleBins() << "/" << detectors[1].houghEngine().totalAngleBins() << std::endl;
+    std::cout << "├── 车道端点偏差: 平均 " << (compared > 0 ? offset_sum / compared : 0.0) << " px, 最大 " << offset_max << " px" << std::endl;
+    std::cout << "├── 转向预测一致: " << turn_agree << "/" << compared << std::endl;
+    std::cout << "├── 仅一方检测到线段的帧: " << found_mismatch << std::endl;
+    std::cout << "└── 全角度模式与HoughLinesP不一致的帧: " << full_mismatch << std::endl;
+    return (frames > 0 && full_mismatch == 0) ? 0 : 1;
+}
+
+/**
+*@brief Accuracy versus speed of the coarse-to-fine mode against the full-resolution path
+*@brief One detector per scale (1, 2, 3, 4) runs detectFrame on the same frames without plotting;
+*@brief the lane endpoints and turn of every coarse scale are compared with scale 1
+*@param cap is the opened input video
+*@param settings configures every detector (the scale is overridden)
+*@param options selects the edge path of the full-resolution detector
+*@param max_frames is the number of frames to compare
+*@return 0 if any frame was processed, 1 otherwise
+*/
+static int benchScale(cv::VideoCapture& cap, const StreamSettings& settings, DetectOptions options, int max_frames)
+{
+    const int scales = 4;
+    LaneDetector detectors[scales];
+    double detect_ms[scales] = {};
+    int found[scales] = {};
+    int compared[scales] = {};
+    int found_mismatch[scales] = {};
+    int turn_agree[scales] = {};
+    double offset_sum[scales] = {};
+    double offset_max[scales] = {};
+    std::string turn[scales];
+    cv::Mat edge_frame;
+    cv::Mat edge_bgr;
+    cv::Mat frame;
+    int frames = 0;
+
+    options.plot = false;
+    options.edge_image = false;
+    for (int d = 0; d < scales; d++) {
+        settings.apply(detectors[d]);
+        detectors[d].setScale(d + 1);
+    }
+
+    while (frames < max_frames && cap.read(frame)) {
+        int flag[scales];
+        for (int d = 0; d < scales; d++) {
+            std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+            flag[d] = detectFrame(detectors[d], frame, options, edge_frame, edge_bgr, turn[d]);
+            detect_ms[d] += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            if (flag[d] == 0)
+                found[d]++;
+        }
+
+        // 车道端点偏差只在两者都检测到车道线时统计
+        const std::vector<cv::Point>& ref = detectors[0].workspace().lane;
+        for (int d = 1; d < scales; d++) {
+            if ((flag[0] == 0) != (flag[d] == 0)) {
+                found_mismatch[d]++;
+            } else if (flag[0] == 0) {
+                const std::vector<cv::Point>& lane = detectors[d].workspace().lane;
+                double offset = 0.0;
+                for (int k = 0; k < 4; k++)
+                    offset = std::max(offset, std::hypot(ref[k].x - lane[k].x, ref[k].y - lane[k].y));
+                offset_sum[d] += offset;
+                offset_max[d] = std::max(offset_max[d], offset);
+                if (turn[0] == turn[d])
+                    turn_agree[d]++;
+                compared[d]++;
+            }
+        }
+        frames++;
+    }
+
+    std::cout << "多尺度检测对比: " << frames << " 帧" << (settings.roi ? " (ROI模式)" : "") << std::endl;
+    for (int d = 0; d < scales; d++) {
+        double ms = frames > 0 ? detect_ms[d] / frames : 0.0;
+        std::cout << (d + 1 < scales ? "├── " : "└── ") << "1/" << d + 1 << " 尺度: " << ms << " ms/帧";
+        if (d == 0) {
+            std::cout << ", 检测到车道线 " << found[d] << " 帧 (基准)" << std::endl;
+            continue;
+        }
+        std::cout << ", 加速比 " << (detect_ms[d] > 0 ? detect_ms[0] / detect_ms[d] : 0.0) << "x"
+                  << ", 端点偏差 平均 " << (compared[d] > 0 ? offset_sum[d] / compared[d] : 0.0)
+                  << " px / 最大 " << offset_max[d] << " px"
+                  << ", 转向一致 " << turn_agree[d] << "/" << compared[d]
+                  << ", 检测结果不一致 " << found_mismatch[d] << " 帧" << std::endl;
+    }
+    return frames > 0 ? 0 : 1;
+}
+
+/**
+*@brief Single-frame latency of the strip-parallel path on 1 to 4 threads
+*@brief Detectors with the serial stages and with 1, 2, 3 and 4 strip threads run detectFrame on
+*@brief the same frames with the same Hough mode, without plotting. The strips produce the masked
+*@brief edge image of the serial stages and the Hough runs in the configured mode (standard Hough
+*@brief merges per-strip accumulators that do not depend on the split), so every thread count must
+*@brief give exactly the serial lines, lane and turn.
+*@param cap is the opened input video
+*@param settings configures every detector (tracking and scale are turned off)
+*@param max_frames is the number of frames to compare
+*@return 0 if every thread count matched the serial stages on every frame, 1 otherwise
+*/
+static int benchParallel(cv::VideoCapture& cap, StreamSettings settings, int max_frames)
+{
+    const int configs = 5;      // 串行阶段 + 1..4 线程条带并行
+    LaneDetector detectors[configs];
+    LatencyHistogram latency[configs];
+    DetectOptions options;
+    cv::Mat edge_frame;
+    cv::Mat edge_bgr;
+    cv::Mat frame;
+    std::string turn[configs];
+    int frames = 0;
+    int mismatches[configs] = { 0 };
+
+    options.plot = false;
+    options.edge_image = false;
+    settings.track = false;
+    settings.scale = 1;
+    for (int d = 0; d < configs; d++) {
+        settings.frame_threads = d;
+        settings.apply(detectors[d]);
+    }
+
+    while (frames < max_frames && cap.read(frame)) {
+        int flag[configs];
+        for (int d = 0; d < configs; d++) {
+            std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+            flag[d] = detectFrame(detectors[d], frame, options, edge_frame, edge_bgr, turn[d]);
+            latency[d].record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count());
+        }
+
+        // 条带路径与串行阶段使用同一Hough实现，线段、车道线与转向应完全一致
+        const FrameWorkspace& serial = detectors[0].workspace();
+        for (int d = 1; d < configs; d++) {
+            const FrameWorkspace& work = detectors[d].workspace();
+            bool same = flag[d] == flag[0] && work.lines == serial.lines;
+            if (same && flag[0] == 0)
+                same = work.lane == serial.lane && turn[d] == turn[0];
+            if (!same) {
+                std::cout << "帧 " << frames << " [" << d << " 线程] 结果与串行阶段不一致" << std::endl;
+                mismatches[d]++;
+            }
+        }
+        frames++;
+    }
+
+    std::cout << "帧内并行扩展性: " << frames << " 帧, 硬件线程 " << std::thread::hardware_concurrency()
+              << ", Hough " << LaneDetector::houghModeName(settings.hough) << std::endl;
+    bool ok = frames > 0;
+    for (int d = 0; d < configs; d++) {
+        std::cout << (d + 1 < configs ? "├── " : "└── ");
+        if (d == 0)
+            std::cout << "串行阶段";
+        else
+            std::cout << d << " 线程条带";
+        std::cout << ": 平均 " << latency[d].meanMs() << " ms, p50 " << latency[d].percentileMs(50)
+                  << " ms, p95 " << latency[d].percentileMs(95) << " ms";
+        if (d > 1)
+            std::cout << ", 相对1线程加速 " << (latency[d].meanMs() > 0 ? latency[1].meanMs() / latency[d].meanMs() : 0.0) << "x";
+        if (d > 0)
+            std::cout << ", 与串行不一致 " << mismatches[d] << " 帧";
+        std::cout << std::endl;
+        if (mismatches[d] > 0)
+            ok = false;
+    }
+    return ok ? 0 : 1;
+}
+
+/**
+*@brief Packed 1-bit edge bitmap against the byte edge image and mask
+*@brief The byte path runs fusedEdgeDetector, mask and houghLines in ROI mode, the bitmap path
+*@brief bitmapEdgeDetector and houghLines on the bitmap, on the same frames; both see the same
+*@brief edge points in the same order, so the lines must be identical
+*@param cap is the opened input video
+*@param settings configures both detectors (ROI mode on, the other modes off)
+*@param max_frames is the number of frames to compare
+*@return 0 if the lines of every frame matched, 1 otherwise
+*/
+static int benchBitmap(cv::VideoCapture& cap, StreamSettings settings, int max_frames)
+{
+    LaneDetector byte_detector;
+    LaneDetector bitmap_detector;
+    FrameWorkspace& byte_work = byte_detector.workspace();
+    FrameWorkspace& bitmap_work = bitmap_detector.workspace();
+    double edge_ms[2] = {};
+    double hough_ms[2] = {};
+    long edge_points = 0;
+    cv::Mat frame;
+    int frames = 0;
+    int mismatches = 0;
+
+    settings.roi = true;
+    settings.track = false;
+    settings.scale = 1;
+    settings.frame_threads = 0;
+    settings.bitmap = false;
+    settings.apply(byte_detector);
+    settings.bitmap = true;
+    settings.apply(bitmap_detector);
+
+    typedef std::chrono::steady_clock Clock;
+    auto msSince = [](Clock::time_point t0) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    };
+
+    while (frames < max_frames && cap.read(frame)) {
+        Clock::time_point t0 = Clock::now();
+        byte_detector.fusedEdgeDetector(frame, byte_work.edges);
+        byte_detector.mask(byte_work.edges, byte_work.masked);
+        edge_ms[0] += msSince(t0);
+        t0 = Clock::now();
+        byte_detector.houghLines(byte_work.masked, byte_work.lines);
+        hough_ms[0] += msSince(t0);
+
+        t0 = Clock::now();
+        bitmap_detector.bitmapEdgeDetector(frame, bitmap_work.bitmap);
+        edge_ms[1] += msSince(t0);
+        t0 = Clock::now();
+        bitmap_detector.houghLines(bitmap_work.bitmap, bitmap_work.lines);
+        hough_ms[1] += msSince(t0);
+        edge_points += static_cast<long>(bitmap_work.bitmap.points().size());
+
+        const std::vector<cv::Vec4i>& ref = byte_work.lines;
+        const std::vector<cv::Vec4i>& lines = bitmap_work.lines;
+        bool same = lines.size() == ref.size();
+        for (size_t k = 0; same && k < ref.size(); k++)
+            same = lines[k] == ref[k];
+        if (!same) {
+            std::cout << "帧 " << frames << " 位图与字节图像的线段不一致" << std::endl;
+            mismatches++;
+        }
+        frames++;
+    }
+
+    // 字节路径每帧写边缘图和掩码结果，读掩码图；位图路径只写位图和边缘点
+    size_t image_bytes = byte_work.masked.total();
+    size_t bitmap_bytes = bitmap_work.bitmap.bytes();
+    double n = std::max(frames, 1);
+    std::cout << "位图边缘表示对比: " << frames << " 帧, 区域 " << bitmap_work.bitmap.size().width << "x"
+              << bitmap_work.bitmap.size().height << std::endl;
+    std::cout << "├── 边缘图存储: 字节 " << image_bytes / 1024.0 << " KB (另有同尺寸掩码图), 位图 "
+              << bitmap_bytes / 1024.0 << " KB" << std::endl;
+    std::cout << "├── 平均边缘点: " << edge_points / n << " 个 (" << edge_points / n * sizeof(cv::Point) / 1024.0 << " KB)" << std::endl;
+    std::cout << "├── 边缘+掩码: 字节 " << edge_ms[0] / n << " ms, 位图 " << edge_ms[1] / n << " ms, 加速比 "
+              << (edge_ms[1] > 0 ? edge_ms[0] / edge_ms[1] : 0.0) << "x" << std::endl;
+    std::cout << "├── Hough: 字节 " << hough_ms[0] / n << " ms, 位图 " << hough_ms[1] / n << " ms, 加速比 "
+              << (hough_ms[1] > 0 ? hough_ms[0] / hough_ms[1] : 0.0) << "x" << std::endl;
+    std::cout << "└── 线段不一致帧数: " << mismatches << std::endl;
+    return (frames > 0 && mismatches == 0) ? 0 : 1;
+}
+
+/**
+*@brief Span renderer against the OpenCV plotLane on the same lanes
+*@brief Every frame is detected once without plotting; the lane is then drawn by both renderers
+*@brief into copies of the frame, which are timed and compared pixel by pixel. The statistics
+*@brief cover only the bounding box of the pixels either renderer changed (lane polygon, lines
+*@brief and label), so the untouched rest of the frame does not dilute them
+*@param cap is the opened input video
+*@param settings configures the detector
+*@param max_frames is the number of frames to compare
+*@return 0 if lanes were drawn, the mean difference in the box stays below one gray level and at
+*@return most 2% of its pixels differ by more than 16, 1 otherwise
+*/
+static int benchPlot(cv::VideoCapture& cap, const StreamSettings& settings, int max_frames)
+{
+    LaneDetector detector;
+    FrameWorkspace& work = detector.workspace();
+    DetectOptions options;
+    cv::Mat frame;
+    cv::Mat drawn[2];
+    cv::Mat edge_frame;
+    cv::Mat edge_bgr;
+    std::string turn;
+    LatencyHistogram latency[2];
+    double diff_sum = 0.0;
+    int diff_max = 0;
+    long diff_pixels = 0;       // Pixels where a channel differs by more than 16
+    long total_pixels = 0;      // Pixels in the drawn bounding boxes
+    const double max_diff_share = 0.02;     // 抗锯齿边缘处允许的差异像素比例
+    int frames = 0;
+    int plotted = 0;
+    const LaneDetector::PlotMode modes[2] = { LaneDetector::PLOT_OPENCV, LaneDetector::PLOT_SPANS };
+
+    options.plot = false;
+    options.edge_image = false;
+    settings.apply(detector);
+
+    while (frames < max_frames && cap.read(frame)) {
+        frames++;
+        if (detectFrame(detector, frame, options, edge_frame, edge_bgr, turn) != 0)
+            continue;
+
+        for (int m = 0; m < 2; m++) {
+            frame.copyTo(drawn[m]);
+            detector.setPlotMode(modes[m]);
+            std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+            detector.plotLane(drawn[m], work.lane, turn);
+            latency[m].record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count());
+        }
+
+        // 只统计任一绘制方式改动过的像素的外接矩形；矩形外两者都与原帧相同，差异为0
+        int x_min = frame.cols;
+        int x_max = -1;
+        int y_min = frame.rows;
+        int y_max = -1;
+        for (int y = 0; y < frame.rows; y++) {
+            const uchar* a = drawn[0].ptr<uchar>(y);
+            const uchar* b = drawn[1].ptr<uchar>(y);
+            const uchar* src = frame.ptr<uchar>(y);
+            for (int x = 0; x < frame.cols; x++) {
+                int d = 0;
+                bool changed = false;
+                for (int k = 0; k < 3; k++) {
+                    d = std::max(d, std::abs(a[3 * x + k] - b[3 * x + k]));
+                    changed = changed || a[3 * x + k] != src[3 * x + k] || b[3 * x + k] != src[3 * x + k];
+                }
+                if (changed) {
+                    x_min = std::min(x_min, x);
+                    x_max = std::max(x_max, x);
+                    y_min = std::min(y_min, y);
+                    y_max = std::max(y_max, y);
+                }
+                diff_sum += d;
+                diff_max = std::max(diff_max, d);
+                if (d > 16)
+                    diff_pixels++;
+            }
+        }
+        if (x_max < 0)
+            continue;
+        total_pixels += static_cast<long>(x_max - x_min + 1) * (y_max - y_min + 1);
+        plotted++;
+    }
+
+    double mean_diff = total_pixels > 0 ? diff_sum / total_pixels : 0.0;
+    std::cout << "车道线绘制对比: " << frames << " 帧, 绘制 " << plotted << " 帧" << std::endl;
+    for (int m = 0; m < 2; m++) {
+        std::cout << "├── " << LaneDetector::plotModeName(modes[m]) << ": 平均 " << latency[m].meanMs()
+                  << " ms, p50 " << latency[m].percentileMs(50) << " ms, p95 " << latency[m].percentileMs(95) << " ms" << std::endl;
+    }
+    std::cout << "├── 加速比: " << (latency[1].meanMs() > 0 ? latency[0].meanMs() / latency[1].meanMs() : 0.0) << "x" << std::endl;
+    double diff_share = total_pixels > 0 ? static_cast<double>(diff_pixels) / total_pixels : 0.0;
+    std::cout << "└── 绘制区域像素差异: 平均 " << mean_diff << ", 最大 " << diff_max << ", 差异>16的像素 "
+              << 100.0 * diff_share << "% (容差 " << 100.0 * max_diff_share << "%)" << std::endl;
+    return (plotted > 0 && mean_diff < 1.0 && diff_share <= max_diff_share) ? 0 : 1;
+}
 
 /**
 *@brief Function main that runs the main algorithm of the lane detection.
 *@brief It will read a video of a car in the highway and it will output the
 *@brief same video but with the plotted detected lane
-*@param argv[] is a string to the full path of the demo video
+*@param argv[] holds the command line options:
+*@param   --legacy-edge     use the original deNoise + edgeDetector chain
+*@param   --edge-isa NAME   force the fused kernel to auto|scalar|sse2|avx2|neon; an ISA this CPU lacks is refused
+*@param   --roi             crop to the lane trapezoid's bounding box before denoising
+*@param   --pipeline        run decode, detection and both encoders on separate threads
+*@param   --queue-depth N   slots per pipeline queue (default 4, implies --pipeline)
+*@param   --perf-json FILE  write per-stage latency statistics (p50/p95/p99/max) as JSON
+*@param   --perf-csv FILE   write the same statistics as CSV
+*@param   --verify-edge N   check the fused kernel against the legacy chain on N frames and exit
+*@param   --track           smooth the lane across frames and search only narrow bands once locked
+*@param   --hough NAME      Hough implementation: opencv (default, HoughLinesP), lane (restricted angles)
+*@param                     or standard (standard transform over the lane angles, voted per strip with
+*@param                     --frame-threads)
+*@param   --hough-bench N   compare both Hough implementations on N frames and exit
+*@param   --fit NAME        line fit of regression: lsq (default, length-weighted least squares) or huber
+*@param   --alloc-check N   count detectFrame heap allocations on N frames after each path's first frame and exit
+*@param                     (needs a make ALLOC_CHECK=1 build)
+*@param   --input FILE      input video (default video_challenge.mp4); repeat it to run a batch
+*@param                     *.y4m and "gst:<pipeline>" (appsink format=I420/NV12/GRAY8) inputs are
+*@param                     detected on the decoder's luma plane, BGR is only converted for plotting
+*@param   --to-y4m FILE     convert the input to Y4M 4:2:0 (the luma input for testing) and exit
+*@param   --y4m-frames N    convert at most N frames with --to-y4m (default: all)
+*@param   --to-store FILE   convert the input once into a memory-mapped raw frame store (*.frames) and
+*@param                     exit; replaying it with --input FILE skips decoding entirely
+*@param   --store-bgr       store BGR frames (default: the Y plane only)
+*@param   --store-crop      store only the rows of the lane ROI; the store then runs in ROI mode
+*@param   --store-frames N  convert at most N frames with --to-store (default: all)
+*@param   --manifest FILE   batch input list, one video path per line
+*@param   --threads N       batch worker threads (default: one per hardware thread)
+*@param   --output-dir DIR  batch output directory (default batch_output)
+*@param   --batch-csv FILE  write the per-stream batch results as CSV
+*@param   --chunks N        split the single input at keyframes into N chunks (0: two per worker) decoded
+*@param                     and detected in parallel on --threads workers; only records are written
+*@param   --chunk-warmup N  frames each chunk replays before its start to rebuild the tracked state (default 30)
+*@param   --chunk-check     also run the clip sequentially and count frames whose result differs
+*@param   --outputs LIST    comma separated outputs: color, edge, record (default color,edge)
+*@param   --scale N         coarse-to-fine detection on a 1/N downsampled image (N = 1..4, default 1)
+*@param   --scale-bench N   compare every scale with full resolution on N frames and exit
+*@param   --live            real-time mode: replay the input at its frame rate, always detect on the
+*@param                     newest frame, drop stale ones and degrade when over the latency budget
+*@param   --camera N        real-time mode on capture device N (e.g. /dev/videoN through V4L2)
+*@param   --budget MS       capture-to-decision deadline of the real-time mode (default one frame interval)
+*@param   --live-frames N   stop the real-time mode after N processed frames (default: until the source ends)
+*@param   --frame-threads N split edge detection and mask of each frame over N threads (and the Hough
+*@param                     voting with --hough standard)
+*@param   --parallel-bench N single-frame latency of the strip-parallel path on 1-4 threads over N frames, then exit
+*@param   --bitmap          pack the masked edges into a 1-bit bitmap and run Hough over its edge points
+*@param   --bitmap-bench N  compare the bitmap with the byte edge image and mask on N frames and exit
+*@param   --plot NAME       lane renderer: spans (default, in-place span blending) or opencv
+*@param   --plot-bench N    compare both lane renderers on N frames and exit
+*@param   --config FILE     load LaneDetectorConfig overrides (YAML/JSON/XML)
+*@param   --gate T          reuse the last lane/turn while the lane area differs from the last detected frame
+*@param                     by less than T gray levels (mean absolute difference), 0 off (default)
+*@param   --gate-max N      detect at least every N+1 frames while the gate is on (default 5)
+*@param   --record FILE     write per-frame lane records to FILE (.csv, .ndjson or .bin), implies record
+*@param   --log FILE        per-frame [FRAME] lines and messages to FILE (default: stdout), written by a background thread
+*@param   --log-level NAME  lowest level logged: debug, info (default), warn, error or off
+*@param   --log-rate N      at most N log lines per second below error (default 0, unlimited)
+*@param   --trace FILE      write a Chrome trace (JSON, opens in Perfetto) of every stage, decode, encode
+*@param                     and queue wait per frame and thread of the serial, pipeline or live run
+*@param   --trace-events N  trace events kept per thread, the oldest are overwritten (default 65536)
+*@param   --serve NAME      run as a detection service: frames arrive in the shared-memory ring
+*@param                     /lane-NAME-frames (see lane_producer), records go back through /lane-NAME-results;
+*@param                     runs until SIGINT/SIGTERM
+*@param   --serve-slots N   slots per service ring (default 4)
+*@param   --serve-max WxH   largest frame a producer may send (default 1280x720)
 *@return flag_plot tells if the demo has sucessfully finished
 */
-int main() 
+int main(int argc, char* argv[]) 
 {
     LaneDetector lanedetector;  // 定义车道线检测对象
     cv::Mat frame;
-    cv::Mat img_denoise;
-    cv::Mat img_edges;
-    cv::Mat img_mask;
-    std::vector<cv::Vec4i> lines;
-    std::vector<std::vector<cv::Vec4i> > left_right_lines;
-    std::vector<cv::Point> lane;
+    cv::Mat edge_frame;         // ROI模式下用于把边缘图贴回整帧
+    cv::Mat edge_3channel;
     std::string turn;
     int flag_plot = -1;         // 返回值
 
@@ -30,112 +672,543 @@ int main()
     std::chrono::high_resolution_clock::time_point total_end_time;
     double total_processing_time = 0.0;
     int total_frames_processed = 0;
+    double gate_hit_ms = 0.0;       // 复用结果的帧的检测耗时
+    double gate_full_ms = 0.0;      // 完整检测的帧的检测耗时
 
-    // 打开测试视频文件
-    cv::VideoCapture cap("video_challenge.mp4");
-    if (!cap.isOpened())
+    // 命令行参数
+    DetectOptions detect_options;
+    bool use_pipeline = false;
+    int queue_depth = 4;
+    int verify_edge_frames = 0;
+    int alloc_check_frames = 0;
+    int hough_bench_frames = 0;
+    int scale_bench_frames = 0;
+    int parallel_bench_frames = 0;
+    int bitmap_bench_frames = 0;
+    int plot_bench_frames = 0;
+    std::string perf_json_path;
+    std::string perf_csv_path;
+    StreamSettings settings;
+    std::vector<std::string> inputs;
+    std::string manifest_path;
+    int batch_threads = 0;
+    std::string output_dir = "batch_output";
+    std::string batch_csv_path;
+    OutputSelection outputs;
+    std::string record_path;
+    bool live = false;
+    int camera = -1;
+    double budget_ms = 0.0;
+    int live_frames = 0;
+    std::string log_path = "-";
+    LogLevel log_level = LOG_INFO;
+    int log_rate = 0;
+    std::string y4m_path;
+    int y4m_frames = 0;
+    int chunk_count = -1;
+    int chunk_warmup = 30;
+    bool chunk_check = false;
+    std::string store_path;
+    bool store_bgr = false;
+    bool store_crop = false;
+    int store_frames = 0;
+    std::string trace_path;
+    int trace_events = 1 << 16;
+    std::string serve_name;
+    int serve_slots = 4;
+    cv::Size serve_max(1280, 720);
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--legacy-edge") == 0) {
+            detect_options.legacy_edge = true;
+        } else if (std::strcmp(argv[i], "--pipeline") == 0) {
+            use_pipeline = true;
+        } else if (std::strcmp(argv[i], "--queue-depth") == 0 && i + 1 < argc) {
+            use_pipeline = true;
+            queue_depth = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--roi") == 0) {
+            settings.roi = true;
+        } else if (std::strcmp(argv[i], "--track") == 0) {
+            settings.track = true;
+        } else if (std::strcmp(argv[i], "--perf-json") == 0 && i + 1 < argc) {
+            perf_json_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--perf-csv") == 0 && i + 1 < argc) {
+            perf_csv_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--verify-edge") == 0 && i + 1 < argc) {
+            verify_edge_frames = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--hough") == 0 && i + 1 < argc) {
+            const char* name = argv[++i];
+            if (std::strcmp(name, "opencv") == 0) {
+                settings.hough = LaneDetector::HOUGH_OPENCV;
+            } else if (std::strcmp(name, "lane") == 0) {
+                settings.hough = LaneDetector::HOUGH_LANE;
+            } else if (std::strcmp(name, "standard") == 0) {
+                settings.hough = LaneDetector::HOUGH_STANDARD;
+            } else {
+                std::cout << "未知Hough实现: " << name << std::endl;
+                return -1;
+            }
+        } else if (std::strcmp(argv[i], "--fit") == 0 && i + 1 < argc) {
+            const char* name = argv[++i];
+            if (std::strcmp(name, "huber") == 0) {
+                settings.fit = LaneDetector::FIT_HUBER;
+            } else if (std::strcmp(name, "lsq") == 0) {
+                settings.fit = LaneDetector::FIT_LSQ;
+            } else {
+                std::cout << "未知拟合方式: " << name << std::endl;
+                return -1;
+            }
+        } else if (std::strcmp(argv[i], "--hough-bench") == 0 && i + 1 < argc) {
+            hough_bench_frames = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--alloc-check") == 0 && i + 1 < argc) {
+            alloc_check_frames = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--edge-isa") == 0 && i + 1 < argc) {
+            const char* name = argv[++i];
+            int found = -1;
+            for (int isa = FusedEdgeKernel::ISA_AUTO; isa <= FusedEdgeKernel::ISA_NEON; isa++) {
+                if (std::strcmp(name, FusedEdgeKernel::isaName(static_cast<FusedEdgeKernel::Isa>(isa))) == 0)
+                    found = isa;
+            }
+            if (found < 0) {
+                std::cout << "未知边缘检测指令集: " << name << std::endl;
+                return -1;
+            }
+            // 不支持时setIsa会退回标量实现，强制指定时直接拒绝，避免误测标量版本
+            if (!FusedEdgeKernel::isaSupported(static_cast<FusedEdgeKernel::Isa>(found))) {
+                std::cout << "本机不支持边缘检测指令集: " << name << std::endl;
+                return -1;
+            }
+            settings.isa = static_cast<FusedEdgeKernel::Isa>(found);
+        } else if (std::strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
+            inputs.push_back(argv[++i]);
+        } else if (std::strcmp(argv[i], "--to-y4m") == 0 && i + 1 < argc) {
+            y4m_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--y4m-frames") == 0 && i + 1 < argc) {
+            y4m_frames = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--to-store") == 0 && i + 1 < argc) {
+            store_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--store-bgr") == 0) {
+            store_bgr = true;
+        } else if (std::strcmp(argv[i], "--store-crop") == 0) {
+            store_crop = true;
+        } else if (std::strcmp(argv[i], "--store-frames") == 0 && i + 1 < argc) {
+            store_frames = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--manifest") == 0 && i + 1 < argc) {
+            manifest_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            batch_threads = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--output-dir") == 0 && i + 1 < argc) {
+            output_dir = argv[++i];
+        } else if (std::strcmp(argv[i], "--chunks") == 0 && i + 1 < argc) {
+            chunk_count = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--chunk-warmup") == 0 && i + 1 < argc) {
+            chunk_warmup = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--chunk-check") == 0) {
+            chunk_check = true;
+        } else if (std::strcmp(argv[i], "--batch-csv") == 0 && i + 1 < argc) {
+            batch_csv_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--outputs") == 0 && i + 1 < argc) {
+            if (!outputs.parse(argv[++i])) {
+                std::cout << "未知输出类型: " << argv[i] << std::endl;
+                return -1;
+            }
+        } else if (std::strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+            settings.scale = std::atoi(argv[++i]);
+            if (settings.scale < 1 || settings.scale > 4) {
+                std::cout << "缩放倍数须为1到4: " << argv[i] << std::endl;
+                return -1;
+            }
+        } else if (std::strcmp(argv[i], "--scale-bench") == 0 && i + 1 < argc) {
+            scale_bench_frames = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--frame-threads") == 0 && i + 1 < argc) {
+            settings.frame_threads = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--parallel-bench") == 0 && i + 1 < argc) {
+            parallel_bench_frames = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--bitmap") == 0) {
+            settings.bitmap = true;
+        } else if (std::strcmp(argv[i], "--bitmap-bench") == 0 && i + 1 < argc) {
+            bitmap_bench_frames = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--plot") == 0 && i + 1 < argc) {
+            const char* name = argv[++i];
+            if (std::strcmp(name, "spans") == 0) {
+                settings.plot = LaneDetector::PLOT_SPANS;
+            } else if (std::strcmp(name, "opencv") == 0) {
+                settings.plot = LaneDetector::PLOT_OPENCV;
+            } else {
+                std::cout << "未知绘制方式: " << name << std::endl;
+                return -1;
+            }
+        } else if (std::strcmp(argv[i], "--plot-bench") == 0 && i + 1 < argc) {
+            plot_bench_frames = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--live") == 0) {
+            live = true;
+        } else if (std::strcmp(argv[i], "--camera") == 0 && i + 1 < argc) {
+            live = true;
+            camera = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--budget") == 0 && i + 1 < argc) {
+            budget_ms = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--live-frames") == 0 && i + 1 < argc) {
+            live_frames = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--config") == 0 && i + 1 < argc) {
+            if (!settings.config.load(argv[++i])) {
+                std::cout << "无法读取配置文件: " << argv[i] << std::endl;
+                return -1;
+            }
+        } else if (std::strcmp(argv[i], "--gate") == 0 && i + 1 < argc) {
+            settings.config.gate_threshold = std::max(0.0, std::atof(argv[++i]));
+        } else if (std::strcmp(argv[i], "--gate-max") == 0 && i + 1 < argc) {
+            settings.config.gate_max_reuse = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--log") == 0 && i + 1 < argc) {
+            log_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--log-level") == 0 && i + 1 < argc) {
+            if (!Logger::parseLevel(argv[++i], log_level)) {
+                std::cout << "未知日志级别: " << argv[i] << std::endl;
+                return -1;
+            }
+        } else if (std::strcmp(argv[i], "--log-rate") == 0 && i + 1 < argc) {
+            log_rate = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--trace-events") == 0 && i + 1 < argc) {
+            trace_events = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+            serve_name = argv[++i];
+        } else if (std::strcmp(argv[i], "--serve-slots") == 0 && i + 1 < argc) {
+            serve_slots = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--serve-max") == 0 && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%dx%d", &serve_max.width, &serve_max.height) != 2 ||
+                serve_max.width < 3 || serve_max.height < 2) {
+                std::cout << "帧尺寸格式须为 宽x高: " << argv[i] << std::endl;
+                return -1;
+            }
+        } else {
+            std::cout << "未知参数: " << argv[i] << std::endl;
+            return -1;
+        }
+    }
+
+    // 输出选择：两路视频与车道线数据相互独立，只输出数据时不绘制也不编码
+    if (!record_path.empty()) {
+        outputs.records = true;
+        if (!RecordWriter::formatFromPath(record_path, outputs.record_format)) {
+            std::cout << "未知数据格式(支持 .csv .ndjson .bin): " << record_path << std::endl;
+            return -1;
+        }
+    } else if (outputs.records) {
+        record_path = std::string("lane_records") + RecordWriter::extension(outputs.record_format);
+    }
+    outputs.applyTo(detect_options);
+
+    if (!manifest_path.empty() && !readManifest(manifest_path, inputs)) {
+        std::cout << "无法读取输入清单: " << manifest_path << std::endl;
         return -1;
+    }
+
+    // 多路视频：共享线程池并发处理，每路独立的检测器和输出文件
+    if (inputs.size() > 1 || !manifest_path.empty()) {
+        BatchRunner batch(settings, detect_options, outputs, batch_threads, output_dir);
+        std::cout << "批处理 " << inputs.size() << " 路视频, 输出目录: " << output_dir << std::endl;
+        int failed = batch.run(inputs);
+        batch.printReport();
+        if (!batch_csv_path.empty() && !batch.writeCsv(batch_csv_path))
+            std::cout << "无法写入批处理数据: " << batch_csv_path << std::endl;
+        return failed;
+    }
+
+    // 单个长视频按关键帧分段，多线程各自解码检测后按帧序拼接结果
+    if (chunk_count >= 0) {
+        std::string input = inputs.empty() ? "video_challenge.mp4" : inputs[0];
+        if (FrameSource::isRaw(input)) {
+            std::cout << "分段模式需要可定位的视频文件: " << input << std::endl;
+            return -1;
+        }
+        if (outputs.color_video || outputs.edge_video)
+            std::cout << "分段模式只输出车道线数据, 不生成视频" << std::endl;
+        ChunkRunner chunked(settings, batch_threads, chunk_count, chunk_warmup);
+        std::cout << "分段处理: " << input << std::endl;
+        bool ok = chunked.run(input);
+        chunked.printReport();
+        if (outputs.records) {
+            RecordWriter writer;
+            if (!writer.open(record_path, outputs.record_format)) {
+                std::cout << "无法创建车道线数据文件: " << record_path << std::endl;
+                return -1;
+            }
+            for (const LaneRecord& r : chunked.records())
+                writer.write(r);
+            writer.close();
+            std::cout << "车道线数据文件: " << record_path << " (" << writer.records() << " 条记录)" << std::endl;
+        }
+        if (!ok)
+            return -1;
+        return chunk_check ? (chunked.compareSequential(input) == 0 ? 0 : 1) : 0;
+    }
+
+    settings.apply(lanedetector);
+
+    // 常驻检测服务：帧由其他进程写入共享内存，结果经第二个环形缓冲区返回
+    if (!serve_name.empty()) {
+        LaneService service(lanedetector, detect_options, serve_name, serve_slots, serve_max);
+        if (!service.open()) {
+            std::cout << "无法创建共享内存: " << LaneService::frameRingName(serve_name) << std::endl;
+            return -1;
+        }
+        LaneService::installSignalHandlers();
+        if (!trace_path.empty())
+            Tracer::start(trace_events);
+        std::cout << "检测服务已启动: " << LaneService::frameRingName(serve_name) << " -> "
+                  << LaneService::resultRingName(serve_name) << " (Ctrl+C 停止)" << std::endl;
+        service.run();
+        service.printReport();
+        if (!trace_path.empty()) {
+            Tracer::stop();
+            if (Tracer::writeChromeTrace(trace_path))
+                std::cout << "追踪文件: " << trace_path << " (覆盖 " << Tracer::overwritten() << " 个事件, 未登记线程丢弃 "
+                          << Tracer::dropped() << " 个)" << std::endl;
+            else
+                std::cout << "无法写入追踪文件: " << trace_path << std::endl;
+        }
+        return 0;
+    }
+
+    // 打开测试视频文件或摄像头
+    std::string input = inputs.empty() ? "video_challenge.mp4" : inputs[0];
+    if (!y4m_path.empty()) {
+        int converted = FrameSource::convertToY4m(input, y4m_path, y4m_frames);
+        if (converted < 0) {
+            std::cout << "无法转换为Y4M: " << input << " -> " << y4m_path << std::endl;
+            return -1;
+        }
+        std::cout << "已转换 " << converted << " 帧: " << y4m_path << std::endl;
+        return 0;
+    }
+    if (!store_path.empty()) {
+        // 裁剪时保留车道ROI及其上方一行（模糊核的邻域）
+        int band_top = 0;
+        if (store_crop) {
+            FrameSource probe;
+            if (!probe.open(input)) {
+                std::cout << "无法打开输入视频: " << input << std::endl;
+                return -1;
+            }
+            band_top = std::max(0, lanedetector.laneBounds(probe.size()).y - 1);
+        }
+        int converted = FrameStore::convert(input, store_path, store_bgr ? 3 : 1, band_top, store_frames);
+        if (converted < 0) {
+            std::cout << "无法创建帧存储: " << input << " -> " << store_path << std::endl;
+            return -1;
+        }
+        std::cout << "已转换 " << converted << " 帧 (" << (store_bgr ? "BGR" : "Y") << ", 起始行 " << band_top
+                  << "): " << store_path << std::endl;
+        return 0;
+    }
+
+    // YUV输入与帧存储：检测直接使用解码器的Y平面或映射的帧，仅逐帧主循环支持
+    FrameSource source;
+    bool raw_input = camera < 0 && FrameSource::isRaw(input);
+    cv::VideoCapture cap;
+    if (raw_input) {
+        if (live || use_pipeline || verify_edge_frames > 0 || hough_bench_frames > 0 || alloc_check_frames > 0 ||
+            scale_bench_frames > 0 || parallel_bench_frames > 0 || bitmap_bench_frames > 0 || plot_bench_frames > 0) {
+            std::cout << "YUV输入与帧存储仅支持逐帧主循环与批处理: " << input << std::endl;
+            return -1;
+        }
+        if (!source.open(input))
+            return -1;
+        if (!adaptToSource(lanedetector, source)) {
+            std::cout << "帧存储的裁剪区域不包含当前配置的车道ROI: " << input << std::endl;
+            return -1;
+        }
+    } else if (camera >= 0) {
+        input = "camera " + std::to_string(camera);
+        cap.open(camera);
+    } else {
+        cap.open(input);
+    }
+    if (!raw_input && !cap.isOpened())
+        return -1;
+
+    if (verify_edge_frames > 0)
+        return verifyEdgeKernel(cap, verify_edge_frames);
+    if (hough_bench_frames > 0)
+        return benchHough(cap, detect_options, lanedetector.roiMode(), hough_bench_frames);
+    if (alloc_check_frames > 0)
+        return checkAllocations(cap, lanedetector, detect_options, alloc_check_frames);
+    if (scale_bench_frames > 0)
+        return benchScale(cap, settings, detect_options, scale_bench_frames);
+    if (parallel_bench_frames > 0)
+        return benchParallel(cap, settings, parallel_bench_frames);
+    if (bitmap_bench_frames > 0)
+        return benchBitmap(cap, settings, bitmap_bench_frames);
+    if (plot_bench_frames > 0)
+        return benchPlot(cap, settings, plot_bench_frames);
 
     // 获取视频属性
-    int frame_width = cap.get(cv::CAP_PROP_FRAME_WIDTH);
-    int frame_height = cap.get(cv::CAP_PROP_FRAME_HEIGHT);
-    double fps = cap.get(cv::CAP_PROP_FPS);
+    int frame_width = raw_input ? source.size().width : static_cast<int>(cap.get(cv::CAP_PROP_FRAME_WIDTH));
+    int frame_height = raw_input ? source.size().height : static_cast<int>(cap.get(cv::CAP_PROP_FRAME_HEIGHT));
+    double fps = raw_input ? source.fps() : cap.get(cv::CAP_PROP_FPS);
+    if (fps <= 0)
+        fps = 30.0;     // 部分摄像头不报告帧率
+    if (live && budget_ms <= 0)
+        budget_ms = 1000.0 / fps;
     
     // 创建彩色视频写入器（车道线检测结果）
-    cv::VideoWriter color_video_writer("output_lane_detection_color.avi", 
-                                      cv::VideoWriter::fourcc('M','J','P','G'), 
-                                      fps, 
-                                      cv::Size(frame_width, frame_height));
-
-    // 创建黑白视频写入器（边缘检测结果）
-    cv::VideoWriter bw_video_writer("output_edge_detection_bw.avi", 
-                                   cv::VideoWriter::fourcc('M','J','P','G'), 
-                                   fps, 
-                                   cv::Size(frame_width, frame_height));
-
-    if (!color_video_writer.isOpened()) {
+    cv::VideoWriter color_video_writer;
+    if (outputs.color_video &&
+        !color_video_writer.open("output_lane_detection_color.avi", cv::VideoWriter::fourcc('M','J','P','G'),
+                                 fps, cv::Size(frame_width, frame_height))) {
         std::cout << "无法创建彩色输出视频文件" << std::endl;
         return -1;
     }
 
-    if (!bw_video_writer.isOpened()) {
+    // 创建黑白视频写入器（边缘检测结果）
+    cv::VideoWriter bw_video_writer;
+    if (outputs.edge_video &&
+        !bw_video_writer.open("output_edge_detection_bw.avi", cv::VideoWriter::fourcc('M','J','P','G'),
+                              fps, cv::Size(frame_width, frame_height))) {
         std::cout << "无法创建黑白输出视频文件" << std::endl;
         return -1;
     }
 
-    std::cout << "开始处理视频..." << std::endl;
-    std::cout << "彩色输出文件: output_lane_detection_color.avi" << std::endl;
-    std::cout << "黑白输出文件: output_edge_detection_bw.avi" << std::endl;
-    std::cout << "视频信息: " << frame_width << "x" << frame_height << ", " << fps << "fps" << std::endl;
-
-    // 记录总开始时间
-    total_start_time = std::chrono::high_resolution_clock::now();
+    // 车道线数据文件（每帧一条记录）
+    RecordWriter record_writer;
+    LaneRecord record;
+    if (outputs.records && !record_writer.open(record_path, outputs.record_format)) {
+        std::cout << "无法创建车道线数据文件: " << record_path << std::endl;
+        return -1;
+    }
 
-    // 车道线检测算法主循环
-    while (1) 
-    {
-        // 读入一帧图像，不成功则退出
-        if (!cap.read(frame))
-            break;
+    std::cout << "开始处理视频: " << input << std::endl;
+    if (outputs.color_video)
+        std::cout << "彩色输出文件: output_lane_detection_color.avi" << std::endl;
+    if (outputs.edge_video)
+        std::cout << "黑白输出文件: output_edge_detection_bw.avi" << std::endl;
+    if (outputs.records)
+        std::cout << "车道线数据文件: " << record_path << std::endl;
+    std::cout << "视频信息: " << frame_width << "x" << frame_height << ", " << fps << "fps" << std::endl;
+    if (raw_input)
+        std::cout << "输入格式: " << FrameSource::layoutName(source.layout()) << " (检测直接使用输入缓冲区)" << std::endl;
+    cv::Rect roi = lanedetector.roi(cv::Size(frame_width, frame_height));
+    std::cout << "处理区域: " << roi.width << "x" << roi.height << "+" << roi.x << "+" << roi.y << std::endl;
+    std::cout << "边缘检测: " << (detect_options.legacy_edge ? "legacy" : FusedEdgeKernel::isaName(lanedetector.edgeKernel().isa())) << std::endl;
+    std::cout << "Hough变换: " << LaneDetector::houghModeName(lanedetector.houghMode()) << std::endl;
+    std::cout << "直线拟合: " << LaneDetector::fitModeName(lanedetector.fitMode()) << std::endl;
+    std::cout << "车道线绘制: " << LaneDetector::plotModeName(lanedetector.plotMode()) << std::endl;
+    std::cout << "跟踪模式: " << (lanedetector.trackingMode() ? "开启" : "关闭") << std::endl;
+    std::cout << "检测尺度: 1/" << lanedetector.scale() << std::endl;
+    if (lanedetector.frameThreads() > 0)
+        std::cout << "帧内并行: " << lanedetector.frameThreads() << " 线程" << std::endl;
+    if (lanedetector.bitmapMode())
+        std::cout << "边缘表示: 1位位图" << std::endl;
+    if (live)
+        std::cout << "实时模式: 每帧预算 " << budget_ms << " ms" << std::endl;
 
-        // 采用Gaussian滤波器去噪声
-        img_denoise = lanedetector.deNoise(frame);
+    // 逐帧结果由后台线程写出，检测线程只写入无锁环形缓冲区
+    Logger logger;
+    logger.setLevel(log_level);
+    logger.setRateLimit(log_rate);
+    if (!logger.start(log_path)) {
+        std::cout << "无法创建日志文件: " << log_path << std::endl;
+        return -1;
+    }
+    if (log_path != "-")
+        std::cout << "日志文件: " << log_path << std::endl;
 
-        // 边缘检测
-        img_edges = lanedetector.edgeDetector(img_denoise);
+    // 逐帧事件追踪：各线程写入自己的环形缓冲区，结束后导出
+    if (!trace_path.empty())
+        Tracer::start(trace_events);
+    Tracer::setThreadName("main");
 
-        // 裁剪图像以获取ROI
-        img_mask = lanedetector.mask(img_edges);
+    // 记录总开始时间
+    total_start_time = std::chrono::high_resolution_clock::now();
 
-        // 将边缘检测结果转换为3通道以便写入视频
-        cv::Mat edge_3channel;
-        cv::cvtColor(img_mask, edge_3channel, cv::COLOR_GRAY2BGR);
+    if (live) {
+        // 始终处理最新一帧，超出预算时逐级降级
+        RealtimeRunner realtime(lanedetector, detect_options, budget_ms);
+        if (outputs.records)
+            realtime.setRecordWriter(&record_writer, fps);
+        total_frames_processed = realtime.run(cap, camera >= 0 ? 0.0 : fps, live_frames,
+                                              color_video_writer, bw_video_writer, flag_plot);
+        realtime.printReport();
+    } else if (use_pipeline) {
+        // 解码、检测、两路编码分线程流水处理
+        FramePipeline pipeline(lanedetector, detect_options, queue_depth);
+        if (outputs.records)
+            pipeline.setRecordWriter(&record_writer, fps);
+        pipeline.setLogger(&logger);
+        total_frames_processed = pipeline.run(cap, color_video_writer, bw_video_writer, flag_plot);
+        logger.stop();
+        pipeline.printReport();
+    } else {
+        // 车道线检测算法主循环
+        while (1) 
+        {
+            // 读入一帧图像，不成功则退出
+            Tracer::setFrame(total_frames_processed);
+            bool frame_read;
+            {
+                TraceScope trace("decode");
+                frame_read = raw_input ? source.read() : cap.read(frame);
+            }
+            if (!frame_read)
+                break;
 
-        // 写入黑白边缘检测视频
-        bw_video_writer.write(edge_3channel);
+            // 去噪、边缘检测、ROI、Hough、回归、转向预测与绘制
+            auto detect_start = std::chrono::high_resolution_clock::now();
+            {
+                TraceScope trace("detect");
+                if (raw_input)
+                    flag_plot = detectFrame(lanedetector, source, detect_options, frame, edge_frame, edge_3channel, turn);
+                else
+                    flag_plot = detectFrame(lanedetector, frame, detect_options, edge_frame, edge_3channel, turn);
+            }
+            double detect_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - detect_start).count();
+            if (lanedetector.changeGate().lastHit())
+                gate_hit_ms += detect_ms;
+            else
+                gate_full_ms += detect_ms;
 
-        // 在ROI区域通过Hough变换得到Hough线
-        lines = lanedetector.houghLines(img_mask);
+            // 写入黑白边缘检测视频
+            if (outputs.edge_video) {
+                TraceScope trace("encode edge");
+                bw_video_writer.write(edge_3channel);
+            }
 
-        if (!lines.empty())
-        {
-            // 分离左右车道线
-            left_right_lines = lanedetector.lineSeparation(lines, img_edges);
+            // 将处理后的彩色帧写入视频文件（未检测到车道线时写入原始彩色帧）
+            if (outputs.color_video) {
+                TraceScope trace("encode color");
+                color_video_writer.write(frame);
+            }
 
-            // 采用回归法获取单边车道线
-            lane = lanedetector.regression(left_right_lines, frame);
+            // 写入本帧车道线数据
+            if (outputs.records) {
+                makeLaneRecord(lanedetector, total_frames_processed, fps, flag_plot == 0, turn, record);
+                record_writer.write(record);
+            }
 
-            // 预测车道线是向左、向右还是直行
-            turn = lanedetector.predictTurn();
+            // 结构化逐帧记录，写出在后台线程完成
+            logger.frame(total_frames_processed, flag_plot == 0, flag_plot == 0 ? turn : std::string(), detect_ms);
 
-            // 在视频图上绘制车道线并写入彩色视频
-            flag_plot = lanedetector.plotLane(frame, lane, turn);
-            
-            // 将处理后的彩色帧写入视频文件
-            color_video_writer.write(frame);
-            
-            std::cout << "检测到车道线，转向预测: " << turn << std::endl;
+            total_frames_processed++;
         }
-        else 
-        {
-            flag_plot = -1;
-            // 即使没有检测到车道线，也要写入原始彩色帧
-            color_video_writer.write(frame);
-            std::cout << "未检测到车道线" << std::endl;
-        }
-
-        total_frames_processed++;
     }
 
     // 记录总结束时间
     total_end_time = std::chrono::high_resolution_clock::now();
+    Tracer::stop();
+
+    // 写完队列中剩余的日志后再输出报告
+    logger.stop();
     auto total_duration = std::chrono::duration_cast<std::chrono::microseconds>(total_end_time - total_start_time);
     total_processing_time = total_duration.count() / 1000.0; // 转换为毫秒
 
     // 释放资源
     cap.release();
+    source.release();
     color_video_writer.release();
     bw_video_writer.release();
+    record_writer.close();
     
     // 获取详细的性能统计信息
     double avg_denoise, avg_edge, avg_mask, avg_hough, avg_separation, avg_regression, avg_predict, avg_plot, avg_total;
@@ -184,10 +1257,60 @@ int main()
         std::cout << "- 绘制操作可考虑减少不必要的图形操作" << std::endl;
     }
     
+    if (lanedetector.trackingMode()) {
+        LaneTracker& tracker = lanedetector.tracker();
+        std::cout << "\n跟踪统计:" << std::endl;
+        std::cout << "├── 窄带检测帧: " << tracker.lockedFrames() << std::endl;
+        std::cout << "├── 全ROI检测帧: " << tracker.searchFrames() << std::endl;
+        std::cout << "└── 失锁次数: " << tracker.lockLosses() << std::endl;
+    }
+
+    const ChangeGate& gate = lanedetector.changeGate();
+    if (gate.enabled()) {
+        long full = gate.checks() - gate.hits();
+        std::cout << "\n变化检测门控 (阈值 " << lanedetector.configuration().gate_threshold << ", 最多连续复用 "
+                  << lanedetector.configuration().gate_max_reuse << " 帧):" << std::endl;
+        std::cout << "├── 复用帧: " << gate.hits() << "/" << gate.checks() << " (" << gate.hitRate() * 100 << "%)" << std::endl;
+        std::cout << "├── 最长连续复用: " << gate.longestReuse() << " 帧" << std::endl;
+        std::cout << "├── 门控判断: 平均 " << (gate.checks() > 0 ? gate.checkMs() * 1000.0 / gate.checks() : 0.0) << " us" << std::endl;
+        // 有效加速比：完整检测的平均耗时 / 全部帧的平均耗时（仅逐帧主循环统计检测耗时）
+        if (!live && !use_pipeline && full > 0 && gate_hit_ms + gate_full_ms > 0) {
+            double full_mean = gate_full_ms / full;
+            double all_mean = (gate_hit_ms + gate_full_ms) / gate.checks();
+            std::cout << "├── 检测耗时: 完整 " << full_mean << " ms, 复用 "
+                      << (gate.hits() > 0 ? gate_hit_ms / gate.hits() : 0.0) << " ms" << std::endl;
+            std::cout << "└── 有效加速比: " << full_mean / all_mean << "x" << std::endl;
+        } else {
+            std::cout << "└── 完整检测帧: " << full << std::endl;
+        }
+    }
+    
+    std::cout << "\n日志: 写入 " << logger.written() << " 条, 丢弃 " << logger.dropped()
+              << " 条, 限流 " << logger.suppressed() << " 条" << std::endl;
     std::cout << "==========================================" << std::endl;
+
+    // 机器可读的性能数据
+    const PerfStats& perf = lanedetector.performanceStats();
+    if (!perf_json_path.empty() && !perf.writeJson(perf_json_path, total_processing_time))
+        std::cout << "无法写入性能数据: " << perf_json_path << std::endl;
+    if (!perf_csv_path.empty() && !perf.writeCsv(perf_csv_path, total_processing_time))
+        std::cout << "无法写入性能数据: " << perf_csv_path << std::endl;
+
+    if (!trace_path.empty()) {
+        if (Tracer::writeChromeTrace(trace_path))
+            std::cout << "追踪文件: " << trace_path << " (覆盖 " << Tracer::overwritten() << " 个事件, 未登记线程丢弃 "
+                      << Tracer::dropped() << " 个)" << std::endl;
+        else
+            std::cout << "无法写入追踪文件: " << trace_path << std::endl;
+    }
+
     std::cout << "视频处理完成！" << std::endl;
-    std::cout << "彩色输出文件: output_lane_detection_color.avi" << std::endl;
-    std::cout << "黑白输出文件: output_edge_detection_bw.avi" << std::endl;
+    if (outputs.color_video)
+        std::cout << "彩色输出文件: output_lane_detection_color.avi" << std::endl;
+    if (outputs.edge_video)
+        std::cout << "黑白输出文件: output_edge_detection_bw.avi" << std::endl;
+    if (outputs.records)
+        std::cout << "车道线数据文件: " << record_path << " (" << record_writer.records() << " 条记录)" << std::endl;
 
     return flag_plot;
 }
\ No newline at end of file
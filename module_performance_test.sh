@@ -48,24 +48,25 @@ test_module_performance() {
     for i in $(seq 1 $TEST_ITERATIONS); do
         echo "  第 $i 次测试..."
         
-        # 运行程序
-        $TASKSET ./main > "$OUTPUT_DIR/${config_name}_test${i}.log" 2>&1
+        # 运行程序，性能数据以CSV输出（每个模块一行: stage,count,frames,total_ms,avg_per_frame_ms,...）
+        perf_csv="$OUTPUT_DIR/${config_name}_test${i}_perf.csv"
+        $TASKSET ./main --perf-csv "$perf_csv" > "$OUTPUT_DIR/${config_name}_test${i}.log" 2>&1
         
         # 提取模块时间数据
-        if [ -f "$OUTPUT_DIR/${config_name}_test${i}.log" ]; then
-            # 提取整机执行时间
-            total_time=$(grep "整机执行时间:" "$OUTPUT_DIR/${config_name}_test${i}.log" | awk '{print $2}')
-            total_frames=$(grep "总处理帧数:" "$OUTPUT_DIR/${config_name}_test${i}.log" | awk '{print $2}')
+        if [ -f "$perf_csv" ]; then
+            # 整机执行时间与总帧数来自 wall 行
+            total_time=$(awk -F',' '$1=="wall" {print $4}' "$perf_csv")
+            total_frames=$(awk -F',' '$1=="wall" {print $3}' "$perf_csv")
             
-            # 提取各模块执行时间（改进解析逻辑）
-            denoise_time=$(grep "图像去噪:" "$OUTPUT_DIR/${config_name}_test${i}.log" | head -1 | awk '{print $2}')
-            edge_time=$(grep "边缘检测:" "$OUTPUT_DIR/${config_name}_test${i}.log" | head -1 | awk '{print $2}')
-            mask_time=$(grep "掩码处理:" "$OUTPUT_DIR/${config_name}_test${i}.log" | head -1 | awk '{print $2}')
-            hough_time=$(grep "Hough变换:" "$OUTPUT_DIR/${config_name}_test${i}.log" | head -1 | awk '{print $2}')
-            separation_time=$(grep "线分离:" "$OUTPUT_DIR/${config_name}_test${i}.log" | head -1 | awk '{print $2}')
-            regression_time=$(grep "回归拟合:" "$OUTPUT_DIR/${config_name}_test${i}.log" | head -1 | awk '{print $2}')
-            predict_time=$(grep "转向预测:" "$OUTPUT_DIR/${config_name}_test${i}.log" | head -1 | awk '{print $2}')
-            plot_time=$(grep "结果绘制:" "$OUTPUT_DIR/${config_name}_test${i}.log" | head -1 | awk '{print $2}')
+            # 各模块平均每帧时间
+            denoise_time=$(awk -F',' '$1=="denoise" {print $5}' "$perf_csv")
+            edge_time=$(awk -F',' '$1=="edge" {print $5}' "$perf_csv")
+            mask_time=$(awk -F',' '$1=="mask" {print $5}' "$perf_csv")
+            hough_time=$(awk -F',' '$1=="hough" {print $5}' "$perf_csv")
+            separation_time=$(awk -F',' '$1=="separation" {print $5}' "$perf_csv")
+            regression_time=$(awk -F',' '$1=="regression" {print $5}' "$perf_csv")
+            predict_time=$(awk -F',' '$1=="predict" {print $5}' "$perf_csv")
+            plot_time=$(awk -F',' '$1=="plot" {print $5}' "$perf_csv")
             
             # 检查是否成功提取到数据
             if [ -z "$total_time" ] || [ -z "$total_frames" ]; then
@@ -181,6 +182,47 @@ test_module_performance "单核+NEON" 1 true
 test_module_performance "多核" 4 false
 test_module_performance "多核+NEON" 4 true
 
+# Hough实现对比（OpenCV HoughLinesP 与车道角度Hough引擎）
+echo "=========================================="
+echo "Hough实现对比"
+echo "=========================================="
+./main --hough-bench 300 > "$OUTPUT_DIR/hough_engine_comparison.log" 2>&1
+cat "$OUTPUT_DIR/hough_engine_comparison.log"
+./main --roi --hough-bench 300 > "$OUTPUT_DIR/hough_engine_comparison_roi.log" 2>&1
+cat "$OUTPUT_DIR/hough_engine_comparison_roi.log"
+
+# 帧内并行扩展性：同一帧按行分条在1-4个线程上处理，比较单帧延迟
+echo "=========================================="
+echo "帧内并行扩展性"
+echo "=========================================="
+./main --parallel-bench 300 > "$OUTPUT_DIR/frame_parallel_scaling.log" 2>&1
+cat "$OUTPUT_DIR/frame_parallel_scaling.log"
+
+# 边缘表示：字节图像+掩码图与1位位图+行区间掩码的存储与耗时
+echo "=========================================="
+echo "边缘位图对比"
+echo "=========================================="
+./main --bitmap-bench 300 > "$OUTPUT_DIR/edge_bitmap_comparison.log" 2>&1
+cat "$OUTPUT_DIR/edge_bitmap_comparison.log"
+
+# 车道线绘制：OpenCV整帧混合与行区间原地混合
+echo "=========================================="
+echo "车道线绘制对比"
+echo "=========================================="
+./main --plot-bench 300 > "$OUTPUT_DIR/plot_renderer_comparison.log" 2>&1
+cat "$OUTPUT_DIR/plot_renderer_comparison.log"
+
+# 逐阶段基准测试：帧预先读入内存，预热后重复计时，绑定单核（x86上用 make bench NATIVE=1 构建）
+echo "=========================================="
+echo "逐阶段基准测试"
+echo "=========================================="
+if make bench > /dev/null 2>&1; then
+    ./lane_bench --frames 60 --warmup 2 --reps 10 --cpu 0 --json "$OUTPUT_DIR/lane_bench.json" \
+        | tee "$OUTPUT_DIR/lane_bench.log"
+else
+    echo "lane_bench 编译失败"
+fi
+
 # 生成模块性能分析报告
 echo "=========================================="
 echo "模块性能分析报告"
@@ -50,7 +50,7 @@ run_performance_test() {
     start_time=$(date +%s.%N)
     
     # 运行程序并记录输出
-    $TASKSET ./main > "$OUTPUT_DIR/${config_name}_output.log" 2>&1
+    $TASKSET ./main --input "$VIDEO_FILE" > "$OUTPUT_DIR/${config_name}_output.log" 2>&1
     exit_code=$?
     
     # 记录结束时间